@@ -0,0 +1,57 @@
+#ifndef ALIGNED_ALLOCATOR_H
+#define ALIGNED_ALLOCATOR_H
+
+#include <cstddef>
+#include <new>
+
+/// <summary>
+/// Allocator returning memory aligned to the given boundary, so that
+/// contiguous numeric buffers start on a cache line / SIMD register boundary
+/// </summary>
+/// <typeparam name="T">Element type</typeparam>
+/// <typeparam name="Alignment">Alignment in bytes</typeparam>
+template <typename T, std::size_t Alignment = 64>
+class AlignedAllocator
+{
+public:
+	using value_type = T;
+
+	static_assert(Alignment >= alignof(T), "Alignment must not be weaker than the type alignment.");
+	static_assert((Alignment & (Alignment - 1)) == 0, "Alignment must be a power of two.");
+
+	template <typename U>
+	struct rebind
+	{
+		using other = AlignedAllocator<U, Alignment>;
+	};
+
+	AlignedAllocator() noexcept = default;
+
+	template <typename U>
+	AlignedAllocator(const AlignedAllocator<U, Alignment>&) noexcept {}
+
+	/// <summary>
+	/// Allocate aligned storage for n elements
+	/// </summary>
+	/// <param name="n">Number of elements</param>
+	/// <returns>Pointer to the storage</returns>
+	T* allocate(std::size_t n)
+	{
+		return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(Alignment)));
+	}
+
+	/// <summary>
+	/// Release storage obtained from allocate
+	/// </summary>
+	/// <param name="p">Pointer to the storage</param>
+	/// <param name="n">Number of elements</param>
+	void deallocate(T* p, std::size_t n) noexcept
+	{
+		::operator delete(p, n * sizeof(T), std::align_val_t(Alignment));
+	}
+
+	template <typename U>
+	bool operator==(const AlignedAllocator<U, Alignment>&) const noexcept { return true; }
+};
+
+#endif // !ALIGNED_ALLOCATOR_H
@@ -0,0 +1,173 @@
+#ifndef DATA_SOURCE_H
+#define DATA_SOURCE_H
+
+#include "dataset.h"
+#include "matrix_view.h"
+#include <fstream>
+#include <future>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Source of the rows of a matrix read in chunks, so that training can
+/// stream data larger than memory. Consumers announce the next chunk with
+/// prefetch while they work on the current one.
+/// </summary>
+/// <typeparam name="T">Scalar type, float or double</typeparam>
+template <typename T>
+class BasicDataSource
+{
+public:
+	virtual ~BasicDataSource() = default;
+
+	/// <summary>
+	/// Get the number of rows
+	/// </summary>
+	/// <returns>Number of rows</returns>
+	virtual size_t getNumOfRows() const = 0;
+
+	/// <summary>
+	/// Get the number of columns
+	/// </summary>
+	/// <returns>Number of columns</returns>
+	virtual size_t getNumOfCols() const = 0;
+
+	/// <summary>
+	/// Read a range of rows. The view stays valid until the next call to read.
+	/// </summary>
+	/// <param name="first">First row</param>
+	/// <param name="count">Number of rows</param>
+	/// <returns>View over the rows</returns>
+	virtual BasicMatrixView<T> read(size_t first, size_t count) = 0;
+
+	/// <summary>
+	/// Announce that a range of rows is read next, so it can be loaded in the background
+	/// </summary>
+	/// <param name="first">First row</param>
+	/// <param name="count">Number of rows</param>
+	virtual void prefetch(size_t /*first*/, size_t /*count*/) { }
+};
+
+/// <summary>
+/// Data source over a matrix view already in memory, read without copying
+/// </summary>
+/// <typeparam name="T">Scalar type, float or double</typeparam>
+template <typename T>
+class BasicViewSource : public BasicDataSource<T>
+{
+public:
+	/// <summary>
+	/// Constructor
+	/// </summary>
+	/// <param name="X">Rows, which must outlive the source</param>
+	explicit BasicViewSource(const BasicMatrixView<T>& X)
+		:m_view(X) { }
+
+	size_t getNumOfRows() const override { return m_view.getNumOfRows(); }
+	size_t getNumOfCols() const override { return m_view.getNumOfCols(); }
+	BasicMatrixView<T> read(size_t first, size_t count) override { return m_view.rows(first, count); }
+
+private:
+	// Rows
+	BasicMatrixView<T> m_view;
+};
+
+/// <summary>
+/// Data source over a memory-mapped dataset, read without copying. Prefetch
+/// asks the kernel to start loading the pages of the next chunk.
+/// </summary>
+/// <typeparam name="T">Scalar type, must match the stored data type</typeparam>
+template <typename T>
+class BasicMappedSource : public BasicDataSource<T>
+{
+public:
+	/// <summary>
+	/// Constructor
+	/// </summary>
+	/// <param name="dataset">Mapped dataset, which must outlive the source</param>
+	explicit BasicMappedSource(const MappedDataset& dataset)
+		:m_dataset(dataset), m_view(dataset.view<T>()) { }
+
+	size_t getNumOfRows() const override { return m_view.getNumOfRows(); }
+	size_t getNumOfCols() const override { return m_view.getNumOfCols(); }
+	BasicMatrixView<T> read(size_t first, size_t count) override { return m_view.rows(first, count); }
+	void prefetch(size_t first, size_t count) override { m_dataset.prefetch(first, count); }
+
+private:
+	// Mapped dataset
+	const MappedDataset& m_dataset;
+
+	// View over the whole matrix
+	BasicMatrixView<T> m_view;
+};
+
+/// <summary>
+/// Data source reading a dataset file with explicit reads into two chunk
+/// buffers, for files that should not be mapped. Prefetch reads the next
+/// chunk on a background thread into the buffer not in use, so the read
+/// overlaps the work on the current chunk, and the chunk is kept until it
+/// is read, even if other rows are read first. Memory is two chunks.
+/// </summary>
+/// <typeparam name="T">Scalar type, must match the stored data type</typeparam>
+template <typename T>
+class BasicFileSource : public BasicDataSource<T>
+{
+public:
+	/// <summary>
+	/// Constructor, opens the file and validates its header
+	/// </summary>
+	/// <param name="path">File path</param>
+	explicit BasicFileSource(const std::string& path);
+
+	BasicFileSource(const BasicFileSource&) = delete;
+	BasicFileSource& operator=(const BasicFileSource&) = delete;
+
+	/// <summary>
+	/// Destructor, waits for a pending prefetch
+	/// </summary>
+	~BasicFileSource() override;
+
+	size_t getNumOfRows() const override { return m_header.numRows; }
+	size_t getNumOfCols() const override { return m_header.numCols; }
+	BasicMatrixView<T> read(size_t first, size_t count) override;
+	void prefetch(size_t first, size_t count) override;
+
+private:
+	/// <summary>
+	/// Read a range of rows into a buffer
+	/// </summary>
+	void load(size_t first, size_t count, std::vector<T>& buffer);
+
+	// Input file
+	std::ifstream m_file;
+
+	// Header read from the file
+	DatasetHeader m_header;
+
+	// Buffer of the chunk last returned by read
+	std::vector<T> m_current;
+
+	// Buffer of the prefetched chunk
+	std::vector<T> m_next;
+
+	// Range of the prefetched chunk, m_nextCount is zero when there is none
+	size_t m_nextFirst;
+	size_t m_nextCount;
+
+	// Background read of the prefetched chunk
+	std::future<void> m_pending;
+};
+
+extern template class BasicFileSource<float>;
+extern template class BasicFileSource<double>;
+
+using DataSource = BasicDataSource<double>;
+using DataSourceF = BasicDataSource<float>;
+using ViewSource = BasicViewSource<double>;
+using ViewSourceF = BasicViewSource<float>;
+using MappedSource = BasicMappedSource<double>;
+using MappedSourceF = BasicMappedSource<float>;
+using FileSource = BasicFileSource<double>;
+using FileSourceF = BasicFileSource<float>;
+
+#endif // !DATA_SOURCE_H
@@ -0,0 +1,277 @@
+#ifndef DATASET_H
+#define DATASET_H
+
+#include "matrix_view.h"
+#include <cstdint>
+#include <fstream>
+#include <span>
+#include <stdexcept>
+#include <string>
+
+/// <summary>
+/// Scalar type of the elements stored in a dataset file
+/// </summary>
+enum class DataType : uint32_t
+{
+	Float32 = 1,
+	Float64 = 2
+};
+
+/// <summary>
+/// Data type tag of a scalar type
+/// </summary>
+template <typename T>
+constexpr DataType dataTypeOf();
+
+template <>
+constexpr DataType dataTypeOf<float>() { return DataType::Float32; }
+
+template <>
+constexpr DataType dataTypeOf<double>() { return DataType::Float64; }
+
+/// <summary>
+/// How a mapped dataset is read, advice for the paging of the system
+/// </summary>
+enum class DatasetAccess
+{
+	// Pages stay cached for later passes and random reads, as for several
+	// epochs, shuffled chunks or sampled rows
+	Normal,
+
+	// A single front-to-back pass: read ahead aggressively and drop the
+	// pages behind the reader
+	Sequential
+};
+
+/// <summary>
+/// Header at the start of a dataset file. The file holds one row-major matrix
+/// of numRows x numCols elements of dataType, in the byte order of the
+/// machine that wrote it, recorded by byteOrder; files are only read on
+/// machines of the same byte order. Row i starts stride elements after row
+/// i - 1, and the first row starts dataOffset bytes into the file, a multiple
+/// of alignment, so the elements of a mapped file are aligned for SIMD loads.
+/// </summary>
+struct DatasetHeader
+{
+	// File signature, "MLDATA" followed by two zero bytes
+	char magic[8];
+
+	// Format version
+	uint32_t version;
+
+	// Scalar type of the elements
+	DataType dataType;
+
+	// Number of rows
+	uint64_t numRows;
+
+	// Number of columns
+	uint64_t numCols;
+
+	// Distance between the starts of consecutive rows, in elements
+	uint64_t stride;
+
+	// Alignment of the first element, in bytes
+	uint64_t alignment;
+
+	// Offset of the first element from the start of the file, in bytes
+	uint64_t dataOffset;
+
+	// DatasetByteOrderMark written in the byte order of the file
+	uint32_t byteOrder;
+
+	// Reserved for later versions, zero
+	uint32_t reserved;
+};
+
+static_assert(sizeof(DatasetHeader) == 64, "Dataset header must be 64 bytes.");
+
+/// <summary>
+/// Current version of the dataset format. Version 1 files have no byte order
+/// mark and are little-endian.
+/// </summary>
+constexpr uint32_t DatasetVersion = 2;
+
+/// <summary>
+/// Byte order mark of the header, read back byte-swapped on a machine of the
+/// other byte order
+/// </summary>
+constexpr uint32_t DatasetByteOrderMark = 0x01020304;
+
+/// <summary>
+/// Check a dataset header read from a file, throws std::runtime_error when it
+/// is not a supported dataset, was written in another byte order, or the rows
+/// do not fit in the file
+/// </summary>
+/// <param name="header">Header</param>
+/// <param name="fileSize">Size of the file in bytes</param>
+/// <param name="path">File path, for the error message</param>
+void validateDatasetHeader(const DatasetHeader& header, uint64_t fileSize, const std::string& path);
+
+/// <summary>
+/// Writes a dataset file row by row, so that datasets larger than memory can
+/// be converted in a single pass. The number of rows is written to the header
+/// when the writer is closed.
+/// </summary>
+/// <typeparam name="T">Scalar type, float or double</typeparam>
+template <typename T>
+class BasicDatasetWriter
+{
+public:
+	/// <summary>
+	/// Constructor, creates or truncates the file
+	/// </summary>
+	/// <param name="path">File path</param>
+	/// <param name="numCols">Number of columns</param>
+	/// <param name="alignment">Alignment of the first element in bytes, a power of two</param>
+	BasicDatasetWriter(const std::string& path, size_t numCols, size_t alignment = 64);
+
+	BasicDatasetWriter(const BasicDatasetWriter&) = delete;
+	BasicDatasetWriter& operator=(const BasicDatasetWriter&) = delete;
+
+	/// <summary>
+	/// Destructor, closes the file if close was not called
+	/// </summary>
+	~BasicDatasetWriter();
+
+	/// <summary>
+	/// Append a row
+	/// </summary>
+	/// <param name="row">Row, numCols elements</param>
+	void append(std::span<const T> row);
+
+	/// <summary>
+	/// Append all rows of a matrix
+	/// </summary>
+	/// <param name="rows">Rows, numCols columns</param>
+	void append(const BasicMatrixView<T>& rows);
+
+	/// <summary>
+	/// Write the final header and close the file
+	/// </summary>
+	void close();
+
+	/// <summary>
+	/// Get the number of rows written so far
+	/// </summary>
+	/// <returns>Number of rows</returns>
+	inline size_t getNumOfRows() const { return m_numRows; }
+
+private:
+	// Output file
+	std::ofstream m_file;
+
+	// Header, completed on close
+	DatasetHeader m_header;
+
+	// Number of rows written
+	size_t m_numRows;
+};
+
+/// <summary>
+/// Write a matrix to a dataset file
+/// </summary>
+/// <param name="path">File path</param>
+/// <param name="X">Matrix to write</param>
+/// <param name="alignment">Alignment of the first element in bytes, a power of two</param>
+template <typename T>
+void writeDataset(const std::string& path, const BasicMatrixView<T>& X, size_t alignment = 64);
+
+/// <summary>
+/// Read-only memory mapping of a dataset file. The elements are used in place
+/// through matrix views, so nothing is parsed or copied, pages are loaded on
+/// first access, and processes mapping the same file share the page cache.
+/// Views stay valid while the dataset is alive.
+/// </summary>
+class MappedDataset
+{
+public:
+	/// <summary>
+	/// Constructor, maps the file and validates its header
+	/// </summary>
+	/// <param name="path">File path</param>
+	/// <param name="access">How the rows are read, advice for the paging</param>
+	explicit MappedDataset(const std::string& path, DatasetAccess access = DatasetAccess::Normal);
+
+	MappedDataset(const MappedDataset&) = delete;
+	MappedDataset& operator=(const MappedDataset&) = delete;
+
+	MappedDataset(MappedDataset&& other) noexcept;
+	MappedDataset& operator=(MappedDataset&& other) noexcept;
+
+	/// <summary>
+	/// Destructor, unmaps the file
+	/// </summary>
+	~MappedDataset();
+
+	/// <summary>
+	/// Get a read-only view of the whole matrix
+	/// </summary>
+	/// <typeparam name="T">Scalar type, must match the stored data type</typeparam>
+	/// <returns>Matrix view over the mapped elements</returns>
+	template <typename T>
+	BasicMatrixView<T> view() const
+	{
+		if (m_header.dataType != dataTypeOf<T>())
+		{
+			throw std::invalid_argument("Requested scalar type does not match the dataset.");
+		}
+
+		return BasicMatrixView<T>(reinterpret_cast<const T*>(m_data + m_header.dataOffset),
+			m_header.numRows, m_header.numCols, m_header.stride);
+	}
+
+	/// <summary>
+	/// Ask the system to start loading a range of rows in the background
+	/// </summary>
+	/// <param name="first">First row</param>
+	/// <param name="count">Number of rows</param>
+	void prefetch(size_t first, size_t count) const;
+
+	/// <summary>
+	/// Get the number of rows
+	/// </summary>
+	/// <returns>Number of rows</returns>
+	inline size_t getNumOfRows() const { return m_header.numRows; }
+
+	/// <summary>
+	/// Get the number of columns
+	/// </summary>
+	/// <returns>Number of columns</returns>
+	inline size_t getNumOfCols() const { return m_header.numCols; }
+
+	/// <summary>
+	/// Get the scalar type of the elements
+	/// </summary>
+	/// <returns>Data type</returns>
+	inline DataType getDataType() const { return m_header.dataType; }
+
+private:
+	/// <summary>
+	/// Unmap the file and release the handles
+	/// </summary>
+	void release();
+
+	// Start of the mapping
+	const char* m_data;
+
+	// Size of the mapping in bytes
+	size_t m_size;
+
+	// Header copied from the file
+	DatasetHeader m_header;
+
+#ifdef _WIN32
+	// File and mapping handles
+	void* m_file;
+	void* m_mapping;
+#endif
+};
+
+extern template class BasicDatasetWriter<float>;
+extern template class BasicDatasetWriter<double>;
+
+using DatasetWriter = BasicDatasetWriter<double>;
+using DatasetWriterF = BasicDatasetWriter<float>;
+
+#endif // !DATASET_H
@@ -0,0 +1,140 @@
+#ifndef DISTANCE_H
+#define DISTANCE_H
+
+#include "matrix_view.h"
+#include <cmath>
+#include <cstddef>
+#include <span>
+#include <stdexcept>
+
+/// <summary>
+/// Squared Euclidean distance between two vectors of n elements. Uses
+/// AVX-512 or AVX2/FMA when the CPU supports them.
+/// Instantiated for float and double.
+/// </summary>
+/// <param name="a">Pointer to vector a</param>
+/// <param name="b">Pointer to vector b</param>
+/// <param name="n">Number of elements</param>
+/// <returns>Squared distance</returns>
+template <typename T>
+T squaredEuclideanDistance(const T* a, const T* b, size_t n);
+
+/// <summary>
+/// Cosine distance, one minus the cosine similarity, between two vectors of
+/// n elements. The distance is one when either vector is zero. Uses AVX-512
+/// or AVX2/FMA when the CPU supports them.
+/// Instantiated for float and double.
+/// </summary>
+/// <param name="a">Pointer to vector a</param>
+/// <param name="b">Pointer to vector b</param>
+/// <param name="n">Number of elements</param>
+/// <returns>Cosine distance, in [0, 2]</returns>
+template <typename T>
+T cosineDistance(const T* a, const T* b, size_t n);
+
+/// <summary>
+/// Squared Euclidean distance between two vectors of a dimension known at
+/// compile time, fully unrolled by the compiler
+/// </summary>
+/// <typeparam name="D">Number of elements</typeparam>
+/// <param name="a">Pointer to vector a</param>
+/// <param name="b">Pointer to vector b</param>
+/// <returns>Squared distance</returns>
+template <size_t D, typename T>
+inline T squaredEuclideanDistance(const T* a, const T* b)
+{
+	T sum = T(0);
+	for (size_t j = 0; j < D; ++j)
+	{
+		const T diff = a[j] - b[j];
+		sum += diff * diff;
+	}
+	return sum;
+}
+
+/// <summary>
+/// Squared Euclidean distance between two points
+/// </summary>
+/// <param name="a">Point a</param>
+/// <param name="b">Point b</param>
+/// <returns>Squared distance</returns>
+template <typename T>
+inline T squaredEuclideanDistance(std::span<const T> a, std::span<const T> b)
+{
+	if (a.size() != b.size())
+	{
+		throw std::invalid_argument("Points must be of the same size.");
+	}
+	return squaredEuclideanDistance(a.data(), b.data(), a.size());
+}
+
+/// <summary>
+/// Euclidean distance between two points
+/// </summary>
+/// <param name="a">Point a</param>
+/// <param name="b">Point b</param>
+/// <returns>Euclidean distance</returns>
+template <typename T>
+inline T euclideanDistance(std::span<const T> a, std::span<const T> b)
+{
+	return std::sqrt(squaredEuclideanDistance(a, b));
+}
+
+/// <summary>
+/// Cosine distance between two points
+/// </summary>
+/// <param name="a">Point a</param>
+/// <param name="b">Point b</param>
+/// <returns>Cosine distance</returns>
+template <typename T>
+inline T cosineDistance(std::span<const T> a, std::span<const T> b)
+{
+	if (a.size() != b.size())
+	{
+		throw std::invalid_argument("Points must be of the same size.");
+	}
+	return cosineDistance(a.data(), b.data(), a.size());
+}
+
+/// <summary>
+/// Squared Euclidean distance function, ignoring its element count argument
+/// when the dimension is fixed
+/// </summary>
+template <typename T>
+using SquaredDistanceFunction = T(*)(const T*, const T*, size_t);
+
+/// <summary>
+/// Squared Euclidean distance function for a dimension, the one nearestRow
+/// uses, so distances computed through it round exactly as nearestRow's.
+/// Instantiated for float and double.
+/// </summary>
+/// <param name="dim">Number of elements</param>
+/// <returns>Unrolled kernel for dimensions 2, 3, 4, 8 and 16, the SIMD kernel otherwise</returns>
+template <typename T>
+SquaredDistanceFunction<T> squaredDistanceFunction(size_t dim);
+
+/// <summary>
+/// Index of the row closest to a point in squared Euclidean distance, the
+/// first one on ties. Dimensions 2, 3, 4, 8 and 16 use the unrolled
+/// fixed-size kernel, others the SIMD kernel. No square roots are taken.
+/// Instantiated for float and double.
+/// </summary>
+/// <param name="x">Point, one element per column of rows</param>
+/// <param name="rows">Candidate rows, at least one</param>
+/// <param name="squaredDistance">If not null, receives the squared distance to the closest row</param>
+/// <returns>Index of the closest row</returns>
+template <typename T>
+size_t nearestRow(std::span<const T> x, const BasicMatrixView<T>& rows, T* squaredDistance = nullptr);
+
+/// <summary>
+/// Index of the smallest of n values, the first one on ties. Uses AVX-512 or
+/// AVX2 when the CPU supports them. Values must not be NaN.
+/// Instantiated for float and double.
+/// </summary>
+/// <param name="values">Pointer to the values</param>
+/// <param name="n">Number of values, at least one</param>
+/// <returns>Index of the smallest value</returns>
+template <typename T>
+size_t argmin(const T* values, size_t n);
+
+#endif // !DISTANCE_H
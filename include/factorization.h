@@ -0,0 +1,146 @@
+#ifndef FACTORIZATION_H
+#define FACTORIZATION_H
+
+#include "matrix.h"
+#include <vector>
+
+/// <summary>
+/// Cholesky factorization A = L L^T of a symmetric positive definite matrix.
+/// The factor is computed in place in the stored matrix by a blocked,
+/// right-looking algorithm, and only the lower triangle of A is read.
+/// </summary>
+/// <typeparam name="T">Scalar type</typeparam>
+template <typename T>
+class BasicCholeskyFactorization
+{
+public:
+	/// <summary>
+	/// Constructor, factorizes the matrix
+	/// </summary>
+	/// <param name="A">Symmetric positive definite matrix</param>
+	explicit BasicCholeskyFactorization(BasicMatrix<T> A);
+
+	/// <summary>
+	/// Solve A x = b
+	/// </summary>
+	/// <param name="b">Right hand side</param>
+	/// <returns>Solution x</returns>
+	std::vector<T> solve(const std::vector<T>& b) const;
+
+	/// <summary>
+	/// Get the lower triangular factor
+	/// </summary>
+	/// <returns>L, with zeros above the diagonal</returns>
+	const BasicMatrix<T>& getL() const { return m_factor; }
+
+private:
+	// Lower triangular factor
+	BasicMatrix<T> m_factor;
+};
+
+/// <summary>
+/// Householder QR factorization A = Q R of an m x n matrix with m >= n.
+/// R is stored in the upper triangle and the Householder vectors below it,
+/// so Q is never formed.
+/// </summary>
+/// <typeparam name="T">Scalar type</typeparam>
+template <typename T>
+class BasicQRFactorization
+{
+public:
+	/// <summary>
+	/// Constructor, factorizes the matrix
+	/// </summary>
+	/// <param name="A">Matrix with at least as many rows as columns</param>
+	explicit BasicQRFactorization(BasicMatrix<T> A);
+
+	/// <summary>
+	/// Least squares solution of A x = b, minimising ||A x - b||
+	/// </summary>
+	/// <param name="b">Right hand side, one element per row of A</param>
+	/// <returns>Solution x, one element per column of A</returns>
+	std::vector<T> solve(const std::vector<T>& b) const;
+
+	/// <summary>
+	/// Get the upper triangular factor
+	/// </summary>
+	/// <returns>R, n x n</returns>
+	BasicMatrix<T> getR() const;
+
+private:
+	// R above and on the diagonal, Householder vectors below it
+	BasicMatrix<T> m_factor;
+
+	// Householder scaling factors, one per column
+	std::vector<T> m_tau;
+};
+
+/// <summary>
+/// LU factorization P A = L U of a square matrix with partial (row) pivoting.
+/// L (unit diagonal) and U are stored together in place. The factorization
+/// is blocked and right-looking, with the trailing update done by the
+/// parallel GEMM, and can be reused for any number of solves.
+/// </summary>
+/// <typeparam name="T">Scalar type</typeparam>
+template <typename T>
+class BasicLUFactorization
+{
+public:
+	/// <summary>
+	/// Constructor, factorizes the matrix
+	/// </summary>
+	/// <param name="A">Square matrix</param>
+	explicit BasicLUFactorization(BasicMatrix<T> A);
+
+	/// <summary>
+	/// Solve A x = b
+	/// </summary>
+	/// <param name="b">Right hand side</param>
+	/// <returns>Solution x</returns>
+	std::vector<T> solve(const std::vector<T>& b) const;
+
+	/// <summary>
+	/// Solve A X = B for all columns of B at once
+	/// </summary>
+	/// <param name="B">Right hand sides, one per column</param>
+	/// <returns>Solutions, one per column</returns>
+	BasicMatrix<T> solve(const BasicMatrix<T>& B) const;
+
+	/// <summary>
+	/// Determinant of A
+	/// </summary>
+	/// <returns>Determinant, zero for singular matrix</returns>
+	T determinant() const;
+
+	/// <summary>
+	/// Check whether a zero pivot was met, in which case solve throws
+	/// </summary>
+	/// <returns>True if A is singular</returns>
+	bool isSingular() const { return m_singular; }
+
+private:
+	// L below the diagonal and U on and above it
+	BasicMatrix<T> m_factor;
+
+	// Row i of P A is row m_permutation[i] of A
+	std::vector<size_t> m_permutation;
+
+	// Whether the number of row swaps is odd
+	bool m_oddSwaps;
+
+	// Whether a zero pivot was met
+	bool m_singular;
+};
+
+extern template class BasicCholeskyFactorization<float>;
+extern template class BasicCholeskyFactorization<double>;
+extern template class BasicQRFactorization<float>;
+extern template class BasicQRFactorization<double>;
+extern template class BasicLUFactorization<float>;
+extern template class BasicLUFactorization<double>;
+
+using CholeskyFactorization = BasicCholeskyFactorization<double>;
+using QRFactorization = BasicQRFactorization<double>;
+using LUFactorization = BasicLUFactorization<double>;
+
+#endif // !FACTORIZATION_H
@@ -0,0 +1,76 @@
+#ifndef GEMM_H
+#define GEMM_H
+
+#include <cstddef>
+#include <type_traits>
+
+/// <summary>
+/// Whether an operand of a matrix product is used as stored or transposed
+/// </summary>
+enum class Transpose
+{
+	No,
+	Yes
+};
+
+/// <summary>
+/// General matrix-matrix product on row-major buffers,
+/// C = alpha * op(A) * op(B) + beta * C.
+/// op(A) is m x k, op(B) is k x n and C is m x n. The product is computed by a
+/// packed, cache-blocked kernel using AVX2/FMA when the CPU supports it.
+/// Instantiated for float and double.
+/// </summary>
+/// <param name="transA">Whether A is transposed</param>
+/// <param name="transB">Whether B is transposed</param>
+/// <param name="m">Number of rows of op(A) and C</param>
+/// <param name="n">Number of columns of op(B) and C</param>
+/// <param name="k">Number of columns of op(A) and rows of op(B)</param>
+/// <param name="alpha">Scale of the product</param>
+/// <param name="a">Pointer to A</param>
+/// <param name="lda">Row stride of A</param>
+/// <param name="b">Pointer to B</param>
+/// <param name="ldb">Row stride of B</param>
+/// <param name="beta">Scale of the existing C, C is not read when zero</param>
+/// <param name="c">Pointer to C</param>
+/// <param name="ldc">Row stride of C</param>
+template <typename T>
+void gemm(Transpose transA, Transpose transB, size_t m, size_t n, size_t k,
+	std::type_identity_t<T> alpha, const T* a, size_t lda, const T* b, size_t ldb,
+	std::type_identity_t<T> beta, T* c, size_t ldc);
+
+/// <summary>
+/// Matrix-vector product on a row-major buffer, y = alpha * op(A) * x + beta * y.
+/// A is m x n as stored. The transposed product reads A row by row, so no
+/// transposed copy is made.
+/// </summary>
+/// <param name="trans">Whether A is transposed</param>
+/// <param name="m">Number of rows of A</param>
+/// <param name="n">Number of columns of A</param>
+/// <param name="alpha">Scale of the product</param>
+/// <param name="a">Pointer to A</param>
+/// <param name="lda">Row stride of A</param>
+/// <param name="x">Input vector, n elements (m when transposed)</param>
+/// <param name="beta">Scale of the existing y, y is not read when zero</param>
+/// <param name="y">Output vector, m elements (n when transposed)</param>
+template <typename T>
+void gemv(Transpose trans, size_t m, size_t n, std::type_identity_t<T> alpha, const T* a, size_t lda,
+	const T* x, std::type_identity_t<T> beta, T* y);
+
+/// <summary>
+/// Symmetric rank-k update on row-major buffers, C = alpha * A^T * A + beta * C.
+/// A is k x n and C is n x n. Only the upper triangle of C (j >= i) is
+/// computed and written; the strictly lower triangle is left untouched.
+/// </summary>
+/// <param name="n">Number of columns of A, order of C</param>
+/// <param name="k">Number of rows of A</param>
+/// <param name="alpha">Scale of the product</param>
+/// <param name="a">Pointer to A</param>
+/// <param name="lda">Row stride of A</param>
+/// <param name="beta">Scale of the existing C, C is not read when zero</param>
+/// <param name="c">Pointer to C</param>
+/// <param name="ldc">Row stride of C</param>
+template <typename T>
+void syrk(size_t n, size_t k, std::type_identity_t<T> alpha, const T* a, size_t lda,
+	std::type_identity_t<T> beta, T* c, size_t ldc);
+
+#endif // !GEMM_H
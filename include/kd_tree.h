@@ -0,0 +1,114 @@
+#ifndef KD_TREE_H
+#define KD_TREE_H
+
+#include "distance.h"
+#include "matrix_view.h"
+#include <cstddef>
+#include <span>
+#include <vector>
+
+/// <summary>
+/// KD-tree over the rows of a matrix, for exact nearest row queries in
+/// squared Euclidean distance. Nodes split at the median of the dimension of
+/// largest spread, and the rows of each leaf are stored contiguously.
+/// Queries return the same row as nearestRow, ties included: distances are
+/// computed by the same kernel and the pruning tests only skip nodes whose
+/// rows are strictly farther than the best row found.
+/// </summary>
+/// <typeparam name="T">Scalar type, float or double</typeparam>
+template <typename T>
+class BasicKDTree
+{
+public:
+	/// <summary>
+	/// Constructor for an empty tree
+	/// </summary>
+	BasicKDTree();
+
+	/// <summary>
+	/// Constructor, builds the tree over the rows of a matrix
+	/// </summary>
+	/// <param name="rows">Rows to index, copied into the tree</param>
+	explicit BasicKDTree(const BasicMatrixView<T>& rows);
+
+	/// <summary>
+	/// Rebuild the tree over new rows, reusing its buffers
+	/// </summary>
+	/// <param name="rows">Rows to index, copied into the tree</param>
+	void build(const BasicMatrixView<T>& rows);
+
+	/// <summary>
+	/// Remove all rows
+	/// </summary>
+	void clear();
+
+	/// <summary>
+	/// Index of the row closest to a point, the first one on ties
+	/// </summary>
+	/// <param name="x">Point, one element per column</param>
+	/// <param name="squaredDistance">If not null, receives the squared distance to the closest row</param>
+	/// <returns>Index of the closest row</returns>
+	size_t nearest(std::span<const T> x, T* squaredDistance = nullptr) const;
+
+	/// <summary>
+	/// Get the number of rows
+	/// </summary>
+	/// <returns>Number of rows</returns>
+	inline size_t size() const { return m_indices.size(); }
+
+	/// <summary>
+	/// Whether the tree holds no rows
+	/// </summary>
+	/// <returns>True when empty</returns>
+	inline bool empty() const { return m_indices.empty(); }
+
+private:
+	/// <summary>
+	/// Node of the tree. Leaves have no children and hold the rows
+	/// [begin, end) of the permuted rows.
+	/// </summary>
+	struct Node
+	{
+		// Range of the permuted rows below the node
+		size_t begin;
+		size_t end;
+
+		// Children, zero for leaves, as the root is never a child
+		size_t left;
+		size_t right;
+
+		// Rows of the left child are at most splitValue in dimension
+		// splitDim, rows of the right child at least splitValue
+		size_t splitDim;
+		T splitValue;
+	};
+
+	/// <summary>
+	/// Build the subtree over the permuted rows [begin, end)
+	/// </summary>
+	/// <returns>Index of the subtree root</returns>
+	size_t buildNode(const BasicMatrixView<T>& rows, size_t begin, size_t end);
+
+	// Nodes, the root first
+	std::vector<Node> m_nodes;
+
+	// Rows in leaf order, one per m_numCols elements
+	std::vector<T> m_rows;
+
+	// Original index of each row in leaf order
+	std::vector<size_t> m_indices;
+
+	// Number of columns
+	size_t m_numCols;
+
+	// Squared distance function of the dimension
+	SquaredDistanceFunction<T> m_distance;
+};
+
+extern template class BasicKDTree<float>;
+extern template class BasicKDTree<double>;
+
+using KDTree = BasicKDTree<double>;
+using KDTreeF = BasicKDTree<float>;
+
+#endif // !KD_TREE_H
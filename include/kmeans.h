@@ -1,59 +1,202 @@
 #ifndef KMEANS_H
 #define KMEANS_H
 
+#include "data_source.h"
+#include "distance.h"
+#include "kd_tree.h"
+#include "matrix.h"
+#include "matrix_view.h"
+#include <cstdint>
 #include <memory>
+#include <random>
+#include <span>
 #include <vector>
 
-using Point = std::vector<double>;
+template <typename T>
+using BasicPoint = std::vector<T>;
+
+using Point = BasicPoint<double>;
+
+/// <summary>
+/// Algorithm used for the assignment step of K Means. The accelerated ones
+/// skip distance computations using the triangle inequality and give the
+/// same clusters as Lloyd.
+/// </summary>
+enum class KMeansAlgorithm
+{
+	// Distances from every point to every centroid on every iteration
+	Lloyd,
+
+	// One upper and one lower bound per point, suited to low k
+	Hamerly,
+
+	// One upper and k lower bounds per point plus the centroid to centroid
+	// distances, suited to high k, at the cost of n x k bounds in memory
+	Elkan,
+
+	// Lloyd with the centroids indexed by a KD-tree rebuilt every iteration,
+	// sublinear in k for low dimensions; predict queries the tree too
+	KDTree,
+
+	// KDTree for very high k in low dimensions, else Elkan for high k when
+	// its bounds fit in memory, else Hamerly
+	Auto
+};
+
+/// <summary>
+/// Strategy choosing the initial centroids of K Means. All of them are
+/// deterministic for a given seed, whatever the number of threads.
+/// </summary>
+enum class KMeansInit
+{
+	// Uniformly random points, duplicates possible
+	Random,
+
+	// Greedy k-means++, each seed the best of a few points drawn with
+	// probability proportional to their squared distance to the nearest seed
+	// so far, two passes over the data per seed
+	KMeansPlusPlus,
+
+	// k-means||, a few oversampling passes drawing about 2k candidates each,
+	// reduced to k seeds by weighted k-means++, suited to large data and k
+	KMeansParallel
+};
 
 /// <summary>
 /// Class for implementation of K Means algorithm
 /// </summary>
-class KMeans
+/// <typeparam name="T">Scalar type, float or double</typeparam>
+template <typename T>
+class BasicKMeans
 {
 public:
 	/// <summary>
-	/// Constructor
+	/// Constructor, throws std::invalid_argument when k is zero
 	/// </summary>
 	/// <param name="k">Number of clusters</param>
 	/// <param name="maxIterations">Maximum number of iterations</param>
 	/// <param name="tolerance">Minimum tolerance value</param>
-	KMeans(size_t k, size_t maxIterations = 100, double tolerance = 0.001);
+	/// <param name="algorithm">Algorithm of the assignment step</param>
+	/// <param name="init">Strategy choosing the initial centroids</param>
+	/// <param name="seed">Seed of the random draws</param>
+	BasicKMeans(size_t k, size_t maxIterations = 100, T tolerance = T(0.001), KMeansAlgorithm algorithm = KMeansAlgorithm::Lloyd,
+		KMeansInit init = KMeansInit::Random, uint32_t seed = 42);
 
 	/// <summary>
 	/// Fit the data
 	/// </summary>
 	/// <param name="X">Input data</param>
-	void fit(const std::vector<Point>& X);
+	void fit(const std::vector<BasicPoint<T>>& X);
+
+	/// <summary>
+	/// Fit the data without copying it
+	/// </summary>
+	/// <param name="X">Input data, one point per row</param>
+	void fit(const BasicMatrixView<T>& X);
+
+	/// <summary>
+	/// Fit data streamed from a source, for data larger than memory. Every
+	/// iteration reads the rows chunk by chunk, prefetching the next chunk
+	/// while the current one is assigned, so only the centroids, the cluster
+	/// sums, the labels and the bounds of the accelerated algorithms stay in
+	/// memory. The centroids are seeded on a random sample of rows, all of
+	/// them when the data is small, in which case the result is the same as
+	/// fitting a view of the data.
+	/// </summary>
+	/// <param name="source">Source of the rows</param>
+	/// <param name="chunkRows">Number of rows per chunk, rounded up to whole blocks of points</param>
+	void fit(BasicDataSource<T>& source, size_t chunkRows = 65536);
 
 	/// <summary>
 	/// Predict
 	/// </summary>
 	/// <param name="X">Input data</param>
 	/// <returns>Predicted cluster value</returns>
-	size_t predict(const Point& X) const;
+	size_t predict(const BasicPoint<T>& X) const;
+
+	/// <summary>
+	/// Predict the cluster of every row. Distances are expanded as
+	/// ||x||^2 - 2 x.c + ||c||^2, the products taken by GEMM over blocks of
+	/// rows and centroids against the cached centroid norms, so points almost
+	/// equally far from two centroids may be labelled differently from
+	/// predict. Besides the labels, a call allocates one fixed-size block of
+	/// scores per thread, whatever the number of clusters.
+	/// </summary>
+	/// <param name="X">Input data, one point per row</param>
+	/// <returns>Predicted cluster per row</returns>
+	std::vector<size_t> predictBatch(const BasicMatrixView<T>& X) const;
 
 	/// <summary>
 	/// Get the centroids
 	/// </summary>
 	/// <returns>Centroids</returns>
-	std::vector<Point> getCentroids() const { return m_centroids; }
-private:
+	std::vector<BasicPoint<T>> getCentroids() const;
 
 	/// <summary>
-	/// Calculated euclidean distance between two points
+	/// Get the cluster of every point of the last fit
 	/// </summary>
-	/// <param name="a">Point a</param>
-	/// <param name="b">Point a</param>
-	/// <returns>Euclidean distance</returns>
-	double getEuclideanDistance(const Point& a, const Point& b) const;
+	/// <returns>Cluster index per point</returns>
+	const std::vector<size_t>& getLabels() const { return m_labels; }
+protected:
 
 	/// <summary>
-	/// Calculates the closest centroid to a given point
+	/// Choose the initial centroids with the configured strategy
+	/// </summary>
+	/// <param name="X">Input data, one point per row</param>
+	/// <param name="gen">Random generator, also used later to reseed empty clusters</param>
+	void initCentroids(const BasicMatrixView<T>& X, std::mt19937& gen);
+
+	/// <summary>
+	/// Lloyd iterations from the initial centroids, reading the rows in chunks
+	/// </summary>
+	/// <param name="source">Source of the rows</param>
+	/// <param name="chunkRows">Number of rows per chunk</param>
+	/// <param name="gen">Random generator reseeding empty clusters</param>
+	void iterate(BasicDataSource<T>& source, size_t chunkRows, std::mt19937& gen);
+
+	/// <summary>
+	/// Cache the squared norms of the centroids, after they change
+	/// </summary>
+	void updateCentroidNorms();
+
+	/// <summary>
+	/// Calculates the closest centroid to a given point, comparing squared distances
 	/// </summary>
 	/// <param name="p">Input point</param>
 	/// <returns>Closest centroid</returns>
-	size_t getClosestCentroid(const Point& p) const;
+	size_t getClosestCentroid(std::span<const T> p) const;
+
+	/// <summary>
+	/// Hamerly assignment of one point, updating its bounds
+	/// </summary>
+	/// <param name="x">Input point</param>
+	/// <param name="first">Whether this is the first iteration, when no bounds are known</param>
+	/// <param name="label">Current cluster of the point</param>
+	/// <param name="distance">Squared distance function</param>
+	/// <param name="halfGap">Half the distance from the current centroid to its nearest other centroid</param>
+	/// <param name="slack">Relative margin of the pruning tests</param>
+	/// <param name="upper">Upper bound of the distance to the current centroid</param>
+	/// <param name="lower">Lower bound of the distance to any other centroid</param>
+	/// <returns>Closest centroid</returns>
+	size_t assignHamerly(const T* x, bool first, size_t label, SquaredDistanceFunction<T> distance,
+		T halfGap, T slack, T& upper, T& lower) const;
+
+	/// <summary>
+	/// Elkan assignment of one point, updating its bounds
+	/// </summary>
+	/// <param name="x">Input point</param>
+	/// <param name="first">Whether this is the first iteration, when no bounds are known</param>
+	/// <param name="label">Current cluster of the point</param>
+	/// <param name="distance">Squared distance function</param>
+	/// <param name="halfCentroidDistances">Half the distances between centroids, k x k</param>
+	/// <param name="drift">Distance each centroid moved since the bounds were last updated</param>
+	/// <param name="halfGap">Half the distance from each centroid to its nearest other centroid</param>
+	/// <param name="slack">Relative margin of the pruning tests</param>
+	/// <param name="upper">Upper bound of the distance to the current centroid</param>
+	/// <param name="lower">Lower bounds of the distances to every centroid, k elements</param>
+	/// <returns>Closest centroid</returns>
+	size_t assignElkan(const T* x, bool first, size_t label, SquaredDistanceFunction<T> distance,
+		const T* halfCentroidDistances, const T* drift, const T* halfGap, T slack, T& upper, T* lower) const;
 
 	// Number of clusters
 	size_t m_k;
@@ -62,10 +205,112 @@ private:
 	size_t m_maxIterations;
 
 	// Minimum tolerance value
-	double m_tolerance;
+	T m_tolerance;
+
+	// Algorithm of the assignment step
+	KMeansAlgorithm m_algorithm;
+
+	// Strategy choosing the initial centroids
+	KMeansInit m_init;
+
+	// Seed of the random draws
+	uint32_t m_seed;
+
+	// Centroids, one per row
+	BasicMatrix<T> m_centroids;
+
+	// Cluster of every point of the last fit
+	std::vector<size_t> m_labels;
+
+	// Squared norm of each centroid
+	std::vector<T> m_centroidNorms;
+
+	// Index of the centroids, empty unless fitted with KMeansAlgorithm::KDTree
+	BasicKDTree<T> m_index;
+};
+
+/// <summary>
+/// Mini-batch K Means. Each batch moves every centroid towards the mean of
+/// its points with a learning rate of one over the number of points the
+/// centroid has received, so batches can be streamed through partialFit
+/// with memory bounded by the centroids and one batch.
+/// </summary>
+/// <typeparam name="T">Scalar type, float or double</typeparam>
+template <typename T>
+class BasicMiniBatchKMeans : public BasicKMeans<T>
+{
+public:
+	/// <summary>
+	/// Constructor
+	/// </summary>
+	/// <param name="k">Number of clusters</param>
+	/// <param name="batchSize">Number of points per batch drawn by fit</param>
+	/// <param name="maxIterations">Maximum number of batches drawn by fit</param>
+	/// <param name="tolerance">Minimum tolerance value of the centroid change per batch</param>
+	/// <param name="init">Strategy choosing the initial centroids</param>
+	/// <param name="seed">Seed of the random draws</param>
+	BasicMiniBatchKMeans(size_t k, size_t batchSize = 1024, size_t maxIterations = 100, T tolerance = T(0.001),
+		KMeansInit init = KMeansInit::KMeansPlusPlus, uint32_t seed = 42);
+
+	/// <summary>
+	/// Fit the data from scratch on random batches, then label every point
+	/// </summary>
+	/// <param name="X">Input data</param>
+	void fit(const std::vector<BasicPoint<T>>& X);
+
+	/// <summary>
+	/// Fit the data from scratch on random batches, then label every point.
+	/// The centroids are seeded on a sample of three batches.
+	/// </summary>
+	/// <param name="X">Input data, one point per row</param>
+	void fit(const BasicMatrixView<T>& X);
+
+	/// <summary>
+	/// Update the centroids with one batch. The first batch seeds the
+	/// centroids and must hold at least k points. The labels are those of
+	/// the batch.
+	/// </summary>
+	/// <param name="batch">Batch, one point per row</param>
+	void partialFit(const BasicMatrixView<T>& batch);
+
+	/// <summary>
+	/// Get the number of points each centroid has received
+	/// </summary>
+	/// <returns>Count per centroid</returns>
+	const std::vector<size_t>& getCounts() const { return m_counts; }
 
-	// Centroids
-	std::vector<Point> m_centroids;
+private:
+	/// <summary>
+	/// Assign the points of a batch and move the centroids
+	/// </summary>
+	/// <param name="batch">Batch, one point per row</param>
+	/// <returns>Largest distance a centroid moved</returns>
+	T update(const BasicMatrixView<T>& batch);
+
+	// Number of points per batch drawn by fit
+	size_t m_batchSize;
+
+	// Number of points each centroid has received
+	std::vector<size_t> m_counts;
+
+	// Sums of the points of the current batch per centroid
+	BasicMatrix<T> m_sums;
+
+	// Number of points of the current batch per centroid
+	std::vector<size_t> m_batchCounts;
+
+	// Random generator of the seeding and the batches drawn by fit
+	std::mt19937 m_gen;
 };
 
+extern template class BasicKMeans<float>;
+extern template class BasicKMeans<double>;
+extern template class BasicMiniBatchKMeans<float>;
+extern template class BasicMiniBatchKMeans<double>;
+
+using KMeans = BasicKMeans<double>;
+using KMeansF = BasicKMeans<float>;
+using MiniBatchKMeans = BasicMiniBatchKMeans<double>;
+using MiniBatchKMeansF = BasicMiniBatchKMeans<float>;
+
 #endif // !KMEANS_H
@@ -1,13 +1,33 @@
 #ifndef LINEAR_REGRESSION_H
 #define LINEAR_REGRESSION_H
 
+#include <cmath>
+#include <limits>
+#include <span>
 #include <vector>
 #include "matrix.h"
+#include "matrix_view.h"
+#include "sparse_matrix.h"
+
+/// <summary>
+/// Method used to solve the least squares problem of multiple linear regression
+/// </summary>
+enum class LeastSquaresSolver
+{
+	// Cholesky factorization of the normal equations X^T X beta = X^T y,
+	// falling back to QR when X^T X is not numerically positive definite
+	Cholesky,
+
+	// Householder QR factorization of X, for ill-conditioned data
+	QR
+};
 
 /// <summary>
 /// Class for implementation of Linear Regression
 /// </summary>
-class LinearRegression
+/// <typeparam name="T">Scalar type, float or double</typeparam>
+template <typename T>
+class BasicLinearRegression
 {
 public:
 	/// <summary>
@@ -15,59 +35,119 @@ public:
 	/// </summary>
 	/// <param name="x"></param>
 	/// <param name="y"></param>
-	LinearRegression(const std::vector<double>& x, const std::vector<double>& y);
+	BasicLinearRegression(const std::vector<T>& x, const std::vector<T>& y);
 
 	/// <summary>
 	/// Constructor for multiple linear regression.
 	/// </summary>
 	/// <param name="X"></param>
 	/// <param name="y"></param>
-	LinearRegression(const Matrix& X, const std::vector<double>& y);
+	/// <param name="solver">Least squares solver</param>
+	BasicLinearRegression(const BasicMatrixView<T>& X, const std::vector<T>& y, LeastSquaresSolver solver = LeastSquaresSolver::Cholesky);
+
+	/// <summary>
+	/// Constructor for multiple linear regression on sparse features.
+	/// Solved by conjugate gradients on the normal equations using only sparse
+	/// products with X and a sparse copy of X^T, so neither X nor X^T X is ever
+	/// densified and memory is linear in the rows, columns and non-zeros.
+	/// Collinear or all-zero columns give the minimum-norm coefficients
+	/// instead of an error. A fit that reaches maxIterations first keeps its
+	/// last coefficients and reports hasConverged() false.
+	/// </summary>
+	/// <param name="X">Input features, one row per observation</param>
+	/// <param name="y">Target values, one per row of X</param>
+	/// <param name="tolerance">Stop once ||r|| is at most tolerance * ||y||, or ||A^T r|| at most
+	/// tolerance * ||A|| * ||r||, for the residual r and the column-scaled [1 X] as A</param>
+	/// <param name="maxIterations">Upper bound on the conjugate gradient iterations</param>
+	BasicLinearRegression(const BasicSparseMatrix<T>& X, const std::vector<T>& y,
+		T tolerance = std::sqrt(std::numeric_limits<T>::epsilon()), size_t maxIterations = 10000);
 
 	/// <summary>
 	/// Get the predicted value for simple linear regression.
 	/// </summary>
 	/// <param name="x">Input value</param>
 	/// <returns>Predicted value</returns>
-	double predict(double x) const;
+	T predict(T x) const;
 
 	/// <summary>
 	/// Get the predicted value for multiple linear regression.
 	/// </summary>
 	/// <param name="X">Input values</param>
 	/// <returns>Predicted value</returns>
-	double predict(std::vector<double>& X) const;
+	T predict(std::vector<T>& X) const;
+
+	/// <summary>
+	/// Get the predicted values for every row of sparse input.
+	/// </summary>
+	/// <param name="X">Input values</param>
+	/// <returns>Predicted values, one per row</returns>
+	std::vector<T> predict(const BasicSparseMatrix<T>& X) const;
+
+	/// <summary>
+	/// Get the predicted values for every row of X into a caller-provided
+	/// buffer, with one matrix-vector product and no allocation. For simple
+	/// linear regression X has a single column.
+	/// </summary>
+	/// <param name="X">Input values</param>
+	/// <param name="out">Predicted values, one per row of X</param>
+	void predictBatch(const BasicMatrixView<T>& X, std::span<T> out) const;
 
 	/// <summary>
 	/// Get the intercept.
 	/// </summary>
 	/// <returns>Intercept</returns>
-	double getIntercept() const;
+	T getIntercept() const;
 
 	/// <summary>
 	/// Get the slope.
 	/// </summary>
 	/// <returns>Slope</returns>
-	double getSlope() const;
+	T getSlope() const;
 
 	/// <summary>
 	/// Returns the coefficients for multiple linear regression.
 	/// </summary>
 	/// <returns>Coefficients</returns>
-	std::vector<double> getCoefficients() const;
+	std::vector<T> getCoefficients() const;
+
+	/// <summary>
+	/// Get the number of conjugate gradient iterations of the sparse fit, zero
+	/// for the direct solvers.
+	/// </summary>
+	/// <returns>Number of iterations</returns>
+	size_t getNumOfIterations() const;
+
+	/// <summary>
+	/// Whether the sparse fit met its tolerance before maxIterations; always
+	/// true for the direct solvers.
+	/// </summary>
+	/// <returns>True when converged</returns>
+	bool hasConverged() const;
 
 private:
 	// Intercept value for simple linear regression
-	double m_beta0;
+	T m_beta0;
 
 	// Slope value for simple linear regression
-	double m_beta1;
+	T m_beta1;
 
 	// Coefficient values for multiple linear regression
-	std::vector<double> m_beta;
+	std::vector<T> m_beta;
 
 	// Boolean value for, is simple linear regression
 	bool m_isSimple;
+
+	// Conjugate gradient iterations of the sparse fit
+	size_t m_numOfIterations;
+
+	// Whether the sparse fit met its tolerance
+	bool m_converged;
 };
 
+extern template class BasicLinearRegression<float>;
+extern template class BasicLinearRegression<double>;
+
+using LinearRegression = BasicLinearRegression<double>;
+using LinearRegressionF = BasicLinearRegression<float>;
+
 #endif // !LINEAR_REGRESSION_H
\ No newline at end of file
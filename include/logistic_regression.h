@@ -1,62 +1,237 @@
 #ifndef LOGISTIC_REGRESSION_H
 #define LOGISTIC_REGRESSION_H
 
+#include "data_source.h"
 #include "matrix.h"
-#include <memory>
+#include "matrix_view.h"
+#include "sparse_matrix.h"
+#include <cstdint>
+#include <span>
 #include <vector>
 
+/// <summary>
+/// Optimizer of the logistic loss
+/// </summary>
+enum class LogisticSolver
+{
+	// Full-batch gradient descent, one pass over all rows per iteration
+	GradientDescent,
+
+	// Mini-batch stochastic gradient descent with a constant learning rate,
+	// iterations are epochs over the rows
+	SGD,
+
+	// Mini-batch Adam, iterations are epochs over the rows
+	Adam,
+
+	// Limited-memory BFGS with a backtracking line search, iterations are
+	// an upper bound and the fit stops once converged
+	LBFGS,
+
+	// Newton's method as iteratively reweighted least squares, each step a
+	// Cholesky solve with the weighted Gram matrix of X, iterations are an
+	// upper bound and the fit stops once converged
+	IRLS,
+
+	// Asynchronous SGD without locks: every thread samples rows with its own
+	// random stream and updates the shared weights one row at a time, so
+	// concurrent updates may overwrite each other. Sparse rows only touch
+	// the weights of their non-zeros. Iterations are epochs, and the weights
+	// depend on the thread scheduling unless a single thread is used.
+	Hogwild
+};
+
 /// <summary>
 /// Class for implementation of Logistic Regression
 /// </summary>
-class LogisticRegression
+/// <typeparam name="T">Scalar type, float or double</typeparam>
+template <typename T>
+class BasicLogisticRegression
 {
 public:
 	/// <summary>
 	/// Constructor for logistic regression.
 	/// </summary>
 	/// <param name="learningRate">Learning rate</param>
-	/// <param name="iterations">Number of iterations</param>
-	LogisticRegression(double learningRate = 0.01, size_t iterations = 1000);
+	/// <param name="iterations">Number of iterations, epochs for the mini-batch solvers</param>
+	/// <param name="solver">Optimizer of the loss</param>
+	/// <param name="batchSize">Number of rows of a mini-batch</param>
+	/// <param name="seed">Seed of the shuffling of the mini-batch solvers</param>
+	/// <param name="tolerance">LBFGS and IRLS stop once the largest gradient element is at most tolerance,
+	/// or the loss decreases by at most tolerance relative to the loss</param>
+	/// <param name="averageWeights">Whether Hogwild keeps the mean of the weights at the end of every epoch</param>
+	BasicLogisticRegression(T learningRate = T(0.01), size_t iterations = 1000, LogisticSolver solver = LogisticSolver::GradientDescent,
+		size_t batchSize = 256, uint32_t seed = 42, T tolerance = T(1e-6), bool averageWeights = false);
+
+	/// <summary>
+	/// Fit the logistic regression. Gradient descent makes each iteration a
+	/// single fused pass over X with the intercept handled implicitly, so X
+	/// is not copied and the iterations do not allocate. The mini-batch
+	/// solvers shuffle all rows on every epoch.
+	/// </summary>
+	/// <param name="X">Input features</param>
+	/// <param name="y">Input labels</param>
+	void fit(const BasicMatrixView<T>& X, const std::vector<T>& y);
+
+	/// <summary>
+	/// Fit the logistic regression with a mini-batch solver on rows streamed
+	/// from data sources, for data larger than memory. Each epoch visits the
+	/// chunks in a random order, prefetching the next one, and the rows of
+	/// each chunk in a random order, so a chunk is the shuffling buffer.
+	/// The solver must be SGD or Adam, and y a different object than X,
+	/// otherwise std::invalid_argument is thrown.
+	/// </summary>
+	/// <param name="X">Source of the input features</param>
+	/// <param name="y">Source of the input labels, one column, a different object than X</param>
+	/// <param name="chunkRows">Number of rows read at a time</param>
+	/// <param name="shuffle">Whether to shuffle the chunks and the rows within them</param>
+	void fit(BasicDataSource<T>& X, BasicDataSource<T>& y, size_t chunkRows = 65536, bool shuffle = true);
+
+	/// <summary>
+	/// Update the model with one pass of mini-batches over the rows, in
+	/// order, keeping the optimizer state between calls. The first call
+	/// starts from zero weights. The solver must be SGD or Adam, otherwise
+	/// std::invalid_argument is thrown.
+	/// </summary>
+	/// <param name="X">Input features</param>
+	/// <param name="y">Input labels</param>
+	void partialFit(const BasicMatrixView<T>& X, const std::vector<T>& y);
 
 	/// <summary>
-	/// Fit the logistic regression
+	/// Fit the logistic regression on sparse features by gradient descent or
+	/// Hogwild; the other solvers throw std::invalid_argument. The intercept
+	/// is handled implicitly, so X is never densified; gradient descent keeps
+	/// a sparse copy of X^T for a parallel gradient however wide X is.
 	/// </summary>
 	/// <param name="X">Input features</param>
 	/// <param name="y">Input labels</param>
-	void fit(const Matrix& X, const std::vector<double>& y);
+	void fit(const BasicSparseMatrix<T>& X, const std::vector<T>& y);
 
 	/// <summary>
 	/// Predict value from input
 	/// </summary>
 	/// <param name="x">Input features</param>
 	/// <returns>Predicted value</returns>
-	int predict(const std::vector<double>& x) const;
+	int predict(const std::vector<T>& x) const;
+
+	/// <summary>
+	/// Predict values for every row of sparse input
+	/// </summary>
+	/// <param name="X">Input features</param>
+	/// <returns>Predicted values, one per row</returns>
+	std::vector<int> predict(const BasicSparseMatrix<T>& X) const;
+
+	/// <summary>
+	/// Probability of class 1 for every row of X, written to a caller-provided
+	/// buffer with one matrix-vector product, a vectorized sigmoid and no
+	/// allocation. A row is predicted as 1 when its probability exceeds 0.5.
+	/// </summary>
+	/// <param name="X">Input features</param>
+	/// <param name="out">Probabilities, one per row of X</param>
+	void predictBatch(const BasicMatrixView<T>& X, std::span<T> out) const;
 
 	/// <summary>
 	/// Sigmoid function
 	/// </summary>
 	/// <param name="z">Input value</param>
 	/// <returns>Resultant value</returns>
-	double sigmoid(double z) const;
+	T sigmoid(T z) const;
 
 	/// <summary>
 	/// Sigmoid function
 	/// </summary>
 	/// <param name="z">Input vector</param>
 	/// <returns>Resultant vector</returns>
-	std::vector<double> sigmoid(std::vector<double> z) const;
+	std::vector<T> sigmoid(std::vector<T> z) const;
+
+	/// <summary>
+	/// Get the weights, the intercept first
+	/// </summary>
+	/// <returns>Weights, one more than the number of columns</returns>
+	inline std::vector<T> getWeights() const { return m_weights; }
+
+	/// <summary>
+	/// Get the number of iterations of the last fit, epochs for the mini-batch solvers
+	/// </summary>
+	/// <returns>Number of iterations</returns>
+	inline size_t getNumOfIterations() const { return m_numOfIterations; }
+
+	/// <summary>
+	/// Get the mean logistic loss over the rows at the end of the last fit.
+	/// The stochastic solvers never evaluate it and leave it NaN.
+	/// </summary>
+	/// <returns>Final loss</returns>
+	inline T getLoss() const { return m_loss; }
 private:
+	/// <summary>
+	/// Reset the weights and the optimizer state to zero
+	/// </summary>
+	void reset(size_t numOfCols);
+
+	/// <summary>
+	/// Fit by L-BFGS, from zero weights. X has rows, as checked by fit.
+	/// </summary>
+	void fitLBFGS(const BasicMatrixView<T>& X, const std::vector<T>& y);
+
+	/// <summary>
+	/// Fit by Newton's method, from zero weights. X has rows, as checked by fit.
+	/// </summary>
+	void fitIRLS(const BasicMatrixView<T>& X, const std::vector<T>& y);
+
+	/// <summary>
+	/// One mini-batch step of the solver on some rows
+	/// </summary>
+	/// <param name="X">Input features</param>
+	/// <param name="y">Input labels, one column</param>
+	/// <param name="rows">Indices of the rows of the batch</param>
+	/// <param name="count">Number of rows of the batch</param>
+	void step(const BasicMatrixView<T>& X, const BasicMatrixView<T>& y, const size_t* rows, size_t count);
+
 	// Weights or coefficients
-	std::vector<double> m_weights;
+	std::vector<T> m_weights;
 
 	// Learning rate
-	double m_learningRate;
+	T m_learningRate;
 
 	// Number of iterations
 	size_t m_iterations;
 
-	// Data
-	std::unique_ptr<Matrix> m_data;
+	// Optimizer of the loss
+	LogisticSolver m_solver;
+
+	// Number of rows of a mini-batch
+	size_t m_batchSize;
+
+	// Seed of the shuffling
+	uint32_t m_seed;
+
+	// Gradient of the last mini-batch, one per weight
+	std::vector<T> m_gradient;
+
+	// Adam estimates of the mean and the uncentered variance of the gradient
+	std::vector<T> m_moment1;
+	std::vector<T> m_moment2;
+
+	// Number of Adam steps taken
+	size_t m_steps;
+
+	// Convergence tolerance of LBFGS and IRLS
+	T m_tolerance;
+
+	// Whether Hogwild keeps the mean of the weights of every epoch
+	bool m_averageWeights;
+
+	// Number of iterations of the last fit
+	size_t m_numOfIterations;
+
+	// Mean loss at the end of the last fit
+	T m_loss;
 };
 
+extern template class BasicLogisticRegression<float>;
+extern template class BasicLogisticRegression<double>;
+
+using LogisticRegression = BasicLogisticRegression<double>;
+using LogisticRegressionF = BasicLogisticRegression<float>;
+
 #endif // !LOGISTIC_REGRESSION_H
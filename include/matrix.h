@@ -1,13 +1,19 @@
 #ifndef MATRIX_H
 #define MATRIX_H
 
+#include "aligned_allocator.h"
+#include "matrix_view.h"
+#include <span>
 #include <vector>
 #include <stdexcept>
 
 /// <summary>
-/// Class for the implementation of a Matrix
+/// Class for the implementation of a Matrix.
+/// Elements are stored row-major in a single aligned buffer.
 /// </summary>
-class Matrix
+/// <typeparam name="T">Scalar type, float or double</typeparam>
+template <typename T>
+class BasicMatrix
 {
 public:
 	/// <summary>
@@ -15,41 +21,60 @@ public:
 	/// </summary>
 	/// <param name="numRows">Number of rows</param>
 	/// <param name="numCols">Number of columns</param>
-	Matrix(size_t numRows, size_t numCols) 
-		:m_numRows(numRows), m_numCols(numCols), m_data(numRows, std::vector<double>(numCols, 0.0)) { }
+	BasicMatrix(size_t numRows, size_t numCols) 
+		:m_numRows(numRows), m_numCols(numCols), m_data(numRows * numCols, T(0)) { }
 
 	/// <summary>
 	/// Constructor for Matrix 
 	/// </summary>
 	/// <param name="data"></param>
-	Matrix(const std::vector<std::vector<double>>& data)
-		:m_numRows(data.size()), m_numCols(data.empty() ? 0 : data[0].size()), m_data(data) { }
+	BasicMatrix(const std::vector<std::vector<T>>& data);
+
+	/// <summary>
+	/// Constructor for Matrix, copies the elements of a view
+	/// </summary>
+	/// <param name="view">Input view</param>
+	explicit BasicMatrix(const BasicMatrixView<T>& view);
 
 	/// <summary>
 	/// Overloaded for Matrix-vector multiplication
 	/// </summary>
 	/// <param name="x">Input vector</param>
 	/// <returns>Resultant vector</returns>
-	std::vector<double> operator*(const std::vector<double>& vec) const;
+	std::vector<T> operator*(const std::vector<T>& vec) const;
 
 	/// <summary>
 	/// Overloaded for Matrix-Matrix multiplication
 	/// </summary>
 	/// <param name="X">Input matrix</param>
 	/// <returns>Resultant matrix</returns>
-	Matrix operator*(const Matrix& other) const;
+	BasicMatrix operator*(const BasicMatrix& other) const;
+
+	/// <summary>
+	/// Transposed Matrix-vector multiplication, computed without forming the transpose
+	/// </summary>
+	/// <param name="vec">Input vector, one element per row</param>
+	/// <returns>Resultant vector, one element per column</returns>
+	std::vector<T> transposeTimes(const std::vector<T>& vec) const;
+
+	/// <summary>
+	/// Gram matrix, transpose of Matrix times Matrix. Only one triangle is
+	/// computed and mirrored, and the transpose is not formed.
+	/// </summary>
+	/// <returns>Resultant symmetric matrix</returns>
+	BasicMatrix gram() const;
 
 	/// <summary>
 	/// Transpose of Matrix
 	/// </summary>
 	/// <returns>Resultant matrix</returns>
-	Matrix transpose() const;
+	BasicMatrix transpose() const;
 
 	/// <summary>
 	/// Inverse of Matrix
 	/// </summary>
 	/// <returns>Resultant matrix</returns>
-	Matrix inverse() const;
+	BasicMatrix inverse() const;
 
 	/// <summary>
 	/// Get the number of rows
@@ -63,19 +88,68 @@ public:
 	/// <returns>Number of columns</returns>
 	inline size_t getNumOfCols() const { return m_numCols; }
 
+	/// <summary>
+	/// Get the distance between the starts of consecutive rows
+	/// </summary>
+	/// <returns>Row stride</returns>
+	inline size_t getStride() const { return m_numCols; }
+
+	/// <summary>
+	/// Get the pointer to the first element
+	/// </summary>
+	/// <returns>Pointer to data</returns>
+	inline T* data() { return m_data.data(); }
+
+	/// <summary>
+	/// Get the pointer to the first element (const)
+	/// </summary>
+	/// <returns>Const pointer to data</returns>
+	inline const T* data() const { return m_data.data(); }
+
+	/// <summary>
+	/// Get a row without copying
+	/// </summary>
+	/// <param name="i">Row index</param>
+	/// <returns>Span over the row</returns>
+	inline std::span<T> row(const size_t i)
+	{
+		return std::span<T>(m_data.data() + i * m_numCols, m_numCols);
+	}
+
+	/// <summary>
+	/// Get a row without copying (const)
+	/// </summary>
+	/// <param name="i">Row index</param>
+	/// <returns>Const span over the row</returns>
+	inline std::span<const T> row(const size_t i) const
+	{
+		return std::span<const T>(m_data.data() + i * m_numCols, m_numCols);
+	}
+
+	/// <summary>
+	/// Get a read-only view of the whole matrix
+	/// </summary>
+	/// <returns>Matrix view</returns>
+	inline BasicMatrixView<T> view() const { return BasicMatrixView<T>(m_data.data(), m_numRows, m_numCols); }
+
+	/// <summary>
+	/// Implicit conversion to a read-only view
+	/// </summary>
+	inline operator BasicMatrixView<T>() const { return view(); }
+
 	/// <summary>
 	/// Overloaded for indexing for element access
 	/// </summary>
 	/// <param name="i">Row index</param>
 	/// <param name="j">Column index</param>
 	/// <returns>Value of element at index</returns>
-	double& operator() (const size_t i, const size_t j)
+	T& operator() (const size_t i, const size_t j)
 	{
-		if (i >= m_numRows || i < 0 || j >= m_numCols || j < 0)
+		if (i >= m_numRows || j >= m_numCols)
 		{
 			throw std::invalid_argument("Matrix index out of range.");
 		}
-		return m_data[i][j];
+		return m_data[i * m_numCols + j];
 	}
 
 	/// <summary>
@@ -84,13 +158,13 @@ public:
 	/// <param name="i">Row index</param>
 	/// <param name="j">Column index</param>
 	/// <returns>Const value of element at index</returns>
-	const double& operator() (const size_t i, const size_t j) const
+	const T& operator() (const size_t i, const size_t j) const
 	{
-		if (i >= m_numRows || i < 0 || j >= m_numCols || j < 0)
+		if (i >= m_numRows || j >= m_numCols)
 		{
 			throw std::invalid_argument("Matrix index out of range.");
 		}
-		return m_data[i][j];
+		return m_data[i * m_numCols + j];
 	}
 private:
 	// Number of rows
@@ -99,8 +173,14 @@ private:
 	// Number of columns
 	size_t m_numCols;
 
-	// Matrix data
-	std::vector<std::vector<double>> m_data;
+	// Matrix data, row-major
+	std::vector<T, AlignedAllocator<T>> m_data;
 };
 
-#endif // !MATRIX_H
\ No newline at end of file
+extern template class BasicMatrix<float>;
+extern template class BasicMatrix<double>;
+
+using Matrix = BasicMatrix<double>;
+using MatrixF = BasicMatrix<float>;
+
+#endif // !MATRIX_H
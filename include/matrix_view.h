@@ -0,0 +1,187 @@
+#ifndef MATRIX_VIEW_H
+#define MATRIX_VIEW_H
+
+#include <span>
+#include <stdexcept>
+
+/// <summary>
+/// Non-owning view over a strided column of a row-major buffer
+/// </summary>
+/// <typeparam name="T">Scalar type</typeparam>
+template <typename T>
+class BasicColumnView
+{
+public:
+	/// <summary>
+	/// Constructor for column view
+	/// </summary>
+	/// <param name="data">Pointer to the first element</param>
+	/// <param name="size">Number of elements</param>
+	/// <param name="stride">Distance between consecutive elements</param>
+	BasicColumnView(const T* data, size_t size, size_t stride)
+		:m_data(data), m_size(size), m_stride(stride) { }
+
+	/// <summary>
+	/// Get the number of elements
+	/// </summary>
+	/// <returns>Number of elements</returns>
+	inline size_t size() const { return m_size; }
+
+	/// <summary>
+	/// Overloaded for indexing for element access
+	/// </summary>
+	/// <param name="i">Element index</param>
+	/// <returns>Const value of element at index</returns>
+	inline const T& operator[] (const size_t i) const { return m_data[i * m_stride]; }
+
+private:
+	// Pointer to the first element
+	const T* m_data;
+
+	// Number of elements
+	size_t m_size;
+
+	// Distance between consecutive elements
+	size_t m_stride;
+};
+
+/// <summary>
+/// Non-owning read-only view of a row-major matrix. Rows are contiguous and
+/// consecutive rows are m_stride elements apart, so a view can describe a
+/// Matrix, a block of rows of one, or external memory without copying.
+/// </summary>
+/// <typeparam name="T">Scalar type</typeparam>
+template <typename T>
+class BasicMatrixView
+{
+public:
+	/// <summary>
+	/// Constructor for empty view
+	/// </summary>
+	BasicMatrixView()
+		:m_data(nullptr), m_numRows(0), m_numCols(0), m_stride(0) { }
+
+	/// <summary>
+	/// Constructor for view over densely packed rows
+	/// </summary>
+	/// <param name="data">Pointer to the first element</param>
+	/// <param name="numRows">Number of rows</param>
+	/// <param name="numCols">Number of columns</param>
+	BasicMatrixView(const T* data, size_t numRows, size_t numCols)
+		:m_data(data), m_numRows(numRows), m_numCols(numCols), m_stride(numCols) { }
+
+	/// <summary>
+	/// Constructor for view over strided rows
+	/// </summary>
+	/// <param name="data">Pointer to the first element</param>
+	/// <param name="numRows">Number of rows</param>
+	/// <param name="numCols">Number of columns</param>
+	/// <param name="stride">Distance between the starts of consecutive rows</param>
+	BasicMatrixView(const T* data, size_t numRows, size_t numCols, size_t stride)
+		:m_data(data), m_numRows(numRows), m_numCols(numCols), m_stride(stride)
+	{
+		if (stride < numCols)
+		{
+			throw std::invalid_argument("Row stride must not be smaller than the number of columns.");
+		}
+	}
+
+	/// <summary>
+	/// Get the number of rows
+	/// </summary>
+	/// <returns>Number of rows</returns>
+	inline size_t getNumOfRows() const { return m_numRows; }
+
+	/// <summary>
+	/// Get the number of columns
+	/// </summary>
+	/// <returns>Number of columns</returns>
+	inline size_t getNumOfCols() const { return m_numCols; }
+
+	/// <summary>
+	/// Get the distance between the starts of consecutive rows
+	/// </summary>
+	/// <returns>Row stride</returns>
+	inline size_t getStride() const { return m_stride; }
+
+	/// <summary>
+	/// Get the pointer to the first element
+	/// </summary>
+	/// <returns>Pointer to data</returns>
+	inline const T* data() const { return m_data; }
+
+	/// <summary>
+	/// Check whether the view is empty
+	/// </summary>
+	/// <returns>True if there are no elements</returns>
+	inline bool empty() const { return m_numRows == 0 || m_numCols == 0; }
+
+	/// <summary>
+	/// Get a row without copying
+	/// </summary>
+	/// <param name="i">Row index</param>
+	/// <returns>Span over the row</returns>
+	inline std::span<const T> row(const size_t i) const
+	{
+		return std::span<const T>(m_data + i * m_stride, m_numCols);
+	}
+
+	/// <summary>
+	/// Get a column without copying
+	/// </summary>
+	/// <param name="j">Column index</param>
+	/// <returns>Strided view over the column</returns>
+	inline BasicColumnView<T> col(const size_t j) const
+	{
+		return BasicColumnView<T>(m_data + j, m_numRows, m_stride);
+	}
+
+	/// <summary>
+	/// Get a view over a contiguous range of rows
+	/// </summary>
+	/// <param name="first">Index of the first row</param>
+	/// <param name="count">Number of rows</param>
+	/// <returns>View over the rows</returns>
+	BasicMatrixView rows(const size_t first, const size_t count) const
+	{
+		if (first > m_numRows || count > m_numRows - first)
+		{
+			throw std::invalid_argument("Row range out of range.");
+		}
+		return BasicMatrixView(m_data + first * m_stride, count, m_numCols, m_stride);
+	}
+
+	/// <summary>
+	/// Overloaded for indexing for element access
+	/// </summary>
+	/// <param name="i">Row index</param>
+	/// <param name="j">Column index</param>
+	/// <returns>Const value of element at index</returns>
+	const T& operator() (const size_t i, const size_t j) const
+	{
+		if (i >= m_numRows || j >= m_numCols)
+		{
+			throw std::invalid_argument("Matrix index out of range.");
+		}
+		return m_data[i * m_stride + j];
+	}
+
+private:
+	// Pointer to the first element
+	const T* m_data;
+
+	// Number of rows
+	size_t m_numRows;
+
+	// Number of columns
+	size_t m_numCols;
+
+	// Distance between the starts of consecutive rows
+	size_t m_stride;
+};
+
+using ColumnView = BasicColumnView<double>;
+using MatrixView = BasicMatrixView<double>;
+using MatrixViewF = BasicMatrixView<float>;
+
+#endif // !MATRIX_VIEW_H
@@ -0,0 +1,99 @@
+#ifndef SOFTMAX_REGRESSION_H
+#define SOFTMAX_REGRESSION_H
+
+#include "matrix.h"
+#include "matrix_view.h"
+#include <vector>
+
+/// <summary>
+/// Multinomial logistic (softmax) regression. The scores of all classes
+/// for a block of rows come from one GEMM, so an iteration is one pass
+/// over the data whatever the number of classes, and probabilities go
+/// through a numerically stable log-sum-exp with a vectorized exponential.
+/// </summary>
+/// <typeparam name="T">Scalar type, float or double</typeparam>
+template <typename T>
+class BasicSoftmaxRegression
+{
+public:
+	/// <summary>
+	/// Constructor for softmax regression
+	/// </summary>
+	/// <param name="learningRate">Learning rate</param>
+	/// <param name="iterations">Number of iterations</param>
+	BasicSoftmaxRegression(T learningRate = T(0.1), size_t iterations = 1000);
+
+	/// <summary>
+	/// Fit by gradient descent on the mean cross-entropy. The number of
+	/// classes is one more than the largest label.
+	/// </summary>
+	/// <param name="X">Input features</param>
+	/// <param name="y">Class of each row, from zero</param>
+	void fit(const BasicMatrixView<T>& X, const std::vector<size_t>& y);
+
+	/// <summary>
+	/// Predict the class of a point
+	/// </summary>
+	/// <param name="x">Input features</param>
+	/// <returns>Most probable class</returns>
+	size_t predict(const std::vector<T>& x) const;
+
+	/// <summary>
+	/// Predict the class of every row
+	/// </summary>
+	/// <param name="X">Input features</param>
+	/// <returns>Most probable class of each row</returns>
+	std::vector<size_t> predict(const BasicMatrixView<T>& X) const;
+
+	/// <summary>
+	/// Class probabilities of every row
+	/// </summary>
+	/// <param name="X">Input features</param>
+	/// <returns>One row per row of X, one column per class, rows summing to one</returns>
+	BasicMatrix<T> predictProba(const BasicMatrixView<T>& X) const;
+
+	/// <summary>
+	/// Get the number of classes
+	/// </summary>
+	/// <returns>Number of classes, zero before fitting</returns>
+	inline size_t getNumOfClasses() const { return m_intercepts.size(); }
+
+	/// <summary>
+	/// Get the mean cross-entropy over the rows at the end of the last fit
+	/// </summary>
+	/// <returns>Final loss</returns>
+	inline T getLoss() const { return m_loss; }
+
+private:
+	/// <summary>
+	/// Class probabilities of some rows, written to one row of K values each
+	/// </summary>
+	/// <param name="X">Input features</param>
+	/// <param name="result">Output, one row per row of X</param>
+	/// <param name="labels">If not null, the class of each row, whose cross-entropy is summed</param>
+	/// <returns>Summed cross-entropy, zero without labels</returns>
+	T probabilities(const BasicMatrixView<T>& X, T* result, const size_t* labels) const;
+
+	// Weights, one row per column of X and one column per class
+	BasicMatrix<T> m_weights;
+
+	// Intercept of each class
+	std::vector<T> m_intercepts;
+
+	// Learning rate
+	T m_learningRate;
+
+	// Number of iterations
+	size_t m_iterations;
+
+	// Mean loss at the end of the last fit
+	T m_loss;
+};
+
+extern template class BasicSoftmaxRegression<float>;
+extern template class BasicSoftmaxRegression<double>;
+
+using SoftmaxRegression = BasicSoftmaxRegression<double>;
+using SoftmaxRegressionF = BasicSoftmaxRegression<float>;
+
+#endif // !SOFTMAX_REGRESSION_H
@@ -0,0 +1,140 @@
+#ifndef SPARSE_MATRIX_H
+#define SPARSE_MATRIX_H
+
+#include "gemm.h"
+#include "matrix.h"
+#include "matrix_view.h"
+#include <span>
+#include <vector>
+
+/// <summary>
+/// Sparse matrix in compressed sparse row (CSR) format. The non-zeros of row
+/// i are m_values[m_rowPointers[i] .. m_rowPointers[i + 1]), with their
+/// column indices at the same positions of m_columnIndices.
+/// The CSC form of a matrix is the CSR form of its transpose.
+/// </summary>
+/// <typeparam name="T">Scalar type, float or double</typeparam>
+template <typename T>
+class BasicSparseMatrix
+{
+public:
+	/// <summary>
+	/// Constructor for sparse matrix from CSR arrays
+	/// </summary>
+	/// <param name="numRows">Number of rows</param>
+	/// <param name="numCols">Number of columns</param>
+	/// <param name="rowPointers">Start of each row in the value array, numRows + 1 elements</param>
+	/// <param name="columnIndices">Column index of each non-zero</param>
+	/// <param name="values">Value of each non-zero</param>
+	BasicSparseMatrix(size_t numRows, size_t numCols, std::vector<size_t> rowPointers,
+		std::vector<size_t> columnIndices, std::vector<T> values);
+
+	/// <summary>
+	/// Constructor for sparse matrix, keeps the non-zero elements of a dense view
+	/// </summary>
+	/// <param name="dense">Input view</param>
+	explicit BasicSparseMatrix(const BasicMatrixView<T>& dense);
+
+	/// <summary>
+	/// Sparse matrix-vector product, y = alpha * op(A) * x + beta * y.
+	/// The transposed product scatters blocks of rows into partial sums kept
+	/// in a per-thread buffer. The partials are capped at 2^20 elements, so a
+	/// matrix that wide runs as one block on one thread; repeated transposed
+	/// products of wide matrices should multiply transpose() instead, which is
+	/// parallel over the columns.
+	/// </summary>
+	/// <param name="trans">Whether A is transposed</param>
+	/// <param name="alpha">Scale of the product</param>
+	/// <param name="x">Input vector, numCols elements (numRows when transposed)</param>
+	/// <param name="beta">Scale of the existing y, y is not read when zero</param>
+	/// <param name="y">Output vector, numRows elements (numCols when transposed)</param>
+	void multiply(Transpose trans, T alpha, const T* x, T beta, T* y) const;
+
+	/// <summary>
+	/// Overloaded for sparse matrix-vector multiplication
+	/// </summary>
+	/// <param name="vec">Input vector, one element per column</param>
+	/// <returns>Resultant vector, one element per row</returns>
+	std::vector<T> operator*(const std::vector<T>& vec) const;
+
+	/// <summary>
+	/// Transposed sparse matrix-vector multiplication, computed without forming the transpose
+	/// </summary>
+	/// <param name="vec">Input vector, one element per row</param>
+	/// <returns>Resultant vector, one element per column</returns>
+	std::vector<T> transposeTimes(const std::vector<T>& vec) const;
+
+	/// <summary>
+	/// Gram matrix, transpose of matrix times matrix, as a dense symmetric matrix
+	/// </summary>
+	/// <returns>Resultant numCols x numCols matrix</returns>
+	BasicMatrix<T> gram() const;
+
+	/// <summary>
+	/// Transpose of the matrix, which is also its CSC form
+	/// </summary>
+	/// <returns>Resultant sparse matrix</returns>
+	BasicSparseMatrix transpose() const;
+
+	/// <summary>
+	/// Get the number of rows
+	/// </summary>
+	/// <returns>Number of rows</returns>
+	inline size_t getNumOfRows() const { return m_numRows; }
+
+	/// <summary>
+	/// Get the number of columns
+	/// </summary>
+	/// <returns>Number of columns</returns>
+	inline size_t getNumOfCols() const { return m_numCols; }
+
+	/// <summary>
+	/// Get the number of stored non-zero elements
+	/// </summary>
+	/// <returns>Number of non-zeros</returns>
+	inline size_t getNumOfNonZeros() const { return m_values.size(); }
+
+	/// <summary>
+	/// Get the column indices of the non-zeros of a row
+	/// </summary>
+	/// <param name="i">Row index</param>
+	/// <returns>Span over the column indices</returns>
+	inline std::span<const size_t> rowIndices(const size_t i) const
+	{
+		return std::span<const size_t>(m_columnIndices.data() + m_rowPointers[i], m_rowPointers[i + 1] - m_rowPointers[i]);
+	}
+
+	/// <summary>
+	/// Get the values of the non-zeros of a row
+	/// </summary>
+	/// <param name="i">Row index</param>
+	/// <returns>Span over the values</returns>
+	inline std::span<const T> rowValues(const size_t i) const
+	{
+		return std::span<const T>(m_values.data() + m_rowPointers[i], m_rowPointers[i + 1] - m_rowPointers[i]);
+	}
+
+private:
+	// Number of rows
+	size_t m_numRows;
+
+	// Number of columns
+	size_t m_numCols;
+
+	// Start of each row in m_columnIndices and m_values, numRows + 1 elements
+	std::vector<size_t> m_rowPointers;
+
+	// Column index of each non-zero
+	std::vector<size_t> m_columnIndices;
+
+	// Value of each non-zero
+	std::vector<T> m_values;
+};
+
+extern template class BasicSparseMatrix<float>;
+extern template class BasicSparseMatrix<double>;
+
+using SparseMatrix = BasicSparseMatrix<double>;
+using SparseMatrixF = BasicSparseMatrix<float>;
+
+#endif // !SPARSE_MATRIX_H
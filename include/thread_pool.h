@@ -0,0 +1,128 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// <summary>
+/// Library-wide pool of worker threads used by the parallel kernels.
+/// The thread count comes from setNumThreads, else from the ML_NUM_THREADS
+/// environment variable, else from the number of hardware threads. The
+/// calling thread takes part in the work, so the pool holds one thread less
+/// than the thread count.
+/// Work submitted while the pool is already busy (nested calls, or several
+/// models trained in parallel by the caller) runs on the calling thread, so
+/// the library never runs more threads than the configured count plus the
+/// caller's own threads.
+/// </summary>
+class ThreadPool
+{
+public:
+	/// <summary>
+	/// Get the shared pool
+	/// </summary>
+	/// <returns>Thread pool</returns>
+	static ThreadPool& instance();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	~ThreadPool();
+
+	/// <summary>
+	/// Get the number of threads used for parallel work, including the caller
+	/// </summary>
+	/// <returns>Number of threads</returns>
+	size_t getNumThreads() const;
+
+	/// <summary>
+	/// Set the number of threads used for parallel work, including the caller.
+	/// Waits for running work to finish.
+	/// </summary>
+	/// <param name="numThreads">Number of threads, 0 for the hardware default</param>
+	void setNumThreads(size_t numThreads);
+
+	/// <summary>
+	/// Run body over [begin, end) split into consecutive chunks of grain
+	/// elements (the last chunk may be shorter). The split depends only on
+	/// grain, never on the thread count. Returns when all chunks are done and
+	/// rethrows the first exception thrown by the body.
+	/// </summary>
+	/// <param name="begin">First index</param>
+	/// <param name="end">One past the last index</param>
+	/// <param name="grain">Number of indices per chunk</param>
+	/// <param name="body">Callable taking the chunk bounds (begin, end)</param>
+	void parallelFor(size_t begin, size_t end, size_t grain, const std::function<void(size_t, size_t)>& body);
+
+private:
+	ThreadPool();
+
+	struct Job;
+
+	void startWorkers(size_t numWorkers);
+
+	void stopWorkers();
+
+	void workerLoop();
+
+	static void runChunks(Job& job);
+
+	// Serialises submitted jobs, held for the whole of a parallel loop
+	std::mutex m_jobMutex;
+
+	// Guards the fields below
+	std::mutex m_mutex;
+
+	// Signals workers that a job was published or that they should stop
+	std::condition_variable m_workAvailable;
+
+	// Signals the submitting thread that workers left the job
+	std::condition_variable m_workDone;
+
+	// Worker threads, read and replaced with the job lock held
+	std::vector<std::thread> m_workers;
+
+	// Number of threads including the caller, readable without the job lock
+	std::atomic<size_t> m_numThreads;
+
+	// Job being executed, null when idle
+	Job* m_job;
+
+	// Incremented for every published job
+	size_t m_generation;
+
+	// Number of workers currently inside the job
+	size_t m_active;
+
+	// Set to stop the workers
+	bool m_stop;
+};
+
+/// <summary>
+/// Set the number of threads used by the library
+/// </summary>
+/// <param name="numThreads">Number of threads, 0 for the hardware default</param>
+void setNumThreads(size_t numThreads);
+
+/// <summary>
+/// Get the number of threads used by the library
+/// </summary>
+/// <returns>Number of threads</returns>
+size_t getNumThreads();
+
+/// <summary>
+/// Run body over [begin, end) in chunks of grain elements on the shared pool
+/// </summary>
+/// <param name="begin">First index</param>
+/// <param name="end">One past the last index</param>
+/// <param name="grain">Number of indices per chunk</param>
+/// <param name="body">Callable taking the chunk bounds (begin, end)</param>
+void parallelFor(size_t begin, size_t end, size_t grain, const std::function<void(size_t, size_t)>& body);
+
+#endif // !THREAD_POOL_H
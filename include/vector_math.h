@@ -0,0 +1,32 @@
+#ifndef VECTOR_MATH_H
+#define VECTOR_MATH_H
+
+#include <cstddef>
+
+/// <summary>
+/// Element-wise exponential, y[i] = exp(x[i]). x and y may be the same
+/// array. Uses AVX-512 or AVX2/FMA when the CPU supports them, with a
+/// range reduction by ln 2 and a polynomial accurate to a few ulp; results
+/// overflow to infinity and underflow to zero as std::exp does, and NaN is
+/// returned for NaN.
+/// Instantiated for float and double.
+/// </summary>
+/// <param name="x">Pointer to the input values</param>
+/// <param name="y">Pointer to the output values</param>
+/// <param name="n">Number of values</param>
+template <typename T>
+void vectorExp(const T* x, T* y, size_t n);
+
+/// <summary>
+/// Element-wise logistic sigmoid, y[i] = 1 / (1 + exp(-x[i])), with the
+/// kernels of vectorExp. x and y may be the same array. Results saturate
+/// to exactly 0 and 1 for large magnitudes, and NaN is returned for NaN.
+/// Instantiated for float and double.
+/// </summary>
+/// <param name="x">Pointer to the input values</param>
+/// <param name="y">Pointer to the output values</param>
+/// <param name="n">Number of values</param>
+template <typename T>
+void vectorSigmoid(const T* x, T* y, size_t n);
+
+#endif // !VECTOR_MATH_H
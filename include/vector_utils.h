@@ -1,90 +1,184 @@
 # ifndef VECTOR_UTILS_H
 # define VECTOR_UTILS_H
 
+#include <concepts>
+#include <cstddef>
+#include <functional>
+#include <span>
+#include <type_traits>
+#include <utility>
 #include <vector>
 #include <stdexcept>
 
+// The arithmetic operators below do not compute anything when called. They
+// return lightweight expression objects that record the operands, so that a
+// whole expression such as w - lr * g is evaluated element by element in a
+// single loop, without temporaries, when it is converted to a std::vector or
+// assigned with +=, -= or evaluateInto.
+
 /// <summary>
-/// Addition operator for subtracting two vectors
+/// Base class of the vector expression types
 /// </summary>
-/// <typeparam name="T"></typeparam>
-/// <param name="vec1">Vector 1</param>
-/// <param name="vec2">Vector 2</param>
-/// <returns>Resultant vector</returns>
+struct VectorExpressionBase {};
+
+template <typename T>
+struct IsStdVector : std::false_type {};
+
+template <typename T, typename A>
+struct IsStdVector<std::vector<T, A>> : std::true_type {};
+
 template <typename T>
-std::vector<T> operator+(const std::vector<T>& vec1, const std::vector<T>& vec2)
+struct IsVectorContainer : IsStdVector<T> {};
+
+template <typename T, size_t Extent>
+struct IsVectorContainer<std::span<T, Extent>> : std::true_type {};
+
+/// <summary>
+/// Operand of a vector expression: a std::vector, a std::span or another expression
+/// </summary>
+template <typename T>
+concept VectorOperand = IsVectorContainer<std::remove_cvref_t<T>>::value
+    || std::derived_from<std::remove_cvref_t<T>, VectorExpressionBase>;
+
+/// <summary>
+/// Scalar operand of a vector expression
+/// </summary>
+template <typename S>
+concept VectorScalar = std::is_arithmetic_v<std::remove_cvref_t<S>>;
+
+/// <summary>
+/// How an expression keeps an operand: named std::vectors by reference,
+/// temporaries (moved in), spans and sub-expressions by value
+/// </summary>
+template <typename A>
+using VectorOperandStorage = std::conditional_t<
+    std::is_lvalue_reference_v<A> && IsStdVector<std::remove_cvref_t<A>>::value,
+    const std::remove_cvref_t<A>&,
+    std::remove_cvref_t<A>>;
+
+/// <summary>
+/// Element type of a vector operand
+/// </summary>
+template <typename A>
+using VectorValueType = std::remove_cv_t<typename std::remove_cvref_t<A>::value_type>;
+
+/// <summary>
+/// Element-wise operation on two vector operands
+/// </summary>
+/// <typeparam name="L">Left operand</typeparam>
+/// <typeparam name="R">Right operand</typeparam>
+/// <typeparam name="Op">Binary operation</typeparam>
+template <typename L, typename R, typename Op>
+class VectorBinaryExpression : public VectorExpressionBase
 {
-    // Check if vectors have same size
-    if (vec1.size() != vec2.size())
+public:
+    using value_type = VectorValueType<L>;
+
+    VectorBinaryExpression(L&& lhs, R&& rhs)
+        :m_lhs(std::forward<L>(lhs)), m_rhs(std::forward<R>(rhs))
     {
-        // Throw an invalid argument exception
-        throw std::invalid_argument("Vectors must be of the same size.");
+        // Check if vectors have same size
+        if (m_lhs.size() != m_rhs.size())
+        {
+            // Throw an invalid argument exception
+            throw std::invalid_argument("Vectors must be of the same size.");
+        }
     }
 
-    // Get size of vector
-    size_t size = vec1.size();
+    inline size_t size() const { return m_lhs.size(); }
 
-    // Intialise resultant vector
-    std::vector<T> result(size);
+    inline value_type operator[](size_t i) const { return Op{}(m_lhs[i], m_rhs[i]); }
 
-    // Loop over elements
-    for (size_t i = 0; i < size; ++i)
+    /// <summary>
+    /// Evaluate the expression into a new vector
+    /// </summary>
+    operator std::vector<value_type>() const
     {
-        // Get the difference of elements
-        result[i] = vec1[i] + vec2[i];
+        std::vector<value_type> result(size());
+        for (size_t i = 0; i < result.size(); ++i) { result[i] = (*this)[i]; }
+        return result;
     }
 
-    // Return result
-    return result;
-}
+private:
+    VectorOperandStorage<L> m_lhs;
+    VectorOperandStorage<R> m_rhs;
+};
 
 /// <summary>
-/// Minus operator for subtracting two vectors
+/// Element-wise operation between a vector operand and a scalar
 /// </summary>
-/// <typeparam name="T"></typeparam>
-/// <param name="vec1">Vector 1</param>
-/// <param name="vec2">Vector 2</param>
-/// <returns>Resultant vector</returns>
-template <typename T>
-std::vector<T> operator-(const std::vector<T>& vec1, const std::vector<T>& vec2)
+/// <typeparam name="V">Vector operand</typeparam>
+/// <typeparam name="S">Scalar type</typeparam>
+/// <typeparam name="Op">Binary operation, applied as Op(element, scalar)</typeparam>
+template <typename V, typename S, typename Op>
+class VectorScalarExpression : public VectorExpressionBase
 {
-    // Check if vectors have same size
-    if (vec1.size() != vec2.size())
-    {
-        // Throw an invalid argument exception
-        throw std::invalid_argument("Vectors must be of the same size.");
-    }
+public:
+    using value_type = VectorValueType<V>;
 
-    // Get size of vector
-    size_t size = vec1.size();
+    VectorScalarExpression(V&& vec, S val)
+        :m_vec(std::forward<V>(vec)), m_val(val) { }
 
-    // Intialise resultant vector
-    std::vector<T> result(size);
+    inline size_t size() const { return m_vec.size(); }
 
-    // Loop over elements
-    for (size_t i = 0; i < size; ++i)
+    inline value_type operator[](size_t i) const { return static_cast<value_type>(Op{}(m_vec[i], m_val)); }
+
+    /// <summary>
+    /// Evaluate the expression into a new vector
+    /// </summary>
+    operator std::vector<value_type>() const
     {
-        // Get the difference of elements
-        result[i] = vec1[i] - vec2[i];
+        std::vector<value_type> result(size());
+        for (size_t i = 0; i < result.size(); ++i) { result[i] = (*this)[i]; }
+        return result;
     }
 
-    // Return result
-    return result;
+private:
+    VectorOperandStorage<V> m_vec;
+    std::remove_cvref_t<S> m_val;
+};
+
+/// <summary>
+/// Addition operator for adding two vectors
+/// </summary>
+/// <typeparam name="A"></typeparam>
+/// <typeparam name="B"></typeparam>
+/// <param name="vec1">Vector 1</param>
+/// <param name="vec2">Vector 2</param>
+/// <returns>Expression for the resultant vector</returns>
+template <VectorOperand A, VectorOperand B>
+auto operator+(A&& vec1, B&& vec2)
+{
+    return VectorBinaryExpression<A, B, std::plus<>>(std::forward<A>(vec1), std::forward<B>(vec2));
+}
+
+/// <summary>
+/// Minus operator for subtracting two vectors
+/// </summary>
+/// <typeparam name="A"></typeparam>
+/// <typeparam name="B"></typeparam>
+/// <param name="vec1">Vector 1</param>
+/// <param name="vec2">Vector 2</param>
+/// <returns>Expression for the resultant vector</returns>
+template <VectorOperand A, VectorOperand B>
+auto operator-(A&& vec1, B&& vec2)
+{
+    return VectorBinaryExpression<A, B, std::minus<>>(std::forward<A>(vec1), std::forward<B>(vec2));
 }
 
 /// <summary>
 /// Division operator for dividing vector using a value
 /// </summary>
-/// <typeparam name="T"></typeparam>
+/// <typeparam name="V"></typeparam>
 /// <typeparam name="S"></typeparam>
 /// <param name="vec">Input vecctor</param>
 /// <param name="val">Input value</param>
-/// <returns>Resultant vector</returns>
-template <typename T, typename S>
-std::vector<T> operator/(const std::vector<T>& vec, S val)
+/// <returns>Expression for the resultant vector</returns>
+template <VectorOperand V, VectorScalar S>
+auto operator/(V&& vec, S val)
 {
     // Check if vector is empty
-    if (vec.empty())
+    if (vec.size() == 0)
     {
         // Throw an invalid argument exception
         throw std::invalid_argument("Vector must not be empty.");
@@ -96,69 +190,124 @@ std::vector<T> operator/(const std::vector<T>& vec, S val)
         throw std::invalid_argument("Cannot divide by zero.");
     }
 
-    // Get size of vector
-    size_t size = vec.size();
-
-    // Intialise resultant vector
-    std::vector<T> result(size);
-
-    // Loop over elements
-    for (size_t i = 0; i < size; ++i)
-    {
-        // Divide each element by value
-        result[i] = vec[i]/val;
-    }
-
-    // Return the result
-    return result;
+    return VectorScalarExpression<V, S, std::divides<>>(std::forward<V>(vec), val);
 }
 
 /// <summary>
 /// Multiplication operator for multiplying vector by a value
 /// </summary>
-/// <typeparam name="T"></typeparam>
+/// <typeparam name="V"></typeparam>
+/// <typeparam name="S"></typeparam>
 /// <param name="vec">Input vector</param>
 /// <param name="val">Input value</param>
-/// <returns>Resultant vector</returns>
-template<typename T>
-std::vector<T> operator*(const std::vector<T> vec, T val)
+/// <returns>Expression for the resultant vector</returns>
+template <VectorOperand V, VectorScalar S>
+auto operator*(V&& vec, S val)
 {
     // Check if vector is empty
-    if (vec.empty())
+    if (vec.size() == 0)
     {
         // Throw an invalid argument exception
         throw std::invalid_argument("Vector must not be empty.");
     }
 
-    // Get size of vector
-    size_t size = vec.size();
+    return VectorScalarExpression<V, S, std::multiplies<>>(std::forward<V>(vec), val);
+}
 
-    // Intialise resultant vector
-    std::vector<T> result(size);
+/// <summary>
+/// Multiplication operator for multiplying vector by a value
+/// </summary>
+/// <typeparam name="S"></typeparam>
+/// <typeparam name="V"></typeparam>
+/// <param name="val">Input value</param>
+/// <param name="vec">Input vector</param>
+/// <returns>Expression for the resultant vector</returns>
+template <VectorScalar S, VectorOperand V>
+auto operator*(S val, V&& vec)
+{
+    // Call the other multiplication operator and return the expression
+    return std::forward<V>(vec) * val;
+}
 
-    // Loop over elements
-    for (size_t i = 0; i < size; ++i)
+/// <summary>
+/// Evaluate an expression into an existing vector, element by element and in
+/// place. The destination may also appear as an operand of the expression.
+/// </summary>
+/// <typeparam name="T"></typeparam>
+/// <typeparam name="Alloc"></typeparam>
+/// <typeparam name="E"></typeparam>
+/// <param name="dest">Destination vector</param>
+/// <param name="expr">Input expression</param>
+/// <returns>Destination vector</returns>
+template <typename T, typename Alloc, VectorOperand E>
+std::vector<T, Alloc>& evaluateInto(std::vector<T, Alloc>& dest, E&& expr)
+{
+    // A destination of a different size cannot be an operand, so it is safe to resize
+    if (dest.size() != expr.size())
+    {
+        dest.resize(expr.size());
+    }
+
+    for (size_t i = 0; i < dest.size(); ++i)
     {
-        // Multiply each element by value
-        result[i] = val * vec[i];
+        dest[i] = expr[i];
     }
 
-    // Return the result
-    return result;
+    return dest;
 }
 
 /// <summary>
-/// Multiplication operator for multiplying vector by a value
+/// Addition assignment operator, adds a vector or expression in place
 /// </summary>
 /// <typeparam name="T"></typeparam>
-/// <param name="val">Input value</param>
-/// <param name="vec">Input vector</param>
-/// <returns>Resultant vector</returns>
-template<typename T>
-std::vector<T> operator*(T val, const std::vector<T> vec)
+/// <typeparam name="Alloc"></typeparam>
+/// <typeparam name="E"></typeparam>
+/// <param name="dest">Destination vector</param>
+/// <param name="expr">Input vector or expression</param>
+/// <returns>Destination vector</returns>
+template <typename T, typename Alloc, VectorOperand E>
+std::vector<T, Alloc>& operator+=(std::vector<T, Alloc>& dest, E&& expr)
+{
+    // Check if vectors have same size
+    if (dest.size() != expr.size())
+    {
+        // Throw an invalid argument exception
+        throw std::invalid_argument("Vectors must be of the same size.");
+    }
+
+    for (size_t i = 0; i < dest.size(); ++i)
+    {
+        dest[i] += expr[i];
+    }
+
+    return dest;
+}
+
+/// <summary>
+/// Subtraction assignment operator, subtracts a vector or expression in place
+/// </summary>
+/// <typeparam name="T"></typeparam>
+/// <typeparam name="Alloc"></typeparam>
+/// <typeparam name="E"></typeparam>
+/// <param name="dest">Destination vector</param>
+/// <param name="expr">Input vector or expression</param>
+/// <returns>Destination vector</returns>
+template <typename T, typename Alloc, VectorOperand E>
+std::vector<T, Alloc>& operator-=(std::vector<T, Alloc>& dest, E&& expr)
 {
-    // Call the other multiplication operator and return the vector
-    return vec * val;
+    // Check if vectors have same size
+    if (dest.size() != expr.size())
+    {
+        // Throw an invalid argument exception
+        throw std::invalid_argument("Vectors must be of the same size.");
+    }
+
+    for (size_t i = 0; i < dest.size(); ++i)
+    {
+        dest[i] -= expr[i];
+    }
+
+    return dest;
 }
 
 #endif // !VECTOR_UTILS_H
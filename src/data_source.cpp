@@ -0,0 +1,103 @@
+#include "data_source.h"
+#include <stdexcept>
+#include <utility>
+
+template <typename T>
+BasicFileSource<T>::BasicFileSource(const std::string& path)
+	:m_file(path, std::ios::binary), m_header{}, m_nextFirst(0), m_nextCount(0)
+{
+	if (!m_file)
+	{
+		throw std::runtime_error("Cannot open dataset file: " + path);
+	}
+
+	m_file.seekg(0, std::ios::end);
+	const uint64_t size = static_cast<uint64_t>(m_file.tellg());
+	m_file.seekg(0);
+	m_file.read(reinterpret_cast<char*>(&m_header), sizeof(DatasetHeader));
+
+	validateDatasetHeader(m_header, size, path);
+
+	if (m_header.dataType != dataTypeOf<T>())
+	{
+		throw std::invalid_argument("Requested scalar type does not match the dataset.");
+	}
+}
+
+template <typename T>
+BasicFileSource<T>::~BasicFileSource()
+{
+	if (m_pending.valid())
+	{
+		m_pending.wait();
+	}
+}
+
+template <typename T>
+BasicMatrixView<T> BasicFileSource<T>::read(size_t first, size_t count)
+{
+	if (count == 0 || first > m_header.numRows || count > m_header.numRows - first)
+	{
+		throw std::invalid_argument("Rows out of range.");
+	}
+
+	if (m_pending.valid())
+	{
+		// Rethrows a failed background read
+		m_pending.get();
+	}
+
+	// A prefetched chunk stays available across reads of other rows
+	if (m_nextCount != 0 && m_nextFirst == first && m_nextCount == count)
+	{
+		std::swap(m_current, m_next);
+		m_nextCount = 0;
+		return BasicMatrixView<T>(m_current.data(), count, m_header.numCols, m_header.stride);
+	}
+
+	load(first, count, m_current);
+	return BasicMatrixView<T>(m_current.data(), count, m_header.numCols, m_header.stride);
+}
+
+template <typename T>
+void BasicFileSource<T>::prefetch(size_t first, size_t count)
+{
+	if (count == 0 || first > m_header.numRows || count > m_header.numRows - first)
+	{
+		return;
+	}
+
+	if (m_pending.valid())
+	{
+		m_pending.get();
+	}
+
+	// The range is recorded once the load succeeds, so a failed read leaves no chunk behind
+	m_nextCount = 0;
+	m_pending = std::async(std::launch::async, [this, first, count]()
+	{
+		load(first, count, m_next);
+		m_nextFirst = first;
+		m_nextCount = count;
+	});
+}
+
+template <typename T>
+void BasicFileSource<T>::load(size_t first, size_t count, std::vector<T>& buffer)
+{
+	// Rows are read with the padding between them, in one request
+	const size_t elements = (count - 1) * m_header.stride + m_header.numCols;
+	buffer.resize(elements);
+
+	m_file.seekg(static_cast<std::streamoff>(m_header.dataOffset + first * m_header.stride * sizeof(T)));
+	m_file.read(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(elements * sizeof(T)));
+
+	if (!m_file)
+	{
+		m_file.clear();
+		throw std::runtime_error("Failed to read dataset file.");
+	}
+}
+
+template class BasicFileSource<float>;
+template class BasicFileSource<double>;
@@ -0,0 +1,334 @@
+#include "dataset.h"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+	constexpr char DatasetMagic[8] = { 'M', 'L', 'D', 'A', 'T', 'A', '\0', '\0' };
+
+	// Byte order mark as read from a file written in the other byte order
+	constexpr uint32_t SwappedByteOrderMark = 0x04030201;
+}
+
+void validateDatasetHeader(const DatasetHeader& header, uint64_t fileSize, const std::string& path)
+{
+	const size_t elementSize = header.dataType == DataType::Float32 ? sizeof(float) : sizeof(double);
+	const char* error = nullptr;
+
+	if (fileSize < sizeof(DatasetHeader) || std::memcmp(header.magic, DatasetMagic, sizeof(DatasetMagic)) != 0)
+	{
+		error = "Not a dataset file: ";
+	}
+	else if (header.byteOrder == SwappedByteOrderMark
+		|| (header.version == 1 && std::endian::native != std::endian::little))
+	{
+		error = "Dataset byte order does not match this machine: ";
+	}
+	else if (header.version != DatasetVersion && header.version != 1)
+	{
+		error = "Unsupported dataset version: ";
+	}
+	else if (header.version == DatasetVersion && header.byteOrder != DatasetByteOrderMark)
+	{
+		error = "Corrupt dataset header: ";
+	}
+	else if (header.dataType != DataType::Float32 && header.dataType != DataType::Float64)
+	{
+		error = "Unsupported dataset data type: ";
+	}
+	else if (header.stride < header.numCols || header.dataOffset < sizeof(DatasetHeader) || header.dataOffset % elementSize != 0)
+	{
+		error = "Corrupt dataset header: ";
+	}
+	else if (header.dataOffset > fileSize)
+	{
+		error = "Truncated dataset file: ";
+	}
+	else if (header.numRows != 0 && header.numCols != 0)
+	{
+		// The last row must end within the file
+		const uint64_t available = (fileSize - header.dataOffset) / elementSize;
+
+		if (header.numCols > available || (header.numRows - 1) > (available - header.numCols) / header.stride)
+		{
+			error = "Truncated dataset file: ";
+		}
+	}
+
+	if (error != nullptr)
+	{
+		throw std::runtime_error(error + path);
+	}
+}
+
+template <typename T>
+BasicDatasetWriter<T>::BasicDatasetWriter(const std::string& path, size_t numCols, size_t alignment)
+	:m_file(path, std::ios::binary | std::ios::trunc), m_header{}, m_numRows(0)
+{
+	if (alignment < sizeof(T) || (alignment & (alignment - 1)) != 0)
+	{
+		throw std::invalid_argument("Alignment must be a power of two of at least the element size.");
+	}
+	else if (!m_file)
+	{
+		throw std::runtime_error("Cannot open dataset file for writing: " + path);
+	}
+
+	std::memcpy(m_header.magic, DatasetMagic, sizeof(DatasetMagic));
+	m_header.version = DatasetVersion;
+	m_header.byteOrder = DatasetByteOrderMark;
+	m_header.dataType = dataTypeOf<T>();
+	m_header.numCols = numCols;
+	m_header.stride = numCols;
+	m_header.alignment = alignment;
+	m_header.dataOffset = (sizeof(DatasetHeader) + alignment - 1) / alignment * alignment;
+
+	// Placeholder header and padding, the header is rewritten on close
+	const std::vector<char> prefix(m_header.dataOffset, 0);
+	m_file.write(prefix.data(), prefix.size());
+}
+
+template <typename T>
+BasicDatasetWriter<T>::~BasicDatasetWriter()
+{
+	try
+	{
+		close();
+	}
+	catch (...)
+	{
+		// Errors are only reported by an explicit close
+	}
+}
+
+template <typename T>
+void BasicDatasetWriter<T>::append(std::span<const T> row)
+{
+	if (!m_file.is_open())
+	{
+		throw std::runtime_error("Dataset writer is closed.");
+	}
+	else if (row.size() != m_header.numCols)
+	{
+		throw std::invalid_argument("Row size must match the number of columns.");
+	}
+
+	m_file.write(reinterpret_cast<const char*>(row.data()), row.size_bytes());
+	++m_numRows;
+}
+
+template <typename T>
+void BasicDatasetWriter<T>::append(const BasicMatrixView<T>& rows)
+{
+	if (rows.getNumOfCols() != m_header.numCols)
+	{
+		throw std::invalid_argument("Number of columns must match the dataset.");
+	}
+
+	if (rows.getStride() == rows.getNumOfCols() && m_file.is_open())
+	{
+		// Densely packed rows are written in one go
+		m_file.write(reinterpret_cast<const char*>(rows.data()), rows.getNumOfRows() * rows.getNumOfCols() * sizeof(T));
+		m_numRows += rows.getNumOfRows();
+		return;
+	}
+
+	for (size_t i = 0; i < rows.getNumOfRows(); ++i)
+	{
+		append(rows.row(i));
+	}
+}
+
+template <typename T>
+void BasicDatasetWriter<T>::close()
+{
+	if (!m_file.is_open())
+	{
+		return;
+	}
+
+	m_header.numRows = m_numRows;
+	m_file.seekp(0);
+	m_file.write(reinterpret_cast<const char*>(&m_header), sizeof(DatasetHeader));
+
+	const bool failed = !m_file;
+	m_file.close();
+
+	if (failed || !m_file)
+	{
+		throw std::runtime_error("Failed to write dataset file.");
+	}
+}
+
+template <typename T>
+void writeDataset(const std::string& path, const BasicMatrixView<T>& X, size_t alignment)
+{
+	BasicDatasetWriter<T> writer(path, X.getNumOfCols(), alignment);
+	writer.append(X);
+	writer.close();
+}
+
+MappedDataset::MappedDataset(const std::string& path, DatasetAccess access)
+	:m_data(nullptr), m_size(0), m_header{}
+#ifdef _WIN32
+	, m_file(INVALID_HANDLE_VALUE), m_mapping(nullptr)
+#endif
+{
+#ifdef _WIN32
+	m_file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (m_file == INVALID_HANDLE_VALUE)
+	{
+		throw std::runtime_error("Cannot open dataset file: " + path);
+	}
+
+	LARGE_INTEGER size;
+	GetFileSizeEx(m_file, &size);
+	m_size = static_cast<size_t>(size.QuadPart);
+
+	if (m_size >= sizeof(DatasetHeader))
+	{
+		m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		m_data = m_mapping ? static_cast<const char*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0)) : nullptr;
+	}
+#else
+	const int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+	{
+		throw std::runtime_error("Cannot open dataset file: " + path);
+	}
+
+	struct stat info;
+	if (::fstat(fd, &info) == 0)
+	{
+		m_size = static_cast<size_t>(info.st_size);
+	}
+
+	if (m_size >= sizeof(DatasetHeader))
+	{
+		// Shared read-only mapping, backed directly by the page cache
+		void* mapped = ::mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0);
+		m_data = mapped == MAP_FAILED ? nullptr : static_cast<const char*>(mapped);
+	}
+
+	// The mapping keeps the file referenced
+	::close(fd);
+#endif
+
+	if (m_data == nullptr)
+	{
+		release();
+		throw std::runtime_error("Cannot map dataset file: " + path);
+	}
+
+	std::memcpy(&m_header, m_data, sizeof(DatasetHeader));
+
+	try
+	{
+		validateDatasetHeader(m_header, m_size, path);
+	}
+	catch (...)
+	{
+		release();
+		throw;
+	}
+
+#ifndef _WIN32
+	// Sequential advice drops the pages behind the reader, so it is only
+	// given for single passes; repeated and random reads keep the default
+	if (access == DatasetAccess::Sequential)
+	{
+		::madvise(const_cast<char*>(m_data), m_size, MADV_SEQUENTIAL);
+	}
+#else
+	(void)access;
+#endif
+}
+
+MappedDataset::MappedDataset(MappedDataset&& other) noexcept
+	:m_data(std::exchange(other.m_data, nullptr)), m_size(std::exchange(other.m_size, 0)), m_header(other.m_header)
+#ifdef _WIN32
+	, m_file(std::exchange(other.m_file, INVALID_HANDLE_VALUE)), m_mapping(std::exchange(other.m_mapping, nullptr))
+#endif
+{
+}
+
+MappedDataset& MappedDataset::operator=(MappedDataset&& other) noexcept
+{
+	if (this != &other)
+	{
+		release();
+
+		m_data = std::exchange(other.m_data, nullptr);
+		m_size = std::exchange(other.m_size, 0);
+		m_header = other.m_header;
+#ifdef _WIN32
+		m_file = std::exchange(other.m_file, INVALID_HANDLE_VALUE);
+		m_mapping = std::exchange(other.m_mapping, nullptr);
+#endif
+	}
+
+	return *this;
+}
+
+MappedDataset::~MappedDataset()
+{
+	release();
+}
+
+void MappedDataset::prefetch(size_t first, size_t count) const
+{
+	if (count == 0 || first >= m_header.numRows)
+	{
+		return;
+	}
+
+	const size_t elementSize = m_header.dataType == DataType::Float32 ? sizeof(float) : sizeof(double);
+	const size_t last = std::min<size_t>(m_header.numRows, first + count) - 1;
+	const size_t begin = m_header.dataOffset + first * m_header.stride * elementSize;
+	const size_t end = m_header.dataOffset + (last * m_header.stride + m_header.numCols) * elementSize;
+
+#ifdef _WIN32
+	WIN32_MEMORY_RANGE_ENTRY range{ const_cast<char*>(m_data + begin), end - begin };
+	PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#else
+	// The advice takes whole pages
+	const size_t pageSize = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+	const size_t pageBegin = begin / pageSize * pageSize;
+	::madvise(const_cast<char*>(m_data + pageBegin), end - pageBegin, MADV_WILLNEED);
+#endif
+}
+
+void MappedDataset::release()
+{
+#ifdef _WIN32
+	if (m_data != nullptr) { UnmapViewOfFile(m_data); }
+	if (m_mapping != nullptr) { CloseHandle(m_mapping); }
+	if (m_file != INVALID_HANDLE_VALUE) { CloseHandle(m_file); }
+	m_mapping = nullptr;
+	m_file = INVALID_HANDLE_VALUE;
+#else
+	if (m_data != nullptr) { ::munmap(const_cast<char*>(m_data), m_size); }
+#endif
+	m_data = nullptr;
+	m_size = 0;
+}
+
+template class BasicDatasetWriter<float>;
+template class BasicDatasetWriter<double>;
+template void writeDataset<float>(const std::string&, const BasicMatrixView<float>&, size_t);
+template void writeDataset<double>(const std::string&, const BasicMatrixView<double>&, size_t);
@@ -0,0 +1,681 @@
+#include "distance.h"
+#include <limits>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define ML_DISTANCE_X86 1
+#include <immintrin.h>
+#endif
+
+namespace
+{
+	template <typename T>
+	using SquaredKernel = T(*)(const T*, const T*, size_t);
+
+	template <typename T>
+	using CosineKernel = void(*)(const T*, const T*, size_t, T&, T&, T&);
+
+	template <typename T>
+	using ArgminKernel = size_t(*)(const T*, size_t);
+
+	/// <summary>
+	/// Portable squared distance, four independent accumulators
+	/// </summary>
+	template <typename T>
+	T squaredScalar(const T* a, const T* b, size_t n)
+	{
+		T s0 = T(0), s1 = T(0), s2 = T(0), s3 = T(0);
+		size_t j = 0;
+
+		for (; j + 4 <= n; j += 4)
+		{
+			const T d0 = a[j] - b[j], d1 = a[j + 1] - b[j + 1];
+			const T d2 = a[j + 2] - b[j + 2], d3 = a[j + 3] - b[j + 3];
+			s0 += d0 * d0; s1 += d1 * d1; s2 += d2 * d2; s3 += d3 * d3;
+		}
+		for (; j < n; ++j)
+		{
+			const T d = a[j] - b[j];
+			s0 += d * d;
+		}
+
+		return (s0 + s1) + (s2 + s3);
+	}
+
+	/// <summary>
+	/// Portable dot products a.b, a.a and b.b in one pass
+	/// </summary>
+	template <typename T>
+	void cosineScalar(const T* a, const T* b, size_t n, T& ab, T& aa, T& bb)
+	{
+		ab = aa = bb = T(0);
+		for (size_t j = 0; j < n; ++j)
+		{
+			ab += a[j] * b[j];
+			aa += a[j] * a[j];
+			bb += b[j] * b[j];
+		}
+	}
+
+	/// <summary>
+	/// Portable argmin
+	/// </summary>
+	template <typename T>
+	size_t argminScalar(const T* values, size_t n)
+	{
+		size_t result = 0;
+		for (size_t i = 1; i < n; ++i)
+		{
+			if (values[i] < values[result]) { result = i; }
+		}
+		return result;
+	}
+
+#ifdef ML_DISTANCE_X86
+	__attribute__((target("avx2,fma")))
+	inline double horizontalSum(__m256d v)
+	{
+		const __m128d sum = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+		return _mm_cvtsd_f64(_mm_add_sd(sum, _mm_unpackhi_pd(sum, sum)));
+	}
+
+	__attribute__((target("avx2,fma")))
+	inline float horizontalSum(__m256 v)
+	{
+		__m128 sum = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+		sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+		return _mm_cvtss_f32(_mm_add_ss(sum, _mm_movehdup_ps(sum)));
+	}
+
+	/// <summary>
+	/// AVX2/FMA squared distance for double, two accumulators of four lanes
+	/// </summary>
+	__attribute__((target("avx2,fma")))
+	double squaredAvx2(const double* a, const double* b, size_t n)
+	{
+		__m256d s0 = _mm256_setzero_pd(), s1 = _mm256_setzero_pd();
+		size_t j = 0;
+
+		for (; j + 8 <= n; j += 8)
+		{
+			const __m256d d0 = _mm256_sub_pd(_mm256_loadu_pd(a + j), _mm256_loadu_pd(b + j));
+			const __m256d d1 = _mm256_sub_pd(_mm256_loadu_pd(a + j + 4), _mm256_loadu_pd(b + j + 4));
+			s0 = _mm256_fmadd_pd(d0, d0, s0);
+			s1 = _mm256_fmadd_pd(d1, d1, s1);
+		}
+		for (; j + 4 <= n; j += 4)
+		{
+			const __m256d d = _mm256_sub_pd(_mm256_loadu_pd(a + j), _mm256_loadu_pd(b + j));
+			s0 = _mm256_fmadd_pd(d, d, s0);
+		}
+
+		double sum = horizontalSum(_mm256_add_pd(s0, s1));
+		for (; j < n; ++j)
+		{
+			const double d = a[j] - b[j];
+			sum += d * d;
+		}
+		return sum;
+	}
+
+	/// <summary>
+	/// AVX2/FMA squared distance for float, two accumulators of eight lanes
+	/// </summary>
+	__attribute__((target("avx2,fma")))
+	float squaredAvx2(const float* a, const float* b, size_t n)
+	{
+		__m256 s0 = _mm256_setzero_ps(), s1 = _mm256_setzero_ps();
+		size_t j = 0;
+
+		for (; j + 16 <= n; j += 16)
+		{
+			const __m256 d0 = _mm256_sub_ps(_mm256_loadu_ps(a + j), _mm256_loadu_ps(b + j));
+			const __m256 d1 = _mm256_sub_ps(_mm256_loadu_ps(a + j + 8), _mm256_loadu_ps(b + j + 8));
+			s0 = _mm256_fmadd_ps(d0, d0, s0);
+			s1 = _mm256_fmadd_ps(d1, d1, s1);
+		}
+		for (; j + 8 <= n; j += 8)
+		{
+			const __m256 d = _mm256_sub_ps(_mm256_loadu_ps(a + j), _mm256_loadu_ps(b + j));
+			s0 = _mm256_fmadd_ps(d, d, s0);
+		}
+
+		float sum = horizontalSum(_mm256_add_ps(s0, s1));
+		for (; j < n; ++j)
+		{
+			const float d = a[j] - b[j];
+			sum += d * d;
+		}
+		return sum;
+	}
+
+	/// <summary>
+	/// AVX2/FMA dot products for double
+	/// </summary>
+	__attribute__((target("avx2,fma")))
+	void cosineAvx2(const double* a, const double* b, size_t n, double& ab, double& aa, double& bb)
+	{
+		__m256d sab = _mm256_setzero_pd(), saa = _mm256_setzero_pd(), sbb = _mm256_setzero_pd();
+		size_t j = 0;
+
+		for (; j + 4 <= n; j += 4)
+		{
+			const __m256d va = _mm256_loadu_pd(a + j), vb = _mm256_loadu_pd(b + j);
+			sab = _mm256_fmadd_pd(va, vb, sab);
+			saa = _mm256_fmadd_pd(va, va, saa);
+			sbb = _mm256_fmadd_pd(vb, vb, sbb);
+		}
+
+		ab = horizontalSum(sab); aa = horizontalSum(saa); bb = horizontalSum(sbb);
+		for (; j < n; ++j)
+		{
+			ab += a[j] * b[j]; aa += a[j] * a[j]; bb += b[j] * b[j];
+		}
+	}
+
+	/// <summary>
+	/// AVX2/FMA dot products for float
+	/// </summary>
+	__attribute__((target("avx2,fma")))
+	void cosineAvx2(const float* a, const float* b, size_t n, float& ab, float& aa, float& bb)
+	{
+		__m256 sab = _mm256_setzero_ps(), saa = _mm256_setzero_ps(), sbb = _mm256_setzero_ps();
+		size_t j = 0;
+
+		for (; j + 8 <= n; j += 8)
+		{
+			const __m256 va = _mm256_loadu_ps(a + j), vb = _mm256_loadu_ps(b + j);
+			sab = _mm256_fmadd_ps(va, vb, sab);
+			saa = _mm256_fmadd_ps(va, va, saa);
+			sbb = _mm256_fmadd_ps(vb, vb, sbb);
+		}
+
+		ab = horizontalSum(sab); aa = horizontalSum(saa); bb = horizontalSum(sbb);
+		for (; j < n; ++j)
+		{
+			ab += a[j] * b[j]; aa += a[j] * a[j]; bb += b[j] * b[j];
+		}
+	}
+
+	/// <summary>
+	/// AVX2 argmin for double: the minimum over two accumulators of four
+	/// lanes, then the first block of four holding it
+	/// </summary>
+	__attribute__((target("avx2,fma")))
+	size_t argminAvx2(const double* values, size_t n)
+	{
+		if (n < 8)
+		{
+			return argminScalar(values, n);
+		}
+
+		__m256d m0 = _mm256_loadu_pd(values), m1 = _mm256_loadu_pd(values + 4);
+		size_t j = 8;
+
+		for (; j + 8 <= n; j += 8)
+		{
+			m0 = _mm256_min_pd(m0, _mm256_loadu_pd(values + j));
+			m1 = _mm256_min_pd(m1, _mm256_loadu_pd(values + j + 4));
+		}
+
+		m0 = _mm256_min_pd(m0, m1);
+		__m128d m = _mm_min_pd(_mm256_castpd256_pd128(m0), _mm256_extractf128_pd(m0, 1));
+		double best = _mm_cvtsd_f64(_mm_min_sd(m, _mm_unpackhi_pd(m, m)));
+		for (; j < n; ++j) { best = values[j] < best ? values[j] : best; }
+
+		const __m256d target = _mm256_set1_pd(best);
+		size_t i = 0;
+
+		for (; i + 4 <= n; i += 4)
+		{
+			const int mask = _mm256_movemask_pd(_mm256_cmp_pd(_mm256_loadu_pd(values + i), target, _CMP_EQ_OQ));
+			if (mask != 0) { return i + __builtin_ctz(mask); }
+		}
+		for (; values[i] != best; ++i) {}
+
+		return i;
+	}
+
+	/// <summary>
+	/// AVX2 argmin for float: the minimum over two accumulators of eight
+	/// lanes, then the first block of eight holding it
+	/// </summary>
+	__attribute__((target("avx2,fma")))
+	size_t argminAvx2(const float* values, size_t n)
+	{
+		if (n < 16)
+		{
+			return argminScalar(values, n);
+		}
+
+		__m256 m0 = _mm256_loadu_ps(values), m1 = _mm256_loadu_ps(values + 8);
+		size_t j = 16;
+
+		for (; j + 16 <= n; j += 16)
+		{
+			m0 = _mm256_min_ps(m0, _mm256_loadu_ps(values + j));
+			m1 = _mm256_min_ps(m1, _mm256_loadu_ps(values + j + 8));
+		}
+
+		m0 = _mm256_min_ps(m0, m1);
+		__m128 m = _mm_min_ps(_mm256_castps256_ps128(m0), _mm256_extractf128_ps(m0, 1));
+		m = _mm_min_ps(m, _mm_movehl_ps(m, m));
+		float best = _mm_cvtss_f32(_mm_min_ss(m, _mm_movehdup_ps(m)));
+		for (; j < n; ++j) { best = values[j] < best ? values[j] : best; }
+
+		const __m256 target = _mm256_set1_ps(best);
+		size_t i = 0;
+
+		for (; i + 8 <= n; i += 8)
+		{
+			const int mask = _mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(values + i), target, _CMP_EQ_OQ));
+			if (mask != 0) { return i + __builtin_ctz(mask); }
+		}
+		for (; values[i] != best; ++i) {}
+
+		return i;
+	}
+
+	/// <summary>
+	/// Half of an AVX-512 vector, by a zero-masked extract. GCC 12 implements
+	/// the plain extract, the 512 to 256 cast and _mm512_reduce_* with an
+	/// undefined source vector, which -Wall reports as uninitialized.
+	/// </summary>
+	template <int Half>
+	__attribute__((target("avx512f")))
+	inline __m256d extractHalf(__m512d v)
+	{
+		return _mm512_maskz_extractf64x4_pd(0xF, v, Half);
+	}
+
+	template <int Half>
+	__attribute__((target("avx512f")))
+	inline __m256 extractHalf(__m512 v)
+	{
+		return _mm256_castpd_ps(_mm512_maskz_extractf64x4_pd(0xF, _mm512_castps_pd(v), Half));
+	}
+
+	/// <summary>
+	/// Sum of the lanes of an AVX-512 vector
+	/// </summary>
+	__attribute__((target("avx512f")))
+	inline double horizontalSum(__m512d v)
+	{
+		return horizontalSum(_mm256_add_pd(extractHalf<0>(v), extractHalf<1>(v)));
+	}
+
+	__attribute__((target("avx512f")))
+	inline float horizontalSum(__m512 v)
+	{
+		return horizontalSum(_mm256_add_ps(extractHalf<0>(v), extractHalf<1>(v)));
+	}
+
+	/// <summary>
+	/// Minimum of the lanes of an AVX-512 vector
+	/// </summary>
+	__attribute__((target("avx512f")))
+	inline double horizontalMin(__m512d v)
+	{
+		const __m256d half = _mm256_min_pd(extractHalf<0>(v), extractHalf<1>(v));
+		const __m128d m = _mm_min_pd(_mm256_castpd256_pd128(half), _mm256_extractf128_pd(half, 1));
+		return _mm_cvtsd_f64(_mm_min_sd(m, _mm_unpackhi_pd(m, m)));
+	}
+
+	__attribute__((target("avx512f")))
+	inline float horizontalMin(__m512 v)
+	{
+		const __m256 half = _mm256_min_ps(extractHalf<0>(v), extractHalf<1>(v));
+		__m128 m = _mm_min_ps(_mm256_castps256_ps128(half), _mm256_extractf128_ps(half, 1));
+		m = _mm_min_ps(m, _mm_movehl_ps(m, m));
+		return _mm_cvtss_f32(_mm_min_ss(m, _mm_movehdup_ps(m)));
+	}
+
+	/// <summary>
+	/// AVX-512 squared distance for double, the tail handled by a masked load
+	/// </summary>
+	__attribute__((target("avx512f")))
+	double squaredAvx512(const double* a, const double* b, size_t n)
+	{
+		__m512d s0 = _mm512_setzero_pd(), s1 = _mm512_setzero_pd();
+		size_t j = 0;
+
+		for (; j + 16 <= n; j += 16)
+		{
+			const __m512d d0 = _mm512_sub_pd(_mm512_loadu_pd(a + j), _mm512_loadu_pd(b + j));
+			const __m512d d1 = _mm512_sub_pd(_mm512_loadu_pd(a + j + 8), _mm512_loadu_pd(b + j + 8));
+			s0 = _mm512_fmadd_pd(d0, d0, s0);
+			s1 = _mm512_fmadd_pd(d1, d1, s1);
+		}
+		for (; j < n; j += 8)
+		{
+			const __mmask8 mask = n - j >= 8 ? __mmask8(0xFF) : __mmask8((1u << (n - j)) - 1);
+			const __m512d d = _mm512_sub_pd(_mm512_maskz_loadu_pd(mask, a + j), _mm512_maskz_loadu_pd(mask, b + j));
+			s0 = _mm512_fmadd_pd(d, d, s0);
+		}
+
+		return horizontalSum(_mm512_add_pd(s0, s1));
+	}
+
+	/// <summary>
+	/// AVX-512 squared distance for float, the tail handled by a masked load
+	/// </summary>
+	__attribute__((target("avx512f")))
+	float squaredAvx512(const float* a, const float* b, size_t n)
+	{
+		__m512 s0 = _mm512_setzero_ps(), s1 = _mm512_setzero_ps();
+		size_t j = 0;
+
+		for (; j + 32 <= n; j += 32)
+		{
+			const __m512 d0 = _mm512_sub_ps(_mm512_loadu_ps(a + j), _mm512_loadu_ps(b + j));
+			const __m512 d1 = _mm512_sub_ps(_mm512_loadu_ps(a + j + 16), _mm512_loadu_ps(b + j + 16));
+			s0 = _mm512_fmadd_ps(d0, d0, s0);
+			s1 = _mm512_fmadd_ps(d1, d1, s1);
+		}
+		for (; j < n; j += 16)
+		{
+			const __mmask16 mask = n - j >= 16 ? __mmask16(0xFFFF) : __mmask16((1u << (n - j)) - 1);
+			const __m512 d = _mm512_sub_ps(_mm512_maskz_loadu_ps(mask, a + j), _mm512_maskz_loadu_ps(mask, b + j));
+			s0 = _mm512_fmadd_ps(d, d, s0);
+		}
+
+		return horizontalSum(_mm512_add_ps(s0, s1));
+	}
+
+	/// <summary>
+	/// AVX-512 dot products for double
+	/// </summary>
+	__attribute__((target("avx512f")))
+	void cosineAvx512(const double* a, const double* b, size_t n, double& ab, double& aa, double& bb)
+	{
+		__m512d sab = _mm512_setzero_pd(), saa = _mm512_setzero_pd(), sbb = _mm512_setzero_pd();
+
+		for (size_t j = 0; j < n; j += 8)
+		{
+			const __mmask8 mask = n - j >= 8 ? __mmask8(0xFF) : __mmask8((1u << (n - j)) - 1);
+			const __m512d va = _mm512_maskz_loadu_pd(mask, a + j), vb = _mm512_maskz_loadu_pd(mask, b + j);
+			sab = _mm512_fmadd_pd(va, vb, sab);
+			saa = _mm512_fmadd_pd(va, va, saa);
+			sbb = _mm512_fmadd_pd(vb, vb, sbb);
+		}
+
+		ab = horizontalSum(sab); aa = horizontalSum(saa); bb = horizontalSum(sbb);
+	}
+
+	/// <summary>
+	/// AVX-512 dot products for float
+	/// </summary>
+	__attribute__((target("avx512f")))
+	void cosineAvx512(const float* a, const float* b, size_t n, float& ab, float& aa, float& bb)
+	{
+		__m512 sab = _mm512_setzero_ps(), saa = _mm512_setzero_ps(), sbb = _mm512_setzero_ps();
+
+		for (size_t j = 0; j < n; j += 16)
+		{
+			const __mmask16 mask = n - j >= 16 ? __mmask16(0xFFFF) : __mmask16((1u << (n - j)) - 1);
+			const __m512 va = _mm512_maskz_loadu_ps(mask, a + j), vb = _mm512_maskz_loadu_ps(mask, b + j);
+			sab = _mm512_fmadd_ps(va, vb, sab);
+			saa = _mm512_fmadd_ps(va, va, saa);
+			sbb = _mm512_fmadd_ps(vb, vb, sbb);
+		}
+
+		ab = horizontalSum(sab); aa = horizontalSum(saa); bb = horizontalSum(sbb);
+	}
+
+	/// <summary>
+	/// AVX-512 argmin for double, the tail padded with the largest value by a masked load
+	/// </summary>
+	__attribute__((target("avx512f")))
+	size_t argminAvx512(const double* values, size_t n)
+	{
+		const __m512d padding = _mm512_set1_pd(std::numeric_limits<double>::max());
+		__m512d m = padding;
+
+		for (size_t j = 0; j < n; j += 8)
+		{
+			const __mmask8 mask = n - j >= 8 ? __mmask8(0xFF) : __mmask8((1u << (n - j)) - 1);
+			m = _mm512_mask_min_pd(m, 0xFF, m, _mm512_mask_loadu_pd(padding, mask, values + j));
+		}
+
+		const __m512d target = _mm512_set1_pd(horizontalMin(m));
+
+		for (size_t j = 0; j < n; j += 8)
+		{
+			const __mmask8 mask = n - j >= 8 ? __mmask8(0xFF) : __mmask8((1u << (n - j)) - 1);
+			const __mmask8 equal = _mm512_mask_cmp_pd_mask(mask, _mm512_maskz_loadu_pd(mask, values + j), target, _CMP_EQ_OQ);
+			if (equal != 0) { return j + __builtin_ctz(equal); }
+		}
+
+		return 0;
+	}
+
+	/// <summary>
+	/// AVX-512 argmin for float, the tail padded with the largest value by a masked load
+	/// </summary>
+	__attribute__((target("avx512f")))
+	size_t argminAvx512(const float* values, size_t n)
+	{
+		const __m512 padding = _mm512_set1_ps(std::numeric_limits<float>::max());
+		__m512 m = padding;
+
+		for (size_t j = 0; j < n; j += 16)
+		{
+			const __mmask16 mask = n - j >= 16 ? __mmask16(0xFFFF) : __mmask16((1u << (n - j)) - 1);
+			m = _mm512_mask_min_ps(m, 0xFFFF, m, _mm512_mask_loadu_ps(padding, mask, values + j));
+		}
+
+		const __m512 target = _mm512_set1_ps(horizontalMin(m));
+
+		for (size_t j = 0; j < n; j += 16)
+		{
+			const __mmask16 mask = n - j >= 16 ? __mmask16(0xFFFF) : __mmask16((1u << (n - j)) - 1);
+			const __mmask16 equal = _mm512_mask_cmp_ps_mask(mask, _mm512_maskz_loadu_ps(mask, values + j), target, _CMP_EQ_OQ);
+			if (equal != 0) { return j + __builtin_ctz(equal); }
+		}
+
+		return 0;
+	}
+#endif
+
+	/// <summary>
+	/// Squared distance kernel for the running CPU
+	/// </summary>
+	template <typename T>
+	SquaredKernel<T> selectSquaredKernel()
+	{
+#ifdef ML_DISTANCE_X86
+		if (__builtin_cpu_supports("avx512f"))
+		{
+			return static_cast<SquaredKernel<T>>(squaredAvx512);
+		}
+		if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+		{
+			return static_cast<SquaredKernel<T>>(squaredAvx2);
+		}
+#endif
+		return squaredScalar<T>;
+	}
+
+	/// <summary>
+	/// Cosine kernel for the running CPU
+	/// </summary>
+	template <typename T>
+	CosineKernel<T> selectCosineKernel()
+	{
+#ifdef ML_DISTANCE_X86
+		if (__builtin_cpu_supports("avx512f"))
+		{
+			return static_cast<CosineKernel<T>>(cosineAvx512);
+		}
+		if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+		{
+			return static_cast<CosineKernel<T>>(cosineAvx2);
+		}
+#endif
+		return cosineScalar<T>;
+	}
+
+	/// <summary>
+	/// Argmin kernel for the running CPU
+	/// </summary>
+	template <typename T>
+	ArgminKernel<T> selectArgminKernel()
+	{
+#ifdef ML_DISTANCE_X86
+		if (__builtin_cpu_supports("avx512f"))
+		{
+			return static_cast<ArgminKernel<T>>(argminAvx512);
+		}
+		if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+		{
+			return static_cast<ArgminKernel<T>>(argminAvx2);
+		}
+#endif
+		return argminScalar<T>;
+	}
+
+	/// <summary>
+	/// Fixed dimension kernel behind a runtime-sized signature
+	/// </summary>
+	template <size_t D, typename T>
+	T squaredFixed(const T* a, const T* b, size_t)
+	{
+		return squaredEuclideanDistance<D>(a, b);
+	}
+
+	/// <summary>
+	/// Closest row for a dimension known at compile time
+	/// </summary>
+	template <size_t D, typename T>
+	size_t nearestRowFixed(const T* x, const BasicMatrixView<T>& rows, T& best)
+	{
+		size_t result = 0;
+		best = std::numeric_limits<T>::max();
+
+		for (size_t i = 0; i < rows.getNumOfRows(); ++i)
+		{
+			const T dist = squaredEuclideanDistance<D>(x, rows.data() + i * rows.getStride());
+			if (dist < best)
+			{
+				best = dist;
+				result = i;
+			}
+		}
+
+		return result;
+	}
+
+	/// <summary>
+	/// Closest row for any dimension, through the SIMD kernel
+	/// </summary>
+	template <typename T>
+	size_t nearestRowGeneric(const T* x, const BasicMatrixView<T>& rows, T& best)
+	{
+		static const SquaredKernel<T> kernel = selectSquaredKernel<T>();
+
+		size_t result = 0;
+		best = std::numeric_limits<T>::max();
+
+		for (size_t i = 0; i < rows.getNumOfRows(); ++i)
+		{
+			const T dist = kernel(x, rows.data() + i * rows.getStride(), rows.getNumOfCols());
+			if (dist < best)
+			{
+				best = dist;
+				result = i;
+			}
+		}
+
+		return result;
+	}
+}
+
+template <typename T>
+T squaredEuclideanDistance(const T* a, const T* b, size_t n)
+{
+	static const SquaredKernel<T> kernel = selectSquaredKernel<T>();
+	return kernel(a, b, n);
+}
+
+template <typename T>
+T cosineDistance(const T* a, const T* b, size_t n)
+{
+	static const CosineKernel<T> kernel = selectCosineKernel<T>();
+
+	T ab, aa, bb;
+	kernel(a, b, n, ab, aa, bb);
+
+	if (aa == T(0) || bb == T(0))
+	{
+		return T(1);
+	}
+
+	return T(1) - ab / (std::sqrt(aa) * std::sqrt(bb));
+}
+
+template <typename T>
+SquaredDistanceFunction<T> squaredDistanceFunction(size_t dim)
+{
+	static const SquaredKernel<T> kernel = selectSquaredKernel<T>();
+
+	switch (dim)
+	{
+	case 2: return squaredFixed<2, T>;
+	case 3: return squaredFixed<3, T>;
+	case 4: return squaredFixed<4, T>;
+	case 8: return squaredFixed<8, T>;
+	case 16: return squaredFixed<16, T>;
+	default: return kernel;
+	}
+}
+
+template <typename T>
+size_t nearestRow(std::span<const T> x, const BasicMatrixView<T>& rows, T* squaredDistance)
+{
+	if (x.size() != rows.getNumOfCols())
+	{
+		throw std::invalid_argument("Point size must match the number of columns.");
+	}
+	else if (rows.getNumOfRows() == 0)
+	{
+		throw std::invalid_argument("There must be at least one row.");
+	}
+
+	T best;
+	size_t result;
+
+	// Dimension dispatch, hoisted out of the loop over rows
+	switch (x.size())
+	{
+	case 2: result = nearestRowFixed<2>(x.data(), rows, best); break;
+	case 3: result = nearestRowFixed<3>(x.data(), rows, best); break;
+	case 4: result = nearestRowFixed<4>(x.data(), rows, best); break;
+	case 8: result = nearestRowFixed<8>(x.data(), rows, best); break;
+	case 16: result = nearestRowFixed<16>(x.data(), rows, best); break;
+	default: result = nearestRowGeneric(x.data(), rows, best); break;
+	}
+
+	if (squaredDistance != nullptr)
+	{
+		*squaredDistance = best;
+	}
+
+	return result;
+}
+
+template <typename T>
+size_t argmin(const T* values, size_t n)
+{
+	static const ArgminKernel<T> kernel = selectArgminKernel<T>();
+	return kernel(values, n);
+}
+
+template float squaredEuclideanDistance<float>(const float*, const float*, size_t);
+template double squaredEuclideanDistance<double>(const double*, const double*, size_t);
+template float cosineDistance<float>(const float*, const float*, size_t);
+template double cosineDistance<double>(const double*, const double*, size_t);
+template SquaredDistanceFunction<float> squaredDistanceFunction<float>(size_t);
+template SquaredDistanceFunction<double> squaredDistanceFunction<double>(size_t);
+template size_t nearestRow<float>(std::span<const float>, const BasicMatrixView<float>&, float*);
+template size_t nearestRow<double>(std::span<const double>, const BasicMatrixView<double>&, double*);
+template size_t argmin<float>(const float*, size_t);
+template size_t argmin<double>(const double*, size_t);
@@ -0,0 +1,499 @@
+#include "factorization.h"
+#include "gemm.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace
+{
+	// Width of the block columns of the Cholesky factorization
+	constexpr size_t CholeskyBlock = 64;
+
+	// Width of the block columns of the LU factorization
+	constexpr size_t LUBlock = 64;
+
+	// Number of rows per parallel block of the row-wise updates
+	constexpr size_t RowGrain = 64;
+
+	// Number of columns per parallel block of the triangular solves
+	constexpr size_t ColumnGrain = 64;
+
+	/// <summary>
+	/// Unblocked Cholesky of the nb x nb diagonal block starting at a
+	/// </summary>
+	template <typename T>
+	void factorDiagonalBlock(T* a, size_t lda, size_t nb)
+	{
+		for (size_t j = 0; j < nb; ++j)
+		{
+			T* rowJ = a + j * lda;
+
+			T d = rowJ[j];
+			for (size_t p = 0; p < j; ++p) { d -= rowJ[p] * rowJ[p]; }
+
+			if (!(d > T(0)))
+			{
+				throw std::runtime_error("Matrix is not positive definite.");
+			}
+
+			const T l = std::sqrt(d);
+			rowJ[j] = l;
+
+			for (size_t i = j + 1; i < nb; ++i)
+			{
+				T* rowI = a + i * lda;
+
+				T s = rowI[j];
+				for (size_t p = 0; p < j; ++p) { s -= rowI[p] * rowJ[p]; }
+
+				rowI[j] = s / l;
+			}
+		}
+	}
+}
+
+template <typename T>
+BasicCholeskyFactorization<T>::BasicCholeskyFactorization(BasicMatrix<T> A)
+	:m_factor(std::move(A))
+{
+	const size_t n = m_factor.getNumOfRows();
+
+	if (n != m_factor.getNumOfCols())
+	{
+		throw std::invalid_argument("Cholesky factorization is only defined for square matrix.");
+	}
+
+	T* a = m_factor.data();
+	const size_t lda = m_factor.getStride();
+
+	for (size_t k0 = 0; k0 < n; k0 += CholeskyBlock)
+	{
+		const size_t nb = std::min(CholeskyBlock, n - k0);
+		const size_t kEnd = k0 + nb;
+
+		// 1. Factor the diagonal block, L11
+		factorDiagonalBlock(a + k0 * lda + k0, lda, nb);
+
+		if (kEnd == n)
+		{
+			break;
+		}
+
+		// 2. Panel below the diagonal block, L21 = A21 L11^-T, row by row
+		const T* l11 = a + k0 * lda + k0;
+		parallelFor(kEnd, n, RowGrain, [&](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; ++i)
+			{
+				T* r = a + i * lda + k0;
+				for (size_t j = 0; j < nb; ++j)
+				{
+					T s = r[j];
+					for (size_t p = 0; p < j; ++p) { s -= r[p] * l11[j * lda + p]; }
+					r[j] = s / l11[j * lda + j];
+				}
+			}
+		});
+
+		// 3. Trailing update of the lower triangle, A22 -= L21 L21^T, one block row at a time
+		const size_t numBlockRows = (n - kEnd + CholeskyBlock - 1) / CholeskyBlock;
+		parallelFor(0, numBlockRows, 1, [&](size_t b0, size_t b1)
+		{
+			for (size_t b = b0; b < b1; ++b)
+			{
+				const size_t i0 = kEnd + b * CholeskyBlock;
+				const size_t rows = std::min(CholeskyBlock, n - i0);
+
+				gemm<T>(Transpose::No, Transpose::Yes, rows, i0 + rows - kEnd, nb,
+					T(-1), a + i0 * lda + k0, lda, a + kEnd * lda + k0, lda,
+					T(1), a + i0 * lda + kEnd, lda);
+			}
+		});
+	}
+
+	// Clear the upper triangle so the stored matrix is exactly L
+	for (size_t i = 0; i < n; ++i)
+	{
+		std::fill(a + i * lda + i + 1, a + i * lda + n, T(0));
+	}
+}
+
+template <typename T>
+std::vector<T> BasicCholeskyFactorization<T>::solve(const std::vector<T>& b) const
+{
+	const size_t n = m_factor.getNumOfRows();
+
+	if (b.size() != n)
+	{
+		throw std::invalid_argument("Right hand side size does not match the matrix.");
+	}
+
+	const T* l = m_factor.data();
+	const size_t ldl = m_factor.getStride();
+	std::vector<T> x(b);
+
+	// Forward substitution, L y = b
+	for (size_t i = 0; i < n; ++i)
+	{
+		T s = x[i];
+		for (size_t p = 0; p < i; ++p) { s -= l[i * ldl + p] * x[p]; }
+		x[i] = s / l[i * ldl + i];
+	}
+
+	// Back substitution, L^T x = y, walking the columns of L^T as rows of L
+	for (size_t i = n; i-- > 0;)
+	{
+		x[i] /= l[i * ldl + i];
+		for (size_t p = 0; p < i; ++p) { x[p] -= l[i * ldl + p] * x[i]; }
+	}
+
+	return x;
+}
+
+template <typename T>
+BasicQRFactorization<T>::BasicQRFactorization(BasicMatrix<T> A)
+	:m_factor(std::move(A)), m_tau(m_factor.getNumOfCols(), T(0))
+{
+	const size_t m = m_factor.getNumOfRows();
+	const size_t n = m_factor.getNumOfCols();
+
+	if (m < n)
+	{
+		throw std::invalid_argument("QR factorization needs at least as many rows as columns.");
+	}
+
+	T* a = m_factor.data();
+	const size_t lda = m_factor.getStride();
+
+	// Householder vector and the product v^T A for the trailing columns
+	std::vector<T> v(m), w(n);
+
+	for (size_t k = 0; k < n; ++k)
+	{
+		// Norm of the column below and including the diagonal
+		T norm = T(0);
+		for (size_t i = k; i < m; ++i) { norm += a[i * lda + k] * a[i * lda + k]; }
+		norm = std::sqrt(norm);
+
+		if (norm == T(0))
+		{
+			m_tau[k] = T(0);
+			continue;
+		}
+
+		// Reflect the column onto -sign(x0) ||x|| e1 to avoid cancellation
+		const T x0 = a[k * lda + k];
+		const T alpha = x0 > T(0) ? -norm : norm;
+		const T v0 = x0 - alpha;
+
+		// v = x / v0, so that v[0] = 1 and H = I - tau v v^T
+		v[k] = T(1);
+		for (size_t i = k + 1; i < m; ++i) { v[i] = a[i * lda + k] / v0; }
+		const T tau = (alpha - x0) / alpha;
+
+		// Apply H to the trailing columns, A -= tau v (v^T A)
+		const size_t cols = n - k - 1;
+		if (cols > 0)
+		{
+			gemv<T>(Transpose::Yes, m - k, cols, T(1), a + k * lda + k + 1, lda, v.data() + k, T(0), w.data());
+
+			parallelFor(k, m, RowGrain, [&](size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; ++i)
+				{
+					const T scale = tau * v[i];
+					T* row = a + i * lda + k + 1;
+					for (size_t j = 0; j < cols; ++j) { row[j] -= scale * w[j]; }
+				}
+			});
+		}
+
+		// Store R on the diagonal and the Householder vector below it
+		a[k * lda + k] = alpha;
+		for (size_t i = k + 1; i < m; ++i) { a[i * lda + k] = v[i]; }
+		m_tau[k] = tau;
+	}
+}
+
+template <typename T>
+std::vector<T> BasicQRFactorization<T>::solve(const std::vector<T>& b) const
+{
+	const size_t m = m_factor.getNumOfRows();
+	const size_t n = m_factor.getNumOfCols();
+
+	if (b.size() != m)
+	{
+		throw std::invalid_argument("Right hand side size does not match the matrix.");
+	}
+
+	const T* a = m_factor.data();
+	const size_t lda = m_factor.getStride();
+	std::vector<T> qtb(b);
+
+	// Apply the reflectors in order, Q^T b
+	for (size_t k = 0; k < n; ++k)
+	{
+		if (m_tau[k] == T(0))
+		{
+			continue;
+		}
+
+		T s = qtb[k];
+		for (size_t i = k + 1; i < m; ++i) { s += a[i * lda + k] * qtb[i]; }
+		s *= m_tau[k];
+
+		qtb[k] -= s;
+		for (size_t i = k + 1; i < m; ++i) { qtb[i] -= s * a[i * lda + k]; }
+	}
+
+	// Back substitution, R x = (Q^T b)[0:n]
+	std::vector<T> x(n);
+	for (size_t i = n; i-- > 0;)
+	{
+		const T rii = a[i * lda + i];
+		if (rii == T(0))
+		{
+			throw std::runtime_error("Matrix is rank deficient.");
+		}
+
+		T s = qtb[i];
+		for (size_t j = i + 1; j < n; ++j) { s -= a[i * lda + j] * x[j]; }
+		x[i] = s / rii;
+	}
+
+	return x;
+}
+
+template <typename T>
+BasicMatrix<T> BasicQRFactorization<T>::getR() const
+{
+	const size_t n = m_factor.getNumOfCols();
+	BasicMatrix<T> r(n, n);
+
+	for (size_t i = 0; i < n; ++i)
+	{
+		for (size_t j = i; j < n; ++j) { r(i, j) = m_factor(i, j); }
+	}
+
+	return r;
+}
+
+template <typename T>
+BasicLUFactorization<T>::BasicLUFactorization(BasicMatrix<T> A)
+	:m_factor(std::move(A)), m_permutation(m_factor.getNumOfRows()), m_oddSwaps(false), m_singular(false)
+{
+	const size_t n = m_factor.getNumOfRows();
+
+	if (n == 0)
+	{
+		throw std::invalid_argument("Matrix is empty.");
+	}
+	else if (n != m_factor.getNumOfCols())
+	{
+		throw std::invalid_argument("LU factorization is only defined for square matrix.");
+	}
+
+	for (size_t i = 0; i < n; ++i) { m_permutation[i] = i; }
+
+	T* a = m_factor.data();
+	const size_t lda = m_factor.getStride();
+
+	for (size_t k0 = 0; k0 < n; k0 += LUBlock)
+	{
+		const size_t nb = std::min(LUBlock, n - k0);
+		const size_t kEnd = k0 + nb;
+
+		// 1. Factor the panel of columns [k0, kEnd) with partial pivoting.
+		// Whole rows are swapped, which also applies the swap to the
+		// finished L on the left and the not yet updated columns on the right.
+		for (size_t j = k0; j < kEnd; ++j)
+		{
+			size_t pivotRow = j;
+			T pivotAbs = std::abs(a[j * lda + j]);
+			for (size_t i = j + 1; i < n; ++i)
+			{
+				const T v = std::abs(a[i * lda + j]);
+				if (v > pivotAbs) { pivotAbs = v; pivotRow = i; }
+			}
+
+			if (pivotRow != j)
+			{
+				std::swap_ranges(a + j * lda, a + j * lda + n, a + pivotRow * lda);
+				std::swap(m_permutation[j], m_permutation[pivotRow]);
+				m_oddSwaps = !m_oddSwaps;
+			}
+
+			const T pivot = a[j * lda + j];
+			if (pivot == T(0))
+			{
+				// Nothing to eliminate in this column
+				m_singular = true;
+				continue;
+			}
+
+			// Multipliers and rank-1 update of the remaining panel columns
+			const T* rowJ = a + j * lda;
+			parallelFor(j + 1, n, RowGrain, [&](size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; ++i)
+				{
+					T* rowI = a + i * lda;
+					const T l = rowI[j] / pivot;
+					rowI[j] = l;
+					for (size_t c = j + 1; c < kEnd; ++c) { rowI[c] -= l * rowJ[c]; }
+				}
+			});
+		}
+
+		if (kEnd == n)
+		{
+			break;
+		}
+
+		// 2. Block row of U, U12 = L11^-1 A12, split over column chunks
+		const size_t cols = n - kEnd;
+		parallelFor(0, cols, ColumnGrain, [&](size_t c0, size_t c1)
+		{
+			for (size_t i = k0 + 1; i < kEnd; ++i)
+			{
+				T* rowI = a + i * lda + kEnd;
+				for (size_t p = k0; p < i; ++p)
+				{
+					const T l = a[i * lda + p];
+					const T* rowP = a + p * lda + kEnd;
+					for (size_t c = c0; c < c1; ++c) { rowI[c] -= l * rowP[c]; }
+				}
+			}
+		});
+
+		// 3. Trailing update, A22 -= L21 U12
+		gemm<T>(Transpose::No, Transpose::No, cols, cols, nb,
+			T(-1), a + kEnd * lda + k0, lda, a + k0 * lda + kEnd, lda,
+			T(1), a + kEnd * lda + kEnd, lda);
+	}
+}
+
+template <typename T>
+std::vector<T> BasicLUFactorization<T>::solve(const std::vector<T>& b) const
+{
+	const size_t n = m_factor.getNumOfRows();
+
+	if (b.size() != n)
+	{
+		throw std::invalid_argument("Right hand side size does not match the matrix.");
+	}
+	else if (m_singular)
+	{
+		throw std::runtime_error("Matrix is singular.");
+	}
+
+	const T* a = m_factor.data();
+	const size_t lda = m_factor.getStride();
+
+	// Permute, P b
+	std::vector<T> x(n);
+	for (size_t i = 0; i < n; ++i) { x[i] = b[m_permutation[i]]; }
+
+	// Forward substitution with unit diagonal, L y = P b
+	for (size_t i = 0; i < n; ++i)
+	{
+		T s = x[i];
+		for (size_t p = 0; p < i; ++p) { s -= a[i * lda + p] * x[p]; }
+		x[i] = s;
+	}
+
+	// Back substitution, U x = y
+	for (size_t i = n; i-- > 0;)
+	{
+		T s = x[i];
+		for (size_t p = i + 1; p < n; ++p) { s -= a[i * lda + p] * x[p]; }
+		x[i] = s / a[i * lda + i];
+	}
+
+	return x;
+}
+
+template <typename T>
+BasicMatrix<T> BasicLUFactorization<T>::solve(const BasicMatrix<T>& B) const
+{
+	const size_t n = m_factor.getNumOfRows();
+	const size_t cols = B.getNumOfCols();
+
+	if (B.getNumOfRows() != n)
+	{
+		throw std::invalid_argument("Right hand side size does not match the matrix.");
+	}
+	else if (m_singular)
+	{
+		throw std::runtime_error("Matrix is singular.");
+	}
+
+	const T* a = m_factor.data();
+	const size_t lda = m_factor.getStride();
+
+	// Permute the rows, P B
+	BasicMatrix<T> X(n, cols);
+	for (size_t i = 0; i < n; ++i)
+	{
+		const auto src = B.row(m_permutation[i]);
+		std::copy(src.begin(), src.end(), X.row(i).begin());
+	}
+
+	T* x = X.data();
+	const size_t ldx = X.getStride();
+
+	// Substitute with whole rows of X, each chunk of columns independently
+	parallelFor(0, cols, ColumnGrain, [&](size_t c0, size_t c1)
+	{
+		// L Y = P B
+		for (size_t i = 1; i < n; ++i)
+		{
+			T* rowI = x + i * ldx;
+			for (size_t p = 0; p < i; ++p)
+			{
+				const T l = a[i * lda + p];
+				const T* rowP = x + p * ldx;
+				for (size_t c = c0; c < c1; ++c) { rowI[c] -= l * rowP[c]; }
+			}
+		}
+
+		// U X = Y
+		for (size_t i = n; i-- > 0;)
+		{
+			T* rowI = x + i * ldx;
+			for (size_t p = i + 1; p < n; ++p)
+			{
+				const T u = a[i * lda + p];
+				const T* rowP = x + p * ldx;
+				for (size_t c = c0; c < c1; ++c) { rowI[c] -= u * rowP[c]; }
+			}
+
+			const T pivot = a[i * lda + i];
+			for (size_t c = c0; c < c1; ++c) { rowI[c] /= pivot; }
+		}
+	});
+
+	return X;
+}
+
+template <typename T>
+T BasicLUFactorization<T>::determinant() const
+{
+	if (m_singular)
+	{
+		return T(0);
+	}
+
+	T det = m_oddSwaps ? T(-1) : T(1);
+	for (size_t i = 0; i < m_factor.getNumOfRows(); ++i) { det *= m_factor(i, i); }
+
+	return det;
+}
+
+template class BasicCholeskyFactorization<float>;
+template class BasicCholeskyFactorization<double>;
+template class BasicQRFactorization<float>;
+template class BasicQRFactorization<double>;
+template class BasicLUFactorization<float>;
+template class BasicLUFactorization<double>;
@@ -0,0 +1,797 @@
+#include "gemm.h"
+#include "aligned_allocator.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <vector>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define ML_GEMM_X86 1
+#include <immintrin.h>
+#endif
+
+namespace
+{
+	/// <summary>
+	/// Register and cache blocking per scalar type. The micro-kernel computes an
+	/// MR x NR block of C; an MC x KC panel of A stays in L2 and a KC x NR sliver
+	/// of B in L1.
+	/// </summary>
+	template <typename T>
+	struct Blocking;
+
+	template <>
+	struct Blocking<double>
+	{
+		static constexpr size_t MR = 6, NR = 8, MC = 120, KC = 256, NC = 2048;
+	};
+
+	template <>
+	struct Blocking<float>
+	{
+		static constexpr size_t MR = 6, NR = 16, MC = 120, KC = 256, NC = 4096;
+	};
+
+	// Products with fewer multiply-adds than this run on the calling thread
+	constexpr double ParallelThreshold = 64.0 * 64.0 * 64.0;
+
+	// Smallest number of B micro-panels given to one task
+	constexpr size_t MinPanelsPerTask = 4;
+
+	// Number of multiply-adds per parallel block of a matrix-vector product
+	constexpr size_t GemvBlockSize = 1 << 16;
+
+	// Upper bound on the row blocks reduced by A^T x and A^T A
+	constexpr size_t MaxReductionBlocks = 64;
+
+	// Upper bound on the elements of the partial results of A^T A
+	constexpr size_t MaxPartialElements = 1 << 20;
+
+	// Side of the square C tiles computed by syrk, a multiple of all MR and NR
+	constexpr size_t SyrkTile = 96;
+
+	// Smallest number of rows of A per syrk block
+	constexpr size_t SyrkMinBlockRows = 2048;
+
+	template <typename T>
+	using Buffer = std::vector<T, AlignedAllocator<T>>;
+
+	/// <summary>
+	/// Element of op(X) at row i, column j
+	/// </summary>
+	template <typename T>
+	inline T at(const T* x, size_t ld, bool trans, size_t i, size_t j)
+	{
+		return trans ? x[j * ld + i] : x[i * ld + j];
+	}
+
+	/// <summary>
+	/// Pack an mc x kc block of op(A) into micro-panels of MR rows,
+	/// each stored column by column and zero padded to MR rows
+	/// </summary>
+	template <typename T>
+	void packA(const T* a, size_t lda, bool trans, size_t mc, size_t kc, T* dst)
+	{
+		constexpr size_t MR = Blocking<T>::MR;
+
+		for (size_t i0 = 0; i0 < mc; i0 += MR)
+		{
+			const size_t rows = std::min(MR, mc - i0);
+
+			for (size_t p = 0; p < kc; ++p)
+			{
+				size_t r = 0;
+				for (; r < rows; ++r) { *dst++ = at(a, lda, trans, i0 + r, p); }
+				for (; r < MR; ++r) { *dst++ = T(0); }
+			}
+		}
+	}
+
+	/// <summary>
+	/// Pack a kc x nc block of op(B) into micro-panels of NR columns,
+	/// each stored row by row and zero padded to NR columns
+	/// </summary>
+	template <typename T>
+	void packB(const T* b, size_t ldb, bool trans, size_t kc, size_t nc, T* dst)
+	{
+		constexpr size_t NR = Blocking<T>::NR;
+
+		for (size_t j0 = 0; j0 < nc; j0 += NR)
+		{
+			const size_t cols = std::min(NR, nc - j0);
+
+			for (size_t p = 0; p < kc; ++p)
+			{
+				size_t c = 0;
+				for (; c < cols; ++c) { *dst++ = at(b, ldb, trans, p, j0 + c); }
+				for (; c < NR; ++c) { *dst++ = T(0); }
+			}
+		}
+	}
+
+	/// <summary>
+	/// Portable micro-kernel, ab = A sliver * B sliver
+	/// </summary>
+	template <typename T>
+	void kernelScalar(size_t kc, const T* a, const T* b, T* ab)
+	{
+		constexpr size_t MR = Blocking<T>::MR, NR = Blocking<T>::NR;
+		T acc[MR * NR] = {};
+
+		for (size_t p = 0; p < kc; ++p)
+		{
+			for (size_t r = 0; r < MR; ++r)
+			{
+				const T ar = a[r];
+				for (size_t c = 0; c < NR; ++c) { acc[r * NR + c] += ar * b[c]; }
+			}
+			a += MR;
+			b += NR;
+		}
+
+		std::copy(acc, acc + MR * NR, ab);
+	}
+
+#ifdef ML_GEMM_X86
+	/// <summary>
+	/// AVX2/FMA micro-kernel, ab = A sliver * B sliver, with the whole
+	/// 6 x 8 tile held in twelve ymm accumulators
+	/// </summary>
+	__attribute__((target("avx2,fma")))
+	void kernelAvx2(size_t kc, const double* a, const double* b, double* ab)
+	{
+		constexpr size_t MR = Blocking<double>::MR, NR = Blocking<double>::NR;
+
+		__m256d c00 = _mm256_setzero_pd(), c01 = _mm256_setzero_pd();
+		__m256d c10 = _mm256_setzero_pd(), c11 = _mm256_setzero_pd();
+		__m256d c20 = _mm256_setzero_pd(), c21 = _mm256_setzero_pd();
+		__m256d c30 = _mm256_setzero_pd(), c31 = _mm256_setzero_pd();
+		__m256d c40 = _mm256_setzero_pd(), c41 = _mm256_setzero_pd();
+		__m256d c50 = _mm256_setzero_pd(), c51 = _mm256_setzero_pd();
+
+		for (size_t p = 0; p < kc; ++p)
+		{
+			const __m256d b0 = _mm256_load_pd(b);
+			const __m256d b1 = _mm256_load_pd(b + 4);
+			__m256d ar;
+
+			ar = _mm256_broadcast_sd(a + 0);
+			c00 = _mm256_fmadd_pd(ar, b0, c00); c01 = _mm256_fmadd_pd(ar, b1, c01);
+			ar = _mm256_broadcast_sd(a + 1);
+			c10 = _mm256_fmadd_pd(ar, b0, c10); c11 = _mm256_fmadd_pd(ar, b1, c11);
+			ar = _mm256_broadcast_sd(a + 2);
+			c20 = _mm256_fmadd_pd(ar, b0, c20); c21 = _mm256_fmadd_pd(ar, b1, c21);
+			ar = _mm256_broadcast_sd(a + 3);
+			c30 = _mm256_fmadd_pd(ar, b0, c30); c31 = _mm256_fmadd_pd(ar, b1, c31);
+			ar = _mm256_broadcast_sd(a + 4);
+			c40 = _mm256_fmadd_pd(ar, b0, c40); c41 = _mm256_fmadd_pd(ar, b1, c41);
+			ar = _mm256_broadcast_sd(a + 5);
+			c50 = _mm256_fmadd_pd(ar, b0, c50); c51 = _mm256_fmadd_pd(ar, b1, c51);
+
+			a += MR;
+			b += NR;
+		}
+
+		_mm256_store_pd(ab + 0 * NR, c00); _mm256_store_pd(ab + 0 * NR + 4, c01);
+		_mm256_store_pd(ab + 1 * NR, c10); _mm256_store_pd(ab + 1 * NR + 4, c11);
+		_mm256_store_pd(ab + 2 * NR, c20); _mm256_store_pd(ab + 2 * NR + 4, c21);
+		_mm256_store_pd(ab + 3 * NR, c30); _mm256_store_pd(ab + 3 * NR + 4, c31);
+		_mm256_store_pd(ab + 4 * NR, c40); _mm256_store_pd(ab + 4 * NR + 4, c41);
+		_mm256_store_pd(ab + 5 * NR, c50); _mm256_store_pd(ab + 5 * NR + 4, c51);
+	}
+
+	/// <summary>
+	/// AVX2/FMA micro-kernel for float, the 6 x 16 tile in twelve ymm accumulators
+	/// </summary>
+	__attribute__((target("avx2,fma")))
+	void kernelAvx2(size_t kc, const float* a, const float* b, float* ab)
+	{
+		constexpr size_t MR = Blocking<float>::MR, NR = Blocking<float>::NR;
+
+		__m256 c00 = _mm256_setzero_ps(), c01 = _mm256_setzero_ps();
+		__m256 c10 = _mm256_setzero_ps(), c11 = _mm256_setzero_ps();
+		__m256 c20 = _mm256_setzero_ps(), c21 = _mm256_setzero_ps();
+		__m256 c30 = _mm256_setzero_ps(), c31 = _mm256_setzero_ps();
+		__m256 c40 = _mm256_setzero_ps(), c41 = _mm256_setzero_ps();
+		__m256 c50 = _mm256_setzero_ps(), c51 = _mm256_setzero_ps();
+
+		for (size_t p = 0; p < kc; ++p)
+		{
+			const __m256 b0 = _mm256_load_ps(b);
+			const __m256 b1 = _mm256_load_ps(b + 8);
+			__m256 ar;
+
+			ar = _mm256_broadcast_ss(a + 0);
+			c00 = _mm256_fmadd_ps(ar, b0, c00); c01 = _mm256_fmadd_ps(ar, b1, c01);
+			ar = _mm256_broadcast_ss(a + 1);
+			c10 = _mm256_fmadd_ps(ar, b0, c10); c11 = _mm256_fmadd_ps(ar, b1, c11);
+			ar = _mm256_broadcast_ss(a + 2);
+			c20 = _mm256_fmadd_ps(ar, b0, c20); c21 = _mm256_fmadd_ps(ar, b1, c21);
+			ar = _mm256_broadcast_ss(a + 3);
+			c30 = _mm256_fmadd_ps(ar, b0, c30); c31 = _mm256_fmadd_ps(ar, b1, c31);
+			ar = _mm256_broadcast_ss(a + 4);
+			c40 = _mm256_fmadd_ps(ar, b0, c40); c41 = _mm256_fmadd_ps(ar, b1, c41);
+			ar = _mm256_broadcast_ss(a + 5);
+			c50 = _mm256_fmadd_ps(ar, b0, c50); c51 = _mm256_fmadd_ps(ar, b1, c51);
+
+			a += MR;
+			b += NR;
+		}
+
+		_mm256_store_ps(ab + 0 * NR, c00); _mm256_store_ps(ab + 0 * NR + 8, c01);
+		_mm256_store_ps(ab + 1 * NR, c10); _mm256_store_ps(ab + 1 * NR + 8, c11);
+		_mm256_store_ps(ab + 2 * NR, c20); _mm256_store_ps(ab + 2 * NR + 8, c21);
+		_mm256_store_ps(ab + 3 * NR, c30); _mm256_store_ps(ab + 3 * NR + 8, c31);
+		_mm256_store_ps(ab + 4 * NR, c40); _mm256_store_ps(ab + 4 * NR + 8, c41);
+		_mm256_store_ps(ab + 5 * NR, c50); _mm256_store_ps(ab + 5 * NR + 8, c51);
+	}
+#endif
+
+	template <typename T>
+	using Kernel = void (*)(size_t, const T*, const T*, T*);
+
+	/// <summary>
+	/// Select the fastest micro-kernel supported by the running CPU
+	/// </summary>
+	template <typename T>
+	Kernel<T> selectKernel()
+	{
+#ifdef ML_GEMM_X86
+		if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+		{
+			return static_cast<Kernel<T>>(kernelAvx2);
+		}
+#endif
+		return kernelScalar<T>;
+	}
+
+	template <typename T>
+	using GemvKernel = void(*)(size_t, size_t, T, const T*, size_t, const T*, T, T*);
+
+	/// <summary>
+	/// Portable dot product, four independent sums so that the additions
+	/// are not one dependency chain
+	/// </summary>
+	template <typename T>
+	T dotScalar(const T* a, const T* b, size_t n)
+	{
+		T s0 = T(0), s1 = T(0), s2 = T(0), s3 = T(0);
+		size_t j = 0;
+		for (; j + 4 <= n; j += 4)
+		{
+			s0 += a[j] * b[j]; s1 += a[j + 1] * b[j + 1];
+			s2 += a[j + 2] * b[j + 2]; s3 += a[j + 3] * b[j + 3];
+		}
+		for (; j < n; ++j) { s0 += a[j] * b[j]; }
+
+		return (s0 + s1) + (s2 + s3);
+	}
+
+	/// <summary>
+	/// Portable y = alpha * A x + beta * y for m rows, one dot product per row
+	/// </summary>
+	template <typename T>
+	void gemvScalar(size_t m, size_t n, T alpha, const T* a, size_t lda, const T* x, T beta, T* y)
+	{
+		for (size_t i = 0; i < m; ++i)
+		{
+			y[i] = alpha * dotScalar(a + i * lda, x, n) + (beta == T(0) ? T(0) : beta * y[i]);
+		}
+	}
+
+#ifdef ML_GEMM_X86
+	/// <summary>
+	/// AVX2/FMA dot product of doubles, four accumulators of four lanes
+	/// </summary>
+	__attribute__((target("avx2,fma")))
+	double dotAvx2(const double* a, const double* b, size_t n)
+	{
+		__m256d s0 = _mm256_setzero_pd(), s1 = _mm256_setzero_pd(), s2 = _mm256_setzero_pd(), s3 = _mm256_setzero_pd();
+		size_t j = 0;
+		for (; j + 16 <= n; j += 16)
+		{
+			s0 = _mm256_fmadd_pd(_mm256_loadu_pd(a + j), _mm256_loadu_pd(b + j), s0);
+			s1 = _mm256_fmadd_pd(_mm256_loadu_pd(a + j + 4), _mm256_loadu_pd(b + j + 4), s1);
+			s2 = _mm256_fmadd_pd(_mm256_loadu_pd(a + j + 8), _mm256_loadu_pd(b + j + 8), s2);
+			s3 = _mm256_fmadd_pd(_mm256_loadu_pd(a + j + 12), _mm256_loadu_pd(b + j + 12), s3);
+		}
+		for (; j + 4 <= n; j += 4)
+		{
+			s0 = _mm256_fmadd_pd(_mm256_loadu_pd(a + j), _mm256_loadu_pd(b + j), s0);
+		}
+
+		const __m256d s = _mm256_add_pd(_mm256_add_pd(s0, s1), _mm256_add_pd(s2, s3));
+		const __m128d h = _mm_add_pd(_mm256_castpd256_pd128(s), _mm256_extractf128_pd(s, 1));
+		double sum = _mm_cvtsd_f64(_mm_add_sd(h, _mm_unpackhi_pd(h, h)));
+
+		for (; j < n; ++j) { sum += a[j] * b[j]; }
+		return sum;
+	}
+
+	/// <summary>
+	/// AVX2/FMA dot product of floats, four accumulators of eight lanes
+	/// </summary>
+	__attribute__((target("avx2,fma")))
+	float dotAvx2(const float* a, const float* b, size_t n)
+	{
+		__m256 s0 = _mm256_setzero_ps(), s1 = _mm256_setzero_ps(), s2 = _mm256_setzero_ps(), s3 = _mm256_setzero_ps();
+		size_t j = 0;
+		for (; j + 32 <= n; j += 32)
+		{
+			s0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + j), _mm256_loadu_ps(b + j), s0);
+			s1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + j + 8), _mm256_loadu_ps(b + j + 8), s1);
+			s2 = _mm256_fmadd_ps(_mm256_loadu_ps(a + j + 16), _mm256_loadu_ps(b + j + 16), s2);
+			s3 = _mm256_fmadd_ps(_mm256_loadu_ps(a + j + 24), _mm256_loadu_ps(b + j + 24), s3);
+		}
+		for (; j + 8 <= n; j += 8)
+		{
+			s0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + j), _mm256_loadu_ps(b + j), s0);
+		}
+
+		const __m256 s = _mm256_add_ps(_mm256_add_ps(s0, s1), _mm256_add_ps(s2, s3));
+		__m128 h = _mm_add_ps(_mm256_castps256_ps128(s), _mm256_extractf128_ps(s, 1));
+		h = _mm_add_ps(h, _mm_movehl_ps(h, h));
+		float sum = _mm_cvtss_f32(_mm_add_ss(h, _mm_movehdup_ps(h)));
+
+		for (; j < n; ++j) { sum += a[j] * b[j]; }
+		return sum;
+	}
+
+	/// <summary>
+	/// AVX2/FMA y = alpha * A x + beta * y for doubles. Four rows are done
+	/// together so each load of x serves four FMAs, with two accumulators per
+	/// row, and their sums are reduced to one vector at once.
+	/// </summary>
+	__attribute__((target("avx2,fma")))
+	void gemvAvx2(size_t m, size_t n, double alpha, const double* a, size_t lda, const double* x, double beta, double* y)
+	{
+		size_t i = 0;
+		for (; i + 4 <= m; i += 4)
+		{
+			const double* a0 = a + i * lda;
+			const double* a1 = a0 + lda;
+			const double* a2 = a1 + lda;
+			const double* a3 = a2 + lda;
+
+			__m256d c0 = _mm256_setzero_pd(), c1 = _mm256_setzero_pd(), c2 = _mm256_setzero_pd(), c3 = _mm256_setzero_pd();
+			__m256d d0 = _mm256_setzero_pd(), d1 = _mm256_setzero_pd(), d2 = _mm256_setzero_pd(), d3 = _mm256_setzero_pd();
+			size_t j = 0;
+			for (; j + 8 <= n; j += 8)
+			{
+				const __m256d xa = _mm256_loadu_pd(x + j), xb = _mm256_loadu_pd(x + j + 4);
+				c0 = _mm256_fmadd_pd(_mm256_loadu_pd(a0 + j), xa, c0); d0 = _mm256_fmadd_pd(_mm256_loadu_pd(a0 + j + 4), xb, d0);
+				c1 = _mm256_fmadd_pd(_mm256_loadu_pd(a1 + j), xa, c1); d1 = _mm256_fmadd_pd(_mm256_loadu_pd(a1 + j + 4), xb, d1);
+				c2 = _mm256_fmadd_pd(_mm256_loadu_pd(a2 + j), xa, c2); d2 = _mm256_fmadd_pd(_mm256_loadu_pd(a2 + j + 4), xb, d2);
+				c3 = _mm256_fmadd_pd(_mm256_loadu_pd(a3 + j), xa, c3); d3 = _mm256_fmadd_pd(_mm256_loadu_pd(a3 + j + 4), xb, d3);
+			}
+			for (; j + 4 <= n; j += 4)
+			{
+				const __m256d xa = _mm256_loadu_pd(x + j);
+				c0 = _mm256_fmadd_pd(_mm256_loadu_pd(a0 + j), xa, c0);
+				c1 = _mm256_fmadd_pd(_mm256_loadu_pd(a1 + j), xa, c1);
+				c2 = _mm256_fmadd_pd(_mm256_loadu_pd(a2 + j), xa, c2);
+				c3 = _mm256_fmadd_pd(_mm256_loadu_pd(a3 + j), xa, c3);
+			}
+
+			// hadd pairs the rows, the lane permutes then add halves into [s0, s1, s2, s3]
+			const __m256d h01 = _mm256_hadd_pd(_mm256_add_pd(c0, d0), _mm256_add_pd(c1, d1));
+			const __m256d h23 = _mm256_hadd_pd(_mm256_add_pd(c2, d2), _mm256_add_pd(c3, d3));
+			alignas(32) double sums[4];
+			_mm256_store_pd(sums, _mm256_add_pd(_mm256_permute2f128_pd(h01, h23, 0x20), _mm256_permute2f128_pd(h01, h23, 0x31)));
+
+			for (; j < n; ++j)
+			{
+				sums[0] += a0[j] * x[j]; sums[1] += a1[j] * x[j];
+				sums[2] += a2[j] * x[j]; sums[3] += a3[j] * x[j];
+			}
+
+			for (size_t r = 0; r < 4; ++r)
+			{
+				y[i + r] = alpha * sums[r] + (beta == 0.0 ? 0.0 : beta * y[i + r]);
+			}
+		}
+
+		for (; i < m; ++i)
+		{
+			y[i] = alpha * dotAvx2(a + i * lda, x, n) + (beta == 0.0 ? 0.0 : beta * y[i]);
+		}
+	}
+
+	/// <summary>
+	/// AVX2/FMA y = alpha * A x + beta * y for floats, four rows at a time
+	/// </summary>
+	__attribute__((target("avx2,fma")))
+	void gemvAvx2(size_t m, size_t n, float alpha, const float* a, size_t lda, const float* x, float beta, float* y)
+	{
+		size_t i = 0;
+		for (; i + 4 <= m; i += 4)
+		{
+			const float* a0 = a + i * lda;
+			const float* a1 = a0 + lda;
+			const float* a2 = a1 + lda;
+			const float* a3 = a2 + lda;
+
+			__m256 c0 = _mm256_setzero_ps(), c1 = _mm256_setzero_ps(), c2 = _mm256_setzero_ps(), c3 = _mm256_setzero_ps();
+			__m256 d0 = _mm256_setzero_ps(), d1 = _mm256_setzero_ps(), d2 = _mm256_setzero_ps(), d3 = _mm256_setzero_ps();
+			size_t j = 0;
+			for (; j + 16 <= n; j += 16)
+			{
+				const __m256 xa = _mm256_loadu_ps(x + j), xb = _mm256_loadu_ps(x + j + 8);
+				c0 = _mm256_fmadd_ps(_mm256_loadu_ps(a0 + j), xa, c0); d0 = _mm256_fmadd_ps(_mm256_loadu_ps(a0 + j + 8), xb, d0);
+				c1 = _mm256_fmadd_ps(_mm256_loadu_ps(a1 + j), xa, c1); d1 = _mm256_fmadd_ps(_mm256_loadu_ps(a1 + j + 8), xb, d1);
+				c2 = _mm256_fmadd_ps(_mm256_loadu_ps(a2 + j), xa, c2); d2 = _mm256_fmadd_ps(_mm256_loadu_ps(a2 + j + 8), xb, d2);
+				c3 = _mm256_fmadd_ps(_mm256_loadu_ps(a3 + j), xa, c3); d3 = _mm256_fmadd_ps(_mm256_loadu_ps(a3 + j + 8), xb, d3);
+			}
+			for (; j + 8 <= n; j += 8)
+			{
+				const __m256 xa = _mm256_loadu_ps(x + j);
+				c0 = _mm256_fmadd_ps(_mm256_loadu_ps(a0 + j), xa, c0);
+				c1 = _mm256_fmadd_ps(_mm256_loadu_ps(a1 + j), xa, c1);
+				c2 = _mm256_fmadd_ps(_mm256_loadu_ps(a2 + j), xa, c2);
+				c3 = _mm256_fmadd_ps(_mm256_loadu_ps(a3 + j), xa, c3);
+			}
+
+			// Fold each row to four lanes, then two hadd rounds give [s0, s1, s2, s3]
+			const __m256 r0 = _mm256_add_ps(c0, d0), r1 = _mm256_add_ps(c1, d1), r2 = _mm256_add_ps(c2, d2), r3 = _mm256_add_ps(c3, d3);
+			const __m128 q0 = _mm_add_ps(_mm256_castps256_ps128(r0), _mm256_extractf128_ps(r0, 1));
+			const __m128 q1 = _mm_add_ps(_mm256_castps256_ps128(r1), _mm256_extractf128_ps(r1, 1));
+			const __m128 q2 = _mm_add_ps(_mm256_castps256_ps128(r2), _mm256_extractf128_ps(r2, 1));
+			const __m128 q3 = _mm_add_ps(_mm256_castps256_ps128(r3), _mm256_extractf128_ps(r3, 1));
+			alignas(16) float sums[4];
+			_mm_store_ps(sums, _mm_hadd_ps(_mm_hadd_ps(q0, q1), _mm_hadd_ps(q2, q3)));
+
+			for (; j < n; ++j)
+			{
+				sums[0] += a0[j] * x[j]; sums[1] += a1[j] * x[j];
+				sums[2] += a2[j] * x[j]; sums[3] += a3[j] * x[j];
+			}
+
+			for (size_t r = 0; r < 4; ++r)
+			{
+				y[i + r] = alpha * sums[r] + (beta == 0.0f ? 0.0f : beta * y[i + r]);
+			}
+		}
+
+		for (; i < m; ++i)
+		{
+			y[i] = alpha * dotAvx2(a + i * lda, x, n) + (beta == 0.0f ? 0.0f : beta * y[i]);
+		}
+	}
+#endif
+
+	/// <summary>
+	/// Select the fastest matrix-vector kernel supported by the running CPU
+	/// </summary>
+	template <typename T>
+	GemvKernel<T> selectGemvKernel()
+	{
+#ifdef ML_GEMM_X86
+		if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+		{
+			return static_cast<GemvKernel<T>>(gemvAvx2);
+		}
+#endif
+		return gemvScalar<T>;
+	}
+
+	/// <summary>
+	/// Rows of a plain matrix-vector product, handed to parallelFor by a
+	/// single reference so that the std::function does not allocate
+	/// </summary>
+	template <typename T>
+	struct GemvRows
+	{
+		GemvKernel<T> kernel;
+		size_t n;
+		T alpha;
+		const T* a;
+		size_t lda;
+		const T* x;
+		T beta;
+		T* y;
+
+		void operator()(size_t begin, size_t end) const
+		{
+			kernel(end - begin, n, alpha, a + begin * lda, lda, x, beta, y + begin);
+		}
+	};
+
+	/// <summary>
+	/// Write an mr x nr tile, C = alpha * ab + beta * C
+	/// </summary>
+	template <typename T>
+	void updateTile(size_t mr, size_t nr, T alpha, const T* ab, T beta, T* c, size_t ldc)
+	{
+		constexpr size_t NR = Blocking<T>::NR;
+
+		for (size_t r = 0; r < mr; ++r)
+		{
+			T* cRow = c + r * ldc;
+			const T* abRow = ab + r * NR;
+
+			if (beta == T(0))
+			{
+				for (size_t j = 0; j < nr; ++j) { cRow[j] = alpha * abRow[j]; }
+			}
+			else
+			{
+				for (size_t j = 0; j < nr; ++j) { cRow[j] = alpha * abRow[j] + beta * cRow[j]; }
+			}
+		}
+	}
+}
+
+template <typename T>
+void gemm(Transpose transA, Transpose transB, size_t m, size_t n, size_t k,
+	std::type_identity_t<T> alpha, const T* a, size_t lda, const T* b, size_t ldb,
+	std::type_identity_t<T> beta, T* c, size_t ldc)
+{
+	constexpr size_t MR = Blocking<T>::MR, NR = Blocking<T>::NR;
+	constexpr size_t MC = Blocking<T>::MC, KC = Blocking<T>::KC, NC = Blocking<T>::NC;
+
+	if (m == 0 || n == 0)
+	{
+		return;
+	}
+
+	// Empty inner dimension, only scale C
+	if (k == 0 || alpha == T(0))
+	{
+		for (size_t i = 0; i < m; ++i)
+		{
+			for (size_t j = 0; j < n; ++j) { c[i * ldc + j] = beta == T(0) ? T(0) : beta * c[i * ldc + j]; }
+		}
+		return;
+	}
+
+	static const Kernel<T> kernel = selectKernel<T>();
+
+	const bool ta = transA == Transpose::Yes;
+	const bool tb = transB == Transpose::Yes;
+
+	// Small products are not worth waking the pool for
+	const bool parallel = static_cast<double>(m) * n * k >= ParallelThreshold;
+	const size_t numThreads = parallel ? getNumThreads() : 1;
+
+	// The packed B panel is shared by all threads, packed A blocks are per thread
+	thread_local Buffer<T> packedB;
+	packedB.resize(KC * ((NC + NR - 1) / NR) * NR);
+	T* const bPacked = packedB.data();
+
+	for (size_t jc = 0; jc < n; jc += NC)
+	{
+		const size_t nc = std::min(NC, n - jc);
+		const size_t numPanels = (nc + NR - 1) / NR;
+
+		for (size_t pc = 0; pc < k; pc += KC)
+		{
+			const size_t kc = std::min(KC, k - pc);
+
+			// Only the first pass over k applies beta, later passes accumulate
+			const T betaBlock = pc == 0 ? beta : T(1);
+
+			// Pack B, split over micro-panels
+			const size_t packGrain = numThreads == 1 ? numPanels : std::max<size_t>(1, numPanels / numThreads);
+			parallelFor(0, numPanels, packGrain, [&](size_t p0, size_t p1)
+			{
+				const size_t j0 = p0 * NR;
+				const size_t cols = std::min(nc, p1 * NR) - j0;
+				const T* bBlock = tb ? b + (jc + j0) * ldb + pc : b + pc * ldb + jc + j0;
+				packB(bBlock, ldb, tb, kc, cols, bPacked + j0 * kc);
+			});
+
+			// Output tiles: MC row blocks, further split into column groups when
+			// there are fewer row blocks than threads
+			const size_t numRowBlocks = (m + MC - 1) / MC;
+			size_t numColGroups = 1;
+			if (numRowBlocks < numThreads)
+			{
+				numColGroups = std::min((numThreads + numRowBlocks - 1) / numRowBlocks,
+					std::max<size_t>(1, numPanels / MinPanelsPerTask));
+			}
+			const size_t panelsPerGroup = (numPanels + numColGroups - 1) / numColGroups;
+			const size_t numTasks = numRowBlocks * numColGroups;
+
+			parallelFor(0, numTasks, numThreads == 1 ? numTasks : 1, [&](size_t t0, size_t t1)
+			{
+				thread_local Buffer<T> packedA;
+				packedA.resize(MC * KC);
+				alignas(64) T ab[MR * NR];
+
+				for (size_t t = t0; t < t1; ++t)
+				{
+					const size_t ic = (t / numColGroups) * MC;
+					const size_t mc = std::min(MC, m - ic);
+					const size_t jBegin = (t % numColGroups) * panelsPerGroup * NR;
+					const size_t jEnd = std::min(nc, jBegin + panelsPerGroup * NR);
+
+					if (jBegin >= jEnd)
+					{
+						continue;
+					}
+
+					const T* aBlock = ta ? a + pc * lda + ic : a + ic * lda + pc;
+					packA(aBlock, lda, ta, mc, kc, packedA.data());
+
+					for (size_t jr = jBegin; jr < jEnd; jr += NR)
+					{
+						const size_t nr = std::min(NR, nc - jr);
+						const T* bPanel = bPacked + jr * kc;
+
+						for (size_t ir = 0; ir < mc; ir += MR)
+						{
+							const size_t mr = std::min(MR, mc - ir);
+							const T* aPanel = packedA.data() + ir * kc;
+
+							kernel(kc, aPanel, bPanel, ab);
+							updateTile(mr, nr, alpha, ab, betaBlock, c + (ic + ir) * ldc + jc + jr, ldc);
+						}
+					}
+				}
+			});
+		}
+	}
+}
+
+template <typename T>
+void gemv(Transpose trans, size_t m, size_t n, std::type_identity_t<T> alpha, const T* a, size_t lda,
+	const T* x, std::type_identity_t<T> beta, T* y)
+{
+	// Rows of A per parallel block, fixed by shape so results do not depend on the thread count
+	const size_t grain = std::max<size_t>(1, GemvBlockSize / std::max<size_t>(1, n));
+
+	if (trans == Transpose::No)
+	{
+		// y = alpha * A x + beta * y, independent dot products per row
+		static const GemvKernel<T> kernel = selectGemvKernel<T>();
+
+		const GemvRows<T> rows{ kernel, n, alpha, a, lda, x, beta, y };
+
+		// A single block runs inline, skipping the pool entirely
+		if (m <= grain)
+		{
+			rows(0, m);
+		}
+		else
+		{
+			parallelFor(0, m, grain, [&rows](size_t begin, size_t end) { rows(begin, end); });
+		}
+		return;
+	}
+
+	// y = alpha * A^T x + beta * y, accumulated row by row so that A is read in
+	// storage order. Each block of rows sums into its own partial vector and the
+	// partials are added in block order.
+	const size_t blockRows = std::max(grain, (m + MaxReductionBlocks - 1) / MaxReductionBlocks);
+	const size_t numBlocks = std::max<size_t>(1, (m + blockRows - 1) / blockRows);
+
+	thread_local Buffer<T> partials;
+	partials.assign(numBlocks * n, T(0));
+	T* const p = partials.data();
+
+	parallelFor(0, numBlocks, 1, [&](size_t b0, size_t b1)
+	{
+		for (size_t block = b0; block < b1; ++block)
+		{
+			T* acc = p + block * n;
+			const size_t end = std::min(m, (block + 1) * blockRows);
+
+			for (size_t i = block * blockRows; i < end; ++i)
+			{
+				const T* row = a + i * lda;
+				const T xi = x[i];
+
+				for (size_t j = 0; j < n; ++j) { acc[j] += row[j] * xi; }
+			}
+		}
+	});
+
+	for (size_t j = 0; j < n; ++j)
+	{
+		T sum = T(0);
+		for (size_t block = 0; block < numBlocks; ++block) { sum += p[block * n + j]; }
+
+		y[j] = alpha * sum + (beta == T(0) ? T(0) : beta * y[j]);
+	}
+}
+
+template <typename T>
+void syrk(size_t n, size_t k, std::type_identity_t<T> alpha, const T* a, size_t lda,
+	std::type_identity_t<T> beta, T* c, size_t ldc)
+{
+	if (n == 0)
+	{
+		return;
+	}
+
+	// Square tiles of C on or above the diagonal
+	const size_t numTiles = (n + SyrkTile - 1) / SyrkTile;
+	const size_t numTilePairs = numTiles * (numTiles + 1) / 2;
+
+	// Rows of A are split into blocks that each sum into their own partial C,
+	// bounded so the partials stay small. A single block writes C directly.
+	const size_t maxBlocks = std::max<size_t>(1, std::min(MaxReductionBlocks, MaxPartialElements / (n * n)));
+	const size_t blockRows = std::max(SyrkMinBlockRows, (k + maxBlocks - 1) / maxBlocks);
+	const size_t numBlocks = std::max<size_t>(1, (k + blockRows - 1) / blockRows);
+
+	thread_local Buffer<T> partials;
+	if (numBlocks > 1)
+	{
+		partials.resize(numBlocks * n * n);
+	}
+	T* const p = partials.data();
+
+	parallelFor(0, numBlocks * numTilePairs, 1, [&](size_t t0, size_t t1)
+	{
+		for (size_t t = t0; t < t1; ++t)
+		{
+			const size_t block = t / numTilePairs;
+			size_t pair = t % numTilePairs;
+
+			// Map the pair index to the tile (ti, tj) with ti <= tj
+			size_t ti = 0;
+			while (pair >= numTiles - ti) { pair -= numTiles - ti; ++ti; }
+			const size_t tj = ti + pair;
+
+			const size_t i0 = ti * SyrkTile, j0 = tj * SyrkTile;
+			const size_t rowsI = std::min(SyrkTile, n - i0), colsJ = std::min(SyrkTile, n - j0);
+			const size_t r0 = block * blockRows;
+			const size_t rows = std::min(k, r0 + blockRows) - std::min(k, r0);
+
+			if (numBlocks == 1 && ti == tj)
+			{
+				// Diagonal tile, computed whole and then only its upper half written
+				thread_local Buffer<T> tile;
+				tile.resize(SyrkTile * SyrkTile);
+				gemm<T>(Transpose::Yes, Transpose::No, rowsI, colsJ, rows,
+					T(1), a + i0, lda, a + j0, lda, T(0), tile.data(), SyrkTile);
+
+				for (size_t i = 0; i < rowsI; ++i)
+				{
+					T* cRow = c + (i0 + i) * ldc + j0;
+					for (size_t j = i; j < colsJ; ++j)
+					{
+						cRow[j] = alpha * tile[i * SyrkTile + j] + (beta == T(0) ? T(0) : beta * cRow[j]);
+					}
+				}
+			}
+			else if (numBlocks == 1)
+			{
+				gemm<T>(Transpose::Yes, Transpose::No, rowsI, colsJ, rows,
+					alpha, a + i0, lda, a + j0, lda, beta, c + i0 * ldc + j0, ldc);
+			}
+			else
+			{
+				gemm<T>(Transpose::Yes, Transpose::No, rowsI, colsJ, rows,
+					T(1), a + r0 * lda + i0, lda, a + r0 * lda + j0, lda, T(0), p + block * n * n + i0 * n + j0, n);
+			}
+		}
+	});
+
+	if (numBlocks == 1)
+	{
+		return;
+	}
+
+	// Add the partials in block order into the upper triangle of C
+	for (size_t i = 0; i < n; ++i)
+	{
+		for (size_t j = i; j < n; ++j)
+		{
+			T sum = T(0);
+			for (size_t block = 0; block < numBlocks; ++block) { sum += p[block * n * n + i * n + j]; }
+
+			c[i * ldc + j] = alpha * sum + (beta == T(0) ? T(0) : beta * c[i * ldc + j]);
+		}
+	}
+}
+
+template void gemm<float>(Transpose, Transpose, size_t, size_t, size_t,
+	float, const float*, size_t, const float*, size_t, float, float*, size_t);
+template void gemm<double>(Transpose, Transpose, size_t, size_t, size_t,
+	double, const double*, size_t, const double*, size_t, double, double*, size_t);
+
+template void gemv<float>(Transpose, size_t, size_t, float, const float*, size_t, const float*, float, float*);
+template void gemv<double>(Transpose, size_t, size_t, double, const double*, size_t, const double*, double, double*);
+
+template void syrk<float>(size_t, size_t, float, const float*, size_t, float, float*, size_t);
+template void syrk<double>(size_t, size_t, double, const double*, size_t, double, double*, size_t);
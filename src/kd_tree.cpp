@@ -0,0 +1,192 @@
+#include "kd_tree.h"
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+
+namespace
+{
+	// Largest number of rows of a leaf
+	constexpr size_t LeafSize = 8;
+
+	// Capacity of the search stack; median splits keep the depth below log2 of the rows
+	constexpr size_t MaxStackDepth = 64;
+}
+
+template <typename T>
+BasicKDTree<T>::BasicKDTree()
+	:m_numCols(0), m_distance(squaredDistanceFunction<T>(0))
+{}
+
+template <typename T>
+BasicKDTree<T>::BasicKDTree(const BasicMatrixView<T>& rows)
+	:BasicKDTree()
+{
+	build(rows);
+}
+
+template <typename T>
+void BasicKDTree<T>::build(const BasicMatrixView<T>& rows)
+{
+	const size_t numRows = rows.getNumOfRows();
+	m_numCols = rows.getNumOfCols();
+	m_distance = squaredDistanceFunction<T>(m_numCols);
+
+	m_nodes.clear();
+	m_indices.resize(numRows);
+	std::iota(m_indices.begin(), m_indices.end(), size_t(0));
+
+	if (numRows != 0)
+	{
+		m_nodes.reserve(2 * (numRows / LeafSize) + 1);
+		buildNode(rows, 0, numRows);
+	}
+
+	// Copy the rows in leaf order, so leaves are scanned contiguously
+	m_rows.resize(numRows * m_numCols);
+	for (size_t p = 0; p < numRows; ++p)
+	{
+		const auto row = rows.row(m_indices[p]);
+		std::copy(row.begin(), row.end(), m_rows.begin() + p * m_numCols);
+	}
+}
+
+template <typename T>
+size_t BasicKDTree<T>::buildNode(const BasicMatrixView<T>& rows, size_t begin, size_t end)
+{
+	const size_t index = m_nodes.size();
+	m_nodes.push_back({ begin, end, 0, 0, 0, T(0) });
+
+	if (end - begin <= LeafSize)
+	{
+		return index;
+	}
+
+	// Split the dimension of largest spread
+	size_t splitDim = 0;
+	T largestSpread = T(0);
+
+	for (size_t j = 0; j < m_numCols; ++j)
+	{
+		T low = std::numeric_limits<T>::max(), high = std::numeric_limits<T>::lowest();
+		for (size_t p = begin; p < end; ++p)
+		{
+			const T value = rows.row(m_indices[p])[j];
+			low = std::min(low, value);
+			high = std::max(high, value);
+		}
+
+		if (high - low > largestSpread)
+		{
+			largestSpread = high - low;
+			splitDim = j;
+		}
+	}
+
+	// All rows are equal
+	if (largestSpread == T(0))
+	{
+		return index;
+	}
+
+	// Median split, rows before mid are at most the median and rows after at least
+	const size_t mid = begin + (end - begin) / 2;
+	std::nth_element(m_indices.begin() + begin, m_indices.begin() + mid, m_indices.begin() + end,
+		[&](size_t a, size_t b) { return rows.row(a)[splitDim] < rows.row(b)[splitDim]; });
+
+	const T splitValue = rows.row(m_indices[mid])[splitDim];
+	const size_t left = buildNode(rows, begin, mid);
+	const size_t right = buildNode(rows, mid, end);
+
+	Node& node = m_nodes[index];
+	node.left = left;
+	node.right = right;
+	node.splitDim = splitDim;
+	node.splitValue = splitValue;
+
+	return index;
+}
+
+template <typename T>
+void BasicKDTree<T>::clear()
+{
+	m_nodes.clear();
+	m_rows.clear();
+	m_indices.clear();
+}
+
+template <typename T>
+size_t BasicKDTree<T>::nearest(std::span<const T> x, T* squaredDistance) const
+{
+	if (x.size() != m_numCols)
+	{
+		throw std::invalid_argument("Point size must match the number of columns.");
+	}
+	else if (empty())
+	{
+		throw std::invalid_argument("There must be at least one row.");
+	}
+
+	struct Entry
+	{
+		size_t node;
+		T bound;
+	};
+
+	// Nodes to visit with a lower bound of the squared distance to their rows
+	Entry stack[MaxStackDepth];
+	size_t top = 0;
+	stack[top++] = { 0, T(0) };
+
+	// Row 0 when no distance is below the maximum (NaN or overflow), as in
+	// nearestRow
+	T best = std::numeric_limits<T>::max();
+	size_t result = 0;
+
+	while (top != 0)
+	{
+		const Entry entry = stack[--top];
+
+		// Rows at the bound distance may still win a tie on their index
+		if (entry.bound > best)
+		{
+			continue;
+		}
+
+		const Node& node = m_nodes[entry.node];
+
+		if (node.left == 0)
+		{
+			for (size_t p = node.begin; p < node.end; ++p)
+			{
+				const T dist = m_distance(x.data(), m_rows.data() + p * m_numCols, m_numCols);
+
+				if (dist < best || (dist == best && m_indices[p] < result))
+				{
+					best = dist;
+					result = m_indices[p];
+				}
+			}
+			continue;
+		}
+
+		// The far side is at least the distance to the split plane away; the
+		// near side is pushed last so it is searched first
+		const T diff = x[node.splitDim] - node.splitValue;
+		const size_t nearChild = diff < T(0) ? node.left : node.right;
+		const size_t farChild = diff < T(0) ? node.right : node.left;
+
+		stack[top++] = { farChild, std::max(entry.bound, diff * diff) };
+		stack[top++] = { nearChild, entry.bound };
+	}
+
+	if (squaredDistance != nullptr)
+	{
+		*squaredDistance = best;
+	}
+
+	return result;
+}
+
+template class BasicKDTree<float>;
+template class BasicKDTree<double>;
@@ -1,107 +1,1153 @@
 #include "kmeans.h"
-#include "vector_utils.h"
+#include "distance.h"
+#include "gemm.h"
+#include "matrix.h"
+#include "thread_pool.h"
+#include <algorithm>
 #include <cmath>
+#include <limits>
+#include <mutex>
+#include <numeric>
 #include <random>
+#include <stdexcept>
+#include <utility>
 
-KMeans::KMeans(size_t k, size_t maxIterations, double tolerance)
-	:m_k(k), m_maxIterations(maxIterations), m_tolerance(tolerance)
-{}
+namespace
+{
+	// Largest number of lower bounds (points x clusters) KMeansAlgorithm::Auto gives to Elkan
+	constexpr size_t ElkanMaxBounds = size_t(1) << 26;
+
+	// Smallest number of clusters for which KMeansAlgorithm::Auto picks Elkan
+	constexpr size_t ElkanMinClusters = 32;
+
+	// Smallest number of clusters for which KMeansAlgorithm::Auto picks the KD-tree
+	constexpr size_t KDTreeMinClusters = 1024;
+
+	// Largest dimension for which KMeansAlgorithm::Auto picks the KD-tree
+	constexpr size_t KDTreeMaxDims = 16;
+
+	// Upper bound on the point blocks of a Lloyd iteration, each with its own cluster sums
+	constexpr size_t MaxAccumulationBlocks = 64;
+
+	// Upper bound on the elements of the cluster sums of all blocks
+	constexpr size_t MaxAccumulationElements = size_t(1) << 22;
+
+	// Smallest number of points per block of a Lloyd iteration
+	constexpr size_t MinBlockRows = 1024;
+
+	// Rows per block of the seeding passes, fixed so the seeds do not depend on the thread count
+	constexpr size_t SeedingBlockRows = 4096;
+
+	// Points per parallel block of the mini-batch assignment
+	constexpr size_t AssignBlockRows = 1024;
+
+	// Smallest sample the centroids of an out-of-core fit are seeded on
+	constexpr size_t SeedSampleRows = size_t(1) << 16;
+
+	// Points per cluster in the sample the centroids of an out-of-core fit are seeded on
+	constexpr size_t SeedSamplePerCluster = 16;
+
+	// Points per block of the GEMM of predictBatch
+	constexpr size_t PredictBlockRows = 256;
+
+	// Centroids per block of the GEMM of predictBatch
+	constexpr size_t PredictBlockCentroids = 256;
+
+	// Oversampling passes of k-means||
+	constexpr size_t ParallelInitRounds = 5;
+
+	/// <summary>
+	/// splitmix64 finaliser
+	/// </summary>
+	inline uint64_t mixBits(uint64_t z)
+	{
+		z += 0x9E3779B97F4A7C15ull;
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+		return z ^ (z >> 31);
+	}
+
+	/// <summary>
+	/// Uniform number in [0, 1) hashed from a seed, a round and a point index,
+	/// so each point draws the same number whichever thread visits it
+	/// </summary>
+	inline double hashUniform(uint32_t seed, uint64_t round, uint64_t index)
+	{
+		return (mixBits(mixBits(seed ^ mixBits(round)) ^ index) >> 11) * 0x1.0p-53;
+	}
+
+	/// <summary>
+	/// Lower the squared distance from each point to its nearest seed with new
+	/// seeds, and sum the weighted distances per block of SeedingBlockRows rows
+	/// </summary>
+	/// <returns>Sum of the block sums, in block order</returns>
+	template <typename T>
+	T updateSeedDistances(const BasicMatrixView<T>& X, const T* weights, const BasicMatrixView<T>& seeds,
+		std::vector<T>& minDistances, std::vector<T>& blockSums)
+	{
+		const size_t n = X.getNumOfRows();
+
+		parallelFor(0, blockSums.size(), 1, [&](size_t b0, size_t b1)
+		{
+			for (size_t block = b0; block < b1; ++block)
+			{
+				const size_t end = std::min(n, (block + 1) * SeedingBlockRows);
+				T sum = T(0);
+
+				for (size_t i = block * SeedingBlockRows; i < end; ++i)
+				{
+					T dist;
+					nearestRow(X.row(i), seeds, &dist);
+
+					minDistances[i] = std::min(minDistances[i], dist);
+					sum += weights == nullptr ? minDistances[i] : weights[i] * minDistances[i];
+				}
+
+				blockSums[block] = sum;
+			}
+		});
+
+		T total = T(0);
+		for (T sum : blockSums) { total += sum; }
+		return total;
+	}
+
+	/// <summary>
+	/// Index of the point at which the running sum of the weighted distances
+	/// first exceeds a target in [0, total)
+	/// </summary>
+	template <typename T>
+	size_t sampleSeed(const T* weights, const std::vector<T>& minDistances, const std::vector<T>& blockSums, T target)
+	{
+		// Skip whole blocks, then walk the rows of the block holding the target
+		size_t block = 0;
+		while (block + 1 < blockSums.size() && target >= blockSums[block])
+		{
+			target -= blockSums[block++];
+		}
+
+		const size_t begin = block * SeedingBlockRows, end = std::min(minDistances.size(), begin + SeedingBlockRows);
+		size_t last = begin;
+
+		for (size_t i = begin; i < end; ++i)
+		{
+			const T mass = weights == nullptr ? minDistances[i] : weights[i] * minDistances[i];
+			if (mass > T(0))
+			{
+				if (target < mass) { return i; }
+				target -= mass;
+				last = i;
+			}
+		}
+
+		// Rounding left the target past the end
+		return last;
+	}
+
+	/// <summary>
+	/// Sum of the weighted squared distances to the nearest seed if each trial
+	/// point was added as a seed, in one pass over the data
+	/// </summary>
+	/// <returns>Index of the trial with the lowest sum, the first on ties</returns>
+	template <typename T>
+	size_t bestTrial(const BasicMatrixView<T>& X, const T* weights, const std::vector<size_t>& trials,
+		const std::vector<T>& minDistances, std::vector<T>& trialSums)
+	{
+		const size_t n = X.getNumOfRows(), d = X.getNumOfCols(), numTrials = trials.size();
+		const size_t numBlocks = trialSums.size() / numTrials;
+		const SquaredDistanceFunction<T> distance = squaredDistanceFunction<T>(d);
+
+		parallelFor(0, numBlocks, 1, [&](size_t b0, size_t b1)
+		{
+			for (size_t block = b0; block < b1; ++block)
+			{
+				T* sums = trialSums.data() + block * numTrials;
+				std::fill(sums, sums + numTrials, T(0));
+				const size_t end = std::min(n, (block + 1) * SeedingBlockRows);
+
+				for (size_t i = block * SeedingBlockRows; i < end; ++i)
+				{
+					const T weight = weights == nullptr ? T(1) : weights[i];
+
+					for (size_t t = 0; t < numTrials; ++t)
+					{
+						const T dist = distance(X.row(i).data(), X.row(trials[t]).data(), d);
+						sums[t] += weight * std::min(minDistances[i], dist);
+					}
+				}
+			}
+		});
+
+		size_t best = 0;
+		T bestSum = std::numeric_limits<T>::max();
+
+		for (size_t t = 0; t < numTrials; ++t)
+		{
+			T sum = T(0);
+			for (size_t block = 0; block < numBlocks; ++block) { sum += trialSums[block * numTrials + t]; }
+
+			if (sum < bestSum)
+			{
+				bestSum = sum;
+				best = t;
+			}
+		}
+
+		return best;
+	}
+
+	/// <summary>
+	/// Greedy k-means++ seeding of all rows of the centroids. Each seed is
+	/// the best of 2 + log k trial points drawn with probability proportional
+	/// to weight times squared distance to the nearest seed so far, so points
+	/// already chosen are not drawn again. The distances are lowered and the
+	/// trials scored in parallel blocks of the data.
+	/// </summary>
+	/// <param name="X">Points, one per row</param>
+	/// <param name="weights">Weight of each point, or null for unit weights</param>
+	/// <param name="gen">Random generator</param>
+	/// <param name="centroids">Receives the seeds, k x d</param>
+	template <typename T>
+	void seedPlusPlus(const BasicMatrixView<T>& X, const T* weights, std::mt19937& gen, BasicMatrix<T>& centroids)
+	{
+		const size_t n = X.getNumOfRows(), d = X.getNumOfCols(), k = centroids.getNumOfRows();
+		const size_t numBlocks = (n + SeedingBlockRows - 1) / SeedingBlockRows;
+		std::uniform_int_distribution<size_t> uniform(0, n - 1);
+		std::uniform_real_distribution<T> unit(T(0), T(1));
+
+		size_t index = uniform(gen);
+		if (weights != nullptr)
+		{
+			// First seed in proportion to the weights
+			T total = T(0);
+			for (size_t i = 0; i < n; ++i) { total += weights[i]; }
+
+			T target = unit(gen) * total;
+			for (index = 0; index + 1 < n && target >= weights[index]; ++index) { target -= weights[index]; }
+		}
+
+		std::vector<T> minDistances(n, std::numeric_limits<T>::max());
+		std::vector<T> blockSums(numBlocks);
+		std::vector<size_t> trials(2 + static_cast<size_t>(std::log(static_cast<double>(k))));
+		std::vector<T> trialSums(numBlocks * trials.size());
+
+		for (size_t c = 0; c < k; ++c)
+		{
+			const auto row = X.row(index);
+			std::copy(row.begin(), row.end(), centroids.row(c).begin());
+
+			if (c + 1 == k)
+			{
+				break;
+			}
+
+			const BasicMatrixView<T> seed(centroids.data() + c * d, 1, d, d);
+			const T total = updateSeedDistances(X, weights, seed, minDistances, blockSums);
+
+			if (total <= T(0))
+			{
+				// Every point is a seed already, nothing is left to draw from
+				index = uniform(gen);
+				continue;
+			}
+
+			for (size_t& trial : trials) { trial = sampleSeed(weights, minDistances, blockSums, unit(gen) * total); }
+			index = trials[bestTrial(X, weights, trials, minDistances, trialSums)];
+		}
+	}
+
+	/// <summary>
+	/// k-means|| seeding of all rows of the centroids. Starting from one random
+	/// point, each round keeps every point independently with probability
+	/// 2k D^2 / sum D^2, drawn from a hash of the seed, round and point index.
+	/// The candidates are weighted by the points closest to them and reduced
+	/// to k seeds by weighted k-means++.
+	/// </summary>
+	/// <param name="X">Points, one per row</param>
+	/// <param name="seed">Seed of the per point draws</param>
+	/// <param name="gen">Random generator</param>
+	/// <param name="centroids">Receives the seeds, k x d</param>
+	template <typename T>
+	void seedParallel(const BasicMatrixView<T>& X, uint32_t seed, std::mt19937& gen, BasicMatrix<T>& centroids)
+	{
+		const size_t n = X.getNumOfRows(), d = X.getNumOfCols(), k = centroids.getNumOfRows();
+		const size_t numBlocks = (n + SeedingBlockRows - 1) / SeedingBlockRows;
+		std::uniform_int_distribution<size_t> uniform(0, n - 1);
+
+		// Candidates, one per d elements
+		std::vector<T> candidates;
+		const auto first = X.row(uniform(gen));
+		candidates.assign(first.begin(), first.end());
+
+		std::vector<T> minDistances(n, std::numeric_limits<T>::max());
+		std::vector<T> blockSums(numBlocks);
+		std::vector<std::vector<size_t>> picked(numBlocks);
+		const T oversampling = T(2 * k);
+		size_t added = 0;
+
+		for (size_t round = 0; round < ParallelInitRounds; ++round)
+		{
+			// Distances to the candidates added by the previous round
+			const size_t numCandidates = candidates.size() / d;
+			const BasicMatrixView<T> newCandidates(candidates.data() + added * d, numCandidates - added, d, d);
+			const T total = updateSeedDistances<T>(X, nullptr, newCandidates, minDistances, blockSums);
+			added = numCandidates;
+
+			if (total <= T(0))
+			{
+				break;
+			}
+
+			parallelFor(0, numBlocks, 1, [&](size_t b0, size_t b1)
+			{
+				for (size_t block = b0; block < b1; ++block)
+				{
+					const size_t end = std::min(n, (block + 1) * SeedingBlockRows);
+					picked[block].clear();
+
+					for (size_t i = block * SeedingBlockRows; i < end; ++i)
+					{
+						if (T(hashUniform(seed, round, i)) * total < oversampling * minDistances[i]) { picked[block].push_back(i); }
+					}
+				}
+			});
+
+			// Appended in block order, so the candidates do not depend on the threads
+			for (const auto& indices : picked)
+			{
+				for (size_t i : indices)
+				{
+					const auto row = X.row(i);
+					candidates.insert(candidates.end(), row.begin(), row.end());
+				}
+			}
+		}
 
-void KMeans::fit(const std::vector<Point>& X)
+		const size_t numCandidates = candidates.size() / d;
+		const BasicMatrixView<T> candidateView(candidates.data(), numCandidates, d, d);
+
+		if (numCandidates <= k)
+		{
+			// Too few distinct points, the rest are random points
+			for (size_t c = 0; c < k; ++c)
+			{
+				const auto row = c < numCandidates ? candidateView.row(c) : X.row(uniform(gen));
+				std::copy(row.begin(), row.end(), centroids.row(c).begin());
+			}
+			return;
+		}
+
+		// Weight each candidate by the number of points closest to it. The counts
+		// are integers, so merging them in any order gives the same weights.
+		std::vector<size_t> counts(numCandidates, 0);
+		std::mutex countsMutex;
+
+		parallelFor(0, numBlocks, 1, [&](size_t b0, size_t b1)
+		{
+			std::vector<size_t> local(numCandidates, 0);
+			const size_t end = std::min(n, b1 * SeedingBlockRows);
+
+			for (size_t i = b0 * SeedingBlockRows; i < end; ++i) { ++local[nearestRow(X.row(i), candidateView)]; }
+
+			const std::lock_guard<std::mutex> lock(countsMutex);
+			for (size_t c = 0; c < numCandidates; ++c) { counts[c] += local[c]; }
+		});
+
+		const std::vector<T> weights(counts.begin(), counts.end());
+		seedPlusPlus(candidateView, weights.data(), gen, centroids);
+	}
+
+	/// <summary>
+	/// Distance bounds of the accelerated assignment steps. Bounds are on
+	/// Euclidean distances; Hamerly keeps one lower bound per point, Elkan one
+	/// per point and centroid.
+	/// </summary>
+	template <typename T>
+	struct DistanceBounds
+	{
+		// Upper bound of the distance from each point to its centroid
+		std::vector<T> upper;
+
+		// Lower bounds of the distance from each point to the other centroids
+		std::vector<T> lower;
+
+		// Half the distances between centroids, k x k, Elkan only
+		std::vector<T> halfCentroidDistances;
+
+		// Half the distance from each centroid to its nearest other centroid
+		std::vector<T> halfGap;
+
+		// Distance each centroid moved in the last update
+		std::vector<T> drift;
+
+		// Relative margin of the pruning tests, covering rounding in the
+		// distances and bounds so the labels match Lloyd's exactly
+		T slack;
+	};
+
+	/// <summary>
+	/// Compute the half gaps, and for Elkan all half centroid to centroid distances
+	/// </summary>
+	template <typename T>
+	void updateCentroidGaps(const BasicMatrix<T>& centroids, SquaredDistanceFunction<T> distance, bool elkan, DistanceBounds<T>& bounds)
+	{
+		const size_t k = centroids.getNumOfRows(), d = centroids.getNumOfCols();
+		std::fill(bounds.halfGap.begin(), bounds.halfGap.end(), std::numeric_limits<T>::max());
+
+		for (size_t i = 0; i < k; ++i)
+		{
+			for (size_t j = i + 1; j < k; ++j)
+			{
+				const T half = T(0.5) * std::sqrt(distance(centroids.data() + i * d, centroids.data() + j * d, d));
+
+				if (elkan)
+				{
+					bounds.halfCentroidDistances[i * k + j] = bounds.halfCentroidDistances[j * k + i] = half;
+				}
+				bounds.halfGap[i] = std::min(bounds.halfGap[i], half);
+				bounds.halfGap[j] = std::min(bounds.halfGap[j], half);
+			}
+		}
+	}
+
+	/// <summary>
+	/// Number of point blocks of a Lloyd iteration, each with its own k x d
+	/// cluster sums, from the shape of the data alone
+	/// </summary>
+	inline size_t accumulationBlocks(size_t numOfRows, size_t sumElements)
+	{
+		const size_t maxBlocks = std::clamp<size_t>(MaxAccumulationElements / std::max<size_t>(1, sumElements), 1, MaxAccumulationBlocks);
+		return std::clamp<size_t>((numOfRows + MinBlockRows - 1) / MinBlockRows, 1, maxBlocks);
+	}
+
+	/// <summary>
+	/// Shift the Hamerly bounds by the distances the centroids moved. Elkan
+	/// shifts its bounds while assigning, to read them only once per iteration.
+	/// </summary>
+	template <typename T>
+	void shiftBounds(const std::vector<size_t>& labels, DistanceBounds<T>& bounds)
+	{
+		const size_t k = bounds.drift.size();
+
+		// The lower bound is against any other centroid, so it moves by the
+		// largest drift, or the second largest for the cluster that moved most
+		size_t largest = 0;
+		for (size_t c = 1; c < k; ++c)
+		{
+			if (bounds.drift[c] > bounds.drift[largest]) { largest = c; }
+		}
+
+		T secondLargest = T(0);
+		for (size_t c = 0; c < k; ++c)
+		{
+			if (c != largest) { secondLargest = std::max(secondLargest, bounds.drift[c]); }
+		}
+
+		parallelFor(0, labels.size(), MinBlockRows, [&](size_t begin, size_t end)
+		{
+			for (size_t p = begin; p < end; ++p)
+			{
+				bounds.upper[p] += bounds.drift[labels[p]];
+				bounds.lower[p] -= labels[p] == largest ? secondLargest : bounds.drift[largest];
+			}
+		});
+	}
+}
+
+template <typename T>
+BasicKMeans<T>::BasicKMeans(size_t k, size_t maxIterations, T tolerance, KMeansAlgorithm algorithm, KMeansInit init, uint32_t seed)
+	:m_k(k), m_maxIterations(maxIterations), m_tolerance(tolerance), m_algorithm(algorithm), m_init(init), m_seed(seed), m_centroids(0, 0)
 {
-	m_centroids.clear();
-	m_centroids.resize(m_k);
-	
-	// Randomly assign initial centroids
-	std::mt19937 gen(42);
-	std::uniform_int_distribution<size_t> dist(0, X.size() - 1);
+	if (k == 0)
+	{
+		throw std::invalid_argument("Number of clusters must be positive.");
+	}
+}
+
+template <typename T>
+void BasicKMeans<T>::fit(const std::vector<BasicPoint<T>>& X)
+{
+	// Pack the points into one contiguous buffer and fit on a view of it
+	const BasicMatrix<T> data(X);
+	fit(data.view());
+}
+
+template <typename T>
+void BasicKMeans<T>::fit(const BasicMatrixView<T>& X)
+{
+	if (X.getNumOfRows() == 0 || X.getNumOfCols() == 0)
+	{
+		throw std::invalid_argument("X cannot be empty.");
+	}
+
+	m_centroids = BasicMatrix<T>(m_k, X.getNumOfCols());
+
+	std::mt19937 gen(m_seed);
+	initCentroids(X, gen);
+
+	// All rows in one chunk, read in place
+	BasicViewSource<T> source(X);
+	iterate(source, X.getNumOfRows(), gen);
+}
 
-	for (auto& centroid : m_centroids)
+template <typename T>
+void BasicKMeans<T>::fit(BasicDataSource<T>& source, size_t chunkRows)
+{
+	const size_t numOfRows = source.getNumOfRows(), numOfCols = source.getNumOfCols();
+
+	if (numOfRows == 0 || numOfCols == 0)
+	{
+		throw std::invalid_argument("X cannot be empty.");
+	}
+	else if (chunkRows == 0)
+	{
+		throw std::invalid_argument("Chunk size must be positive.");
+	}
+
+	m_centroids = BasicMatrix<T>(m_k, numOfCols);
+	std::mt19937 gen(m_seed);
+
+	// Seed on a sample of rows, read in file order, or on all rows when they fit
+	const size_t sampleRows = std::min(numOfRows, std::max(SeedSampleRows, SeedSamplePerCluster * m_k));
+	std::vector<size_t> sampleIndices(sampleRows);
+
+	if (sampleRows == numOfRows)
 	{
-		// Assign centroids a random point from input
-		centroid = X[dist(gen)];
+		std::iota(sampleIndices.begin(), sampleIndices.end(), size_t(0));
+	}
+	else
+	{
+		std::uniform_int_distribution<size_t> dist(0, numOfRows - 1);
+		for (size_t& index : sampleIndices) { index = dist(gen); }
+		std::sort(sampleIndices.begin(), sampleIndices.end());
+	}
+
+	BasicMatrix<T> sample(sampleRows, numOfCols);
+	for (size_t i = 0; i < sampleRows; )
+	{
+		// Consecutive indices are read together
+		size_t count = 1;
+		while (i + count < sampleRows && sampleIndices[i + count] == sampleIndices[i] + count && count < chunkRows) { ++count; }
+
+		const BasicMatrixView<T> rows = source.read(sampleIndices[i], count);
+		for (size_t r = 0; r < count; ++r)
+		{
+			std::copy(rows.row(r).begin(), rows.row(r).end(), sample.row(i + r).begin());
+		}
+		i += count;
+	}
+
+	initCentroids(sample.view(), gen);
+	iterate(source, chunkRows, gen);
+}
+
+template <typename T>
+void BasicKMeans<T>::iterate(BasicDataSource<T>& source, size_t chunkRows, std::mt19937& gen)
+{
+	const size_t numOfRows = source.getNumOfRows(), numOfCols = source.getNumOfCols();
+	std::uniform_int_distribution<size_t> dist(0, numOfRows - 1);
+
+	KMeansAlgorithm algorithm = m_algorithm;
+	if (algorithm == KMeansAlgorithm::Auto)
+	{
+		const bool elkanFits = numOfRows <= ElkanMaxBounds / std::max<size_t>(1, m_k);
+		algorithm = m_k >= KDTreeMinClusters && numOfCols <= KDTreeMaxDims ? KMeansAlgorithm::KDTree
+			: m_k >= ElkanMinClusters && elkanFits ? KMeansAlgorithm::Elkan : KMeansAlgorithm::Hamerly;
+	}
+
+	const bool accelerated = algorithm == KMeansAlgorithm::Hamerly || algorithm == KMeansAlgorithm::Elkan;
+	const bool elkan = algorithm == KMeansAlgorithm::Elkan;
+	const bool indexed = algorithm == KMeansAlgorithm::KDTree;
+	m_index.clear();
+
+	// The distance nearestRow uses, so the accelerated steps round exactly as Lloyd
+	const SquaredDistanceFunction<T> distance = squaredDistanceFunction<T>(numOfCols);
+
+	// Work buffers are allocated once, the iterations do not allocate
+	m_labels.assign(numOfRows, 0);
+	BasicMatrix<T> sums(m_k, numOfCols);
+
+	// Each block of points sums into its own partial sums and counts. The
+	// blocks depend only on the shape of the data, and are merged by a fixed
+	// tree, so the centroids do not depend on the number of threads.
+	const size_t numBlocks = accumulationBlocks(numOfRows, m_k * numOfCols);
+	const size_t blockRows = (numOfRows + numBlocks - 1) / numBlocks;
+	BasicMatrix<T> partialSums(numBlocks * m_k, numOfCols);
+	std::vector<size_t> partialCounts(numBlocks * m_k);
+
+	// Chunks hold whole blocks, so the sums are the same for any chunk size
+	chunkRows = std::max<size_t>(1, (chunkRows + blockRows - 1) / blockRows) * blockRows;
+
+	DistanceBounds<T> bounds;
+	if (accelerated)
+	{
+		bounds.upper.assign(numOfRows, T(0));
+		bounds.lower.assign(elkan ? numOfRows * m_k : numOfRows, T(0));
+		bounds.halfCentroidDistances.assign(elkan ? m_k * m_k : 0, T(0));
+		bounds.halfGap.assign(m_k, T(0));
+		bounds.drift.assign(m_k, T(0));
+		bounds.slack = T(1) + T(8 * (numOfCols + 64)) * std::numeric_limits<T>::epsilon();
 	}
 
 	for (size_t it = 0; it < m_maxIterations; ++it)
 	{
-		// Initialise clusters
-		std::vector<std::vector<Point>> clusters(m_k);
+		if (accelerated)
+		{
+			updateCentroidGaps(m_centroids, distance, elkan, bounds);
+		}
+		else if (indexed)
+		{
+			m_index.build(m_centroids.view());
+		}
+
+		// 1. Assign points to nearest clusters and accumulate the block sums
+		std::fill(partialSums.data(), partialSums.data() + numBlocks * m_k * numOfCols, T(0));
+		std::fill(partialCounts.begin(), partialCounts.end(), 0);
 
-		// 1. Assign points to nearest clusters
-		for (const auto& point : X)
+		for (size_t chunkBegin = 0; chunkBegin < numOfRows; chunkBegin += chunkRows)
 		{
-			size_t closestCentroid = getClosestCentroid(point);
-			clusters[closestCentroid].emplace_back(point);
+			const size_t chunkEnd = std::min(numOfRows, chunkBegin + chunkRows);
+			const BasicMatrixView<T> chunk = source.read(chunkBegin, chunkEnd - chunkBegin);
+
+			// Load the next chunk while this one is processed
+			if (chunkEnd < numOfRows)
+			{
+				source.prefetch(chunkEnd, std::min(chunkRows, numOfRows - chunkEnd));
+			}
+
+			parallelFor(chunkBegin / blockRows, (chunkEnd + blockRows - 1) / blockRows, 1, [&](size_t b0, size_t b1)
+			{
+				for (size_t block = b0; block < b1; ++block)
+				{
+					T* blockSums = partialSums.data() + block * m_k * numOfCols;
+					size_t* blockCounts = partialCounts.data() + block * m_k;
+					const size_t end = std::min(numOfRows, (block + 1) * blockRows);
+
+					for (size_t p = block * blockRows; p < end; ++p)
+					{
+						const auto point = chunk.row(p - chunkBegin);
+
+						if (!accelerated)
+						{
+							m_labels[p] = getClosestCentroid(point);
+						}
+						else
+						{
+							m_labels[p] = elkan
+								? assignElkan(point.data(), it == 0, m_labels[p], distance, bounds.halfCentroidDistances.data(),
+									bounds.drift.data(), bounds.halfGap.data(), bounds.slack, bounds.upper[p], bounds.lower.data() + p * m_k)
+								: assignHamerly(point.data(), it == 0, m_labels[p], distance,
+									bounds.halfGap[m_labels[p]], bounds.slack, bounds.upper[p], bounds.lower[p]);
+						}
+
+						T* sum = blockSums + m_labels[p] * numOfCols;
+						++blockCounts[m_labels[p]];
+						for (size_t j = 0; j < numOfCols; ++j) { sum[j] += point[j]; }
+					}
+				}
+			});
 		}
 
-		// 2. Get new centroids as mean of points in clusters
-		std::vector<Point> newCentroids(m_k);
-		for (size_t i = 0; i < m_k; ++i)
+		// 2. Merge the blocks pairwise into the first one
+		for (size_t width = 1; width < numBlocks; width *= 2)
 		{
-			size_t clusterSize = clusters[i].size();
-			
-			if (clusterSize != 0)
+			parallelFor(0, (numBlocks + 2 * width - 1) / (2 * width), 1, [&](size_t b0, size_t b1)
 			{
-				Point sum(X[0].size(), 0.0);
+				for (size_t pair = b0; pair < b1; ++pair)
+				{
+					const size_t dst = pair * 2 * width, src = dst + width;
+					if (src >= numBlocks) { continue; }
+
+					T* to = partialSums.data() + dst * m_k * numOfCols;
+					const T* from = partialSums.data() + src * m_k * numOfCols;
+					for (size_t e = 0; e < m_k * numOfCols; ++e) { to[e] += from[e]; }
 
-				for (const auto& val : clusters[i]) { sum = sum + val; }
+					for (size_t c = 0; c < m_k; ++c) { partialCounts[dst * m_k + c] += partialCounts[src * m_k + c]; }
+				}
+			});
+		}
+
+		// 3. Get new centroids as mean of points in clusters
+		for (size_t i = 0; i < m_k; ++i)
+		{
+			const auto centroid = sums.row(i);
+			const auto sum = partialSums.row(i);
+			const size_t count = partialCounts[i];
 
-				newCentroids[i] = sum / clusterSize;
+			if (count != 0)
+			{
+				for (size_t j = 0; j < numOfCols; ++j) { centroid[j] = sum[j] / count; }
 			}
 			else
 			{
 				// Assign a random value from input
-				newCentroids[i] = X[dist(gen)];
+				const auto row = source.read(dist(gen), 1).row(0);
+				std::copy(row.begin(), row.end(), centroid.begin());
 			}
 		}
 
-		// 3. Calculate change in centroid values
+		// 4. Calculate change in centroid values
 
 		// Store the maximum change in centroid values
-		double maxChange = 0.0;
+		T maxChange = T(0);
 		for (size_t i = 0; i < m_k; ++i)
 		{
 			// Get the maximum change in centroid values
-			maxChange = std::max(maxChange, getEuclideanDistance(m_centroids[i], newCentroids[i]));
+			const T change = euclideanDistance<T>(m_centroids.row(i), sums.row(i));
+			maxChange = std::max(maxChange, change);
+
+			if (accelerated) { bounds.drift[i] = change; }
 		}
 
-		m_centroids = std::move(newCentroids);
+		// The old centroids become the next buffer of new centroids
+		std::swap(m_centroids, sums);
 
 		if (maxChange < m_tolerance)
 		{
 			break;
 		}
+
+		// Another iteration follows, so load its first chunk while the bounds
+		// and the centroid index are updated
+		if (numOfRows > chunkRows && it + 1 < m_maxIterations)
+		{
+			source.prefetch(0, chunkRows);
+		}
+
+		if (accelerated && !elkan)
+		{
+			shiftBounds(m_labels, bounds);
+		}
 	} // for loop
-} // fit function
 
-size_t KMeans::predict(const Point& X) const
+	if (indexed)
+	{
+		// Index the final centroids for predict
+		m_index.build(m_centroids.view());
+	}
+
+	updateCentroidNorms();
+} // iterate function
+
+template <typename T>
+void BasicKMeans<T>::initCentroids(const BasicMatrixView<T>& X, std::mt19937& gen)
+{
+	switch (m_init)
+	{
+	case KMeansInit::KMeansPlusPlus:
+		seedPlusPlus<T>(X, nullptr, gen, m_centroids);
+		break;
+	case KMeansInit::KMeansParallel:
+		seedParallel(X, m_seed, gen, m_centroids);
+		break;
+	default:
+	{
+		// Randomly assign initial centroids
+		std::uniform_int_distribution<size_t> dist(0, X.getNumOfRows() - 1);
+
+		for (size_t i = 0; i < m_k; ++i)
+		{
+			// Assign centroids a random point from input
+			const auto row = X.row(dist(gen));
+			std::copy(row.begin(), row.end(), m_centroids.row(i).begin());
+		}
+		break;
+	}
+	}
+}
+
+template <typename T>
+size_t BasicKMeans<T>::assignHamerly(const T* x, bool first, size_t label, SquaredDistanceFunction<T> distance,
+	T halfGap, T slack, T& upper, T& lower) const
+{
+	const size_t d = m_centroids.getNumOfCols();
+
+	if (!first)
+	{
+		// The centroid is closer than any other when the upper bound is below
+		// both the lower bound and half the gap to the nearest other centroid
+		const T bound = std::max(halfGap, lower);
+		if (upper * slack < bound) { return label; }
+
+		upper = std::sqrt(distance(x, m_centroids.data() + label * d, d));
+		if (upper * slack < bound) { return label; }
+	}
+
+	// Full scan, keeping the closest and second closest centroids
+	T best = std::numeric_limits<T>::max(), second = std::numeric_limits<T>::max();
+	size_t result = 0;
+
+	for (size_t c = 0; c < m_k; ++c)
+	{
+		const T dist = distance(x, m_centroids.data() + c * d, d);
+		if (dist < best)
+		{
+			second = best;
+			best = dist;
+			result = c;
+		}
+		else if (dist < second)
+		{
+			second = dist;
+		}
+	}
+
+	upper = std::sqrt(best);
+	lower = second == std::numeric_limits<T>::max() ? second : std::sqrt(second);
+
+	return result;
+}
+
+template <typename T>
+size_t BasicKMeans<T>::assignElkan(const T* x, bool first, size_t label, SquaredDistanceFunction<T> distance,
+	const T* halfCentroidDistances, const T* drift, const T* halfGap, T slack, T& upper, T* lower) const
+{
+	const size_t d = m_centroids.getNumOfCols();
+
+	if (first)
+	{
+		// Distances to all centroids, each one a tight lower bound
+		T best = std::numeric_limits<T>::max();
+		size_t result = 0;
+
+		for (size_t c = 0; c < m_k; ++c)
+		{
+			const T dist = distance(x, m_centroids.data() + c * d, d);
+			lower[c] = std::sqrt(dist);
+
+			if (dist < best)
+			{
+				best = dist;
+				result = c;
+			}
+		}
+
+		upper = lower[result];
+		return result;
+	}
+
+	// Move the bounds with the centroids
+	for (size_t c = 0; c < m_k; ++c) { lower[c] = std::max(T(0), lower[c] - drift[c]); }
+	T bound = (upper + drift[label]) * slack;
+
+	// Nothing can be closer than half the gap to the nearest other centroid
+	if (bound < halfGap[label])
+	{
+		upper += drift[label];
+		return label;
+	}
+
+	bool tight = false;
+	T bestSquared = T(0);
+	const T* half = halfCentroidDistances + label * m_k;
+
+	for (size_t c = 0; c < m_k; ++c)
+	{
+		if (c == label || bound < lower[c] || bound < half[c])
+		{
+			continue;
+		}
+
+		if (!tight)
+		{
+			// Tighten the upper bound and test again
+			bestSquared = distance(x, m_centroids.data() + label * d, d);
+			bound = std::sqrt(bestSquared) * slack;
+			tight = true;
+
+			if (bound < lower[c] || bound < half[c])
+			{
+				continue;
+			}
+		}
+
+		const T dist = distance(x, m_centroids.data() + c * d, d);
+		lower[c] = std::sqrt(dist);
+
+		// Squared distances and the lower index on ties, as Lloyd decides
+		if (dist < bestSquared || (dist == bestSquared && c < label))
+		{
+			label = c;
+			bestSquared = dist;
+			bound = lower[c] * slack;
+			half = halfCentroidDistances + label * m_k;
+		}
+	}
+
+	upper = tight ? std::sqrt(bestSquared) : upper + drift[label];
+	return label;
+}
+
+template <typename T>
+size_t BasicKMeans<T>::predict(const BasicPoint<T>& X) const
 {
 	// Return the closest centroid
 	return getClosestCentroid(X);
 }
 
-double KMeans::getEuclideanDistance(const Point& a, const Point& b) const
+template <typename T>
+std::vector<size_t> BasicKMeans<T>::predictBatch(const BasicMatrixView<T>& X) const
 {
-	// Return the Euclidean distance between two points
-	return std::sqrt(std::pow(a[0] - b[0], 2) + std::pow(a[1] - b[1], 2));
+	const size_t numOfRows = X.getNumOfRows(), numOfCols = X.getNumOfCols(), k = m_centroids.getNumOfRows();
+
+	if (k == 0)
+	{
+		throw std::invalid_argument("There must be at least one centroid.");
+	}
+	else if (numOfCols != m_centroids.getNumOfCols())
+	{
+		throw std::invalid_argument("Number of columns must match the centroids.");
+	}
+
+	std::vector<size_t> labels(numOfRows);
+	if (numOfRows == 0)
+	{
+		return labels;
+	}
+
+	// Consecutive blocks per worker, each with its own scores and running
+	// minima allocated once here; a row's label does not depend on how the
+	// blocks are shared
+	const size_t numBlocks = (numOfRows + PredictBlockRows - 1) / PredictBlockRows;
+	const size_t numWorkers = std::min(getNumThreads(), numBlocks);
+	const size_t blocksPerWorker = (numBlocks + numWorkers - 1) / numWorkers;
+	std::vector<T> scoreBuffers(numWorkers * PredictBlockRows * PredictBlockCentroids);
+	std::vector<T> minBuffers(numWorkers * PredictBlockRows);
+
+	parallelFor(0, numWorkers, 1, [&](size_t w0, size_t w1)
+	{
+		for (size_t w = w0; w < w1; ++w)
+		{
+			T* scores = scoreBuffers.data() + w * PredictBlockRows * PredictBlockCentroids;
+			T* minScores = minBuffers.data() + w * PredictBlockRows;
+
+			for (size_t block = w * blocksPerWorker; block < std::min(numBlocks, (w + 1) * blocksPerWorker); ++block)
+			{
+				const size_t begin = block * PredictBlockRows, rows = std::min(PredictBlockRows, numOfRows - begin);
+
+				// Centroids a block at a time, so the scores stay bounded however large k is
+				for (size_t c0 = 0; c0 < k; c0 += PredictBlockCentroids)
+				{
+					const size_t width = std::min(PredictBlockCentroids, k - c0);
+
+					// -2 x.c for every row of the block and centroid of the tile
+					gemm<T>(Transpose::No, Transpose::Yes, rows, width, numOfCols, T(-2), X.data() + begin * X.getStride(), X.getStride(),
+						m_centroids.data() + c0 * numOfCols, numOfCols, T(0), scores, width);
+
+					// ||x||^2 is the same for every centroid, so it does not change the argmin
+					for (size_t r = 0; r < rows; ++r)
+					{
+						T* score = scores + r * width;
+						for (size_t c = 0; c < width; ++c) { score[c] += m_centroidNorms[c0 + c]; }
+
+						// Strictly smaller, so ties keep the first centroid as argmin does
+						const size_t best = argmin(score, width);
+						if (c0 == 0 || score[best] < minScores[r])
+						{
+							minScores[r] = score[best];
+							labels[begin + r] = c0 + best;
+						}
+					}
+				}
+			}
+		}
+	});
+
+	return labels;
 }
 
-size_t KMeans::getClosestCentroid(const Point& p) const
+template <typename T>
+void BasicKMeans<T>::updateCentroidNorms()
 {
-	size_t result = 0;
+	const size_t k = m_centroids.getNumOfRows(), d = m_centroids.getNumOfCols();
+	m_centroidNorms.resize(k);
+
+	for (size_t c = 0; c < k; ++c)
+	{
+		const T* centroid = m_centroids.data() + c * d;
+		T norm = T(0);
+		for (size_t j = 0; j < d; ++j) { norm += centroid[j] * centroid[j]; }
+		m_centroidNorms[c] = norm;
+	}
+}
+
+template <typename T>
+std::vector<BasicPoint<T>> BasicKMeans<T>::getCentroids() const
+{
+	std::vector<BasicPoint<T>> centroids(m_centroids.getNumOfRows());
+
+	for (size_t i = 0; i < centroids.size(); ++i)
+	{
+		const auto row = m_centroids.row(i);
+		centroids[i].assign(row.begin(), row.end());
+	}
+
+	return centroids;
+}
+
+template <typename T>
+size_t BasicKMeans<T>::getClosestCentroid(std::span<const T> p) const
+{
+	// Squared distances order the centroids the same way, so no square root is taken
+	return m_index.empty() ? nearestRow(p, m_centroids.view()) : m_index.nearest(p);
+}
+
+template <typename T>
+BasicMiniBatchKMeans<T>::BasicMiniBatchKMeans(size_t k, size_t batchSize, size_t maxIterations, T tolerance, KMeansInit init, uint32_t seed)
+	:BasicKMeans<T>(k, maxIterations, tolerance, KMeansAlgorithm::Lloyd, init, seed), m_batchSize(batchSize), m_sums(0, 0), m_gen(seed)
+{
+	if (batchSize == 0)
+	{
+		throw std::invalid_argument("Batch size must be positive.");
+	}
+}
+
+template <typename T>
+void BasicMiniBatchKMeans<T>::fit(const std::vector<BasicPoint<T>>& X)
+{
+	const BasicMatrix<T> data(X);
+	fit(data.view());
+}
+
+template <typename T>
+void BasicMiniBatchKMeans<T>::fit(const BasicMatrixView<T>& X)
+{
+	if (X.getNumOfRows() == 0 || X.getNumOfCols() == 0)
+	{
+		throw std::invalid_argument("X cannot be empty.");
+	}
+
+	const size_t numOfRows = X.getNumOfRows(), numOfCols = X.getNumOfCols();
+	const size_t k = this->m_k;
+	std::uniform_int_distribution<size_t> dist(0, numOfRows - 1);
+	m_gen.seed(this->m_seed);
+
+	// Seed on a random sample rather than the whole data
+	BasicMatrix<T> batch(std::min(numOfRows, std::max(3 * m_batchSize, k)), numOfCols);
+	for (size_t i = 0; i < batch.getNumOfRows(); ++i)
+	{
+		const auto row = X.row(dist(m_gen));
+		std::copy(row.begin(), row.end(), batch.row(i).begin());
+	}
+
+	this->m_centroids = BasicMatrix<T>(k, numOfCols);
+	this->initCentroids(batch.view(), m_gen);
+	m_counts.assign(k, 0);
 
-	// Initialise the minimum distance to maximum limit
-	double minDist = std::numeric_limits<double>::max();
+	// The batch buffer is reused by every step
+	batch = BasicMatrix<T>(std::min(numOfRows, m_batchSize), numOfCols);
 
-	for (size_t i = 0; i < m_k; ++i)
+	for (size_t it = 0; it < this->m_maxIterations; ++it)
 	{
-		double currDist = getEuclideanDistance(p, m_centroids[i]);
-		if (currDist < minDist)
+		for (size_t i = 0; i < batch.getNumOfRows(); ++i)
+		{
+			const auto row = X.row(dist(m_gen));
+			std::copy(row.begin(), row.end(), batch.row(i).begin());
+		}
+
+		if (update(batch.view()) < this->m_tolerance)
 		{
-			minDist = currDist;
-			result = i;
+			break;
 		}
 	}
 
-	return result;
+	this->m_labels.resize(numOfRows);
+	parallelFor(0, numOfRows, AssignBlockRows, [&](size_t begin, size_t end)
+	{
+		for (size_t p = begin; p < end; ++p) { this->m_labels[p] = this->getClosestCentroid(X.row(p)); }
+	});
+}
+
+template <typename T>
+void BasicMiniBatchKMeans<T>::partialFit(const BasicMatrixView<T>& batch)
+{
+	if (batch.getNumOfRows() == 0 || batch.getNumOfCols() == 0)
+	{
+		throw std::invalid_argument("Batch cannot be empty.");
+	}
+
+	if (m_counts.empty())
+	{
+		if (batch.getNumOfRows() < this->m_k)
+		{
+			throw std::invalid_argument("First batch must have at least k points.");
+		}
+
+		this->m_centroids = BasicMatrix<T>(this->m_k, batch.getNumOfCols());
+		this->initCentroids(batch, m_gen);
+		m_counts.assign(this->m_k, 0);
+	}
+	else if (batch.getNumOfCols() != this->m_centroids.getNumOfCols())
+	{
+		throw std::invalid_argument("Batch must have as many columns as the centroids.");
+	}
+
+	update(batch);
 }
+
+template <typename T>
+T BasicMiniBatchKMeans<T>::update(const BasicMatrixView<T>& batch)
+{
+	const size_t numOfRows = batch.getNumOfRows(), numOfCols = batch.getNumOfCols(), k = this->m_k;
+	std::vector<size_t>& labels = this->m_labels;
+	BasicMatrix<T>& centroids = this->m_centroids;
+
+	// 1. Assign the points, independently of each other
+	labels.resize(numOfRows);
+	parallelFor(0, numOfRows, AssignBlockRows, [&](size_t begin, size_t end)
+	{
+		for (size_t p = begin; p < end; ++p) { labels[p] = this->getClosestCentroid(batch.row(p)); }
+	});
+
+	// 2. Accumulate the batch sums in point order
+	if (m_sums.getNumOfRows() != k || m_sums.getNumOfCols() != numOfCols)
+	{
+		m_sums = BasicMatrix<T>(k, numOfCols);
+	}
+	m_batchCounts.assign(k, 0);
+	std::fill(m_sums.data(), m_sums.data() + k * numOfCols, T(0));
+
+	for (size_t p = 0; p < numOfRows; ++p)
+	{
+		const auto point = batch.row(p);
+		const auto sum = m_sums.row(labels[p]);
+
+		++m_batchCounts[labels[p]];
+		for (size_t j = 0; j < numOfCols; ++j) { sum[j] += point[j]; }
+	}
+
+	// 3. Move each centroid with a learning rate of one over its count, which
+	// keeps it at the mean of all the points it has received
+	T maxChange = T(0);
+	for (size_t c = 0; c < k; ++c)
+	{
+		if (m_batchCounts[c] == 0)
+		{
+			continue;
+		}
+
+		m_counts[c] += m_batchCounts[c];
+		const T rate = T(1) / T(m_counts[c]);
+		const T batchCount = T(m_batchCounts[c]);
+		const auto centroid = centroids.row(c);
+		const auto sum = m_sums.row(c);
+		T change = T(0);
+
+		for (size_t j = 0; j < numOfCols; ++j)
+		{
+			const T step = rate * (sum[j] - batchCount * centroid[j]);
+			centroid[j] += step;
+			change += step * step;
+		}
+
+		maxChange = std::max(maxChange, std::sqrt(change));
+	}
+
+	this->updateCentroidNorms();
+	return maxChange;
+}
+
+template class BasicKMeans<float>;
+template class BasicKMeans<double>;
+template class BasicMiniBatchKMeans<float>;
+template class BasicMiniBatchKMeans<double>;
@@ -1,9 +1,28 @@
 #include "linear_regression.h"
+#include "factorization.h"
+#include "gemm.h"
+#include <algorithm>
 #include <cmath>
+#include <numeric>
 #include <stdexcept>
 
-LinearRegression::LinearRegression(const std::vector<double>& x, const std::vector<double>& y)
-	:m_beta0(0.0), m_beta1(0.0), m_isSimple(true)
+namespace
+{
+	/// <summary>
+	/// Squared Euclidean norm
+	/// </summary>
+	template <typename T>
+	T squaredNorm(const std::vector<T>& v)
+	{
+		T sum = T(0);
+		for (T x : v) { sum += x * x; }
+		return sum;
+	}
+}
+
+template <typename T>
+BasicLinearRegression<T>::BasicLinearRegression(const std::vector<T>& x, const std::vector<T>& y)
+	:m_beta0(0), m_beta1(0), m_isSimple(true), m_numOfIterations(0), m_converged(true)
 {
 	if (x.size() != y.size())
 	{
@@ -11,21 +30,21 @@ LinearRegression::LinearRegression(const std::vector<double>& x, const std::vect
 	}
 
 	size_t size = x.size();
-	double x_sum = 0.0, y_sum = 0.0;
+	T x_sum = 0, y_sum = 0;
 	
-	for (double i : x) x_sum += i;
-	for (double j : y) y_sum += j;
+	for (T i : x) x_sum += i;
+	for (T j : y) y_sum += j;
 
-	double x_mean = x_sum / size, y_mean = y_sum / size;
+	T x_mean = x_sum / size, y_mean = y_sum / size;
 	
-	double num_sum = 0.0, den_sum = 0.0;
+	T num_sum = 0, den_sum = 0;
 	for (size_t i = 0; i < size; ++i)
 	{
 		num_sum += (x[i] - x_mean) * (y[i] - y_mean);
 		den_sum += pow((x[i] - x_mean), 2);
 	}
 
-	if (den_sum == 0.0)
+	if (den_sum == 0)
 	{
 		throw std::runtime_error("Cannot compute regression: all x values are the same.");
 	}
@@ -36,8 +55,9 @@ LinearRegression::LinearRegression(const std::vector<double>& x, const std::vect
 	m_beta0 = y_mean - m_beta1 * x_mean;
 }
 
-LinearRegression::LinearRegression(const Matrix& X, const std::vector<double>& y)
-	:m_beta(std::vector<double>(0)), m_beta0(0.0), m_beta1(0.0), m_isSimple(false)
+template <typename T>
+BasicLinearRegression<T>::BasicLinearRegression(const BasicMatrixView<T>& X, const std::vector<T>& y, LeastSquaresSolver solver)
+	:m_beta(std::vector<T>(0)), m_beta0(0), m_beta1(0), m_isSimple(false), m_numOfIterations(0), m_converged(true)
 {
 	if (X.getNumOfRows() != y.size())
 	{
@@ -49,35 +69,146 @@ LinearRegression::LinearRegression(const Matrix& X, const std::vector<double>& y
 	}
 
 	// Initialise the matrix with addition intercept (+1)
-	Matrix X_with_intercept(X.getNumOfRows(), X.getNumOfCols() + 1);
+	BasicMatrix<T> X_with_intercept(X.getNumOfRows(), X.getNumOfCols() + 1);
 
 	for (size_t i = 0; i < X.getNumOfRows(); ++i)
 	{
-		X_with_intercept(i, 0) = 1.0;
-		for (size_t j = 0; j < X.getNumOfCols(); ++j)
+		const auto src = X.row(i);
+		const auto dst = X_with_intercept.row(i);
+
+		dst[0] = T(1);
+		std::copy(src.begin(), src.end(), dst.begin() + 1);
+	}
+
+	if (solver == LeastSquaresSolver::Cholesky)
+	{
+		// Normal equations: X^T X beta = X^T y, solved through the Cholesky factor of X^T X
+		try
+		{
+			m_beta = BasicCholeskyFactorization<T>(X_with_intercept.gram()).solve(X_with_intercept.transposeTimes(y));
+			return;
+		}
+		catch (const std::runtime_error&)
+		{
+			// X^T X is not numerically positive definite, solve through QR instead
+		}
+	}
+
+	// Least squares on X directly: X = QR, R beta = Q^T y
+	m_beta = BasicQRFactorization<T>(std::move(X_with_intercept)).solve(y);
+}
+
+template <typename T>
+BasicLinearRegression<T>::BasicLinearRegression(const BasicSparseMatrix<T>& X, const std::vector<T>& y, T tolerance, size_t maxIterations)
+	:m_beta(std::vector<T>(0)), m_beta0(0), m_beta1(0), m_isSimple(false), m_numOfIterations(0), m_converged(false)
+{
+	if (X.getNumOfRows() != y.size())
+	{
+		throw std::invalid_argument("Number of observations in X and y must match.");
+	}
+	else if (X.getNumOfRows() == 0 || X.getNumOfCols() == 0)
+	{
+		throw std::invalid_argument("X cannot be empty.");
+	}
+
+	const size_t numOfRows = X.getNumOfRows(), numOfCols = X.getNumOfCols();
+
+	// Least squares on A = [1 X] by conjugate gradients on the normal
+	// equations (CGLS), which only needs the products A v and A^T r, so
+	// memory stays linear in the rows, columns and non-zeros. Columns are scaled
+	// to unit norm, and an all-zero column gets scale zero and coefficient
+	// zero: from zero weights the iterations converge to the minimum-norm
+	// solution, so singular problems need no fallback.
+	std::vector<T> scale(numOfCols + 1, T(0));
+	scale[0] = T(numOfRows);
+	for (size_t i = 0; i < numOfRows; ++i)
+	{
+		const auto indices = X.rowIndices(i);
+		const auto values = X.rowValues(i);
+		for (size_t k = 0; k < indices.size(); ++k) { scale[indices[k] + 1] += values[k] * values[k]; }
+	}
+	for (T& d : scale) { d = d > T(0) ? T(1) / std::sqrt(d) : T(0); }
+
+	// q = A D p
+	std::vector<T> scaled(numOfCols + 1);
+	const auto product = [&](const std::vector<T>& p, std::vector<T>& q)
+	{
+		for (size_t j = 0; j <= numOfCols; ++j) { scaled[j] = scale[j] * p[j]; }
+		std::fill(q.begin(), q.end(), scaled[0]);
+		X.multiply(Transpose::No, T(1), scaled.data() + 1, T(1), q.data());
+	};
+
+	// s = D A^T r, through X^T formed once so the product is row-parallel
+	// however wide X is
+	const BasicSparseMatrix<T> columns = X.transpose();
+	const auto transposedProduct = [&](const std::vector<T>& r, std::vector<T>& s)
+	{
+		s[0] = std::accumulate(r.begin(), r.end(), T(0));
+		columns.multiply(Transpose::No, T(1), r.data(), T(0), s.data() + 1);
+		for (size_t j = 0; j <= numOfCols; ++j) { s[j] *= scale[j]; }
+	};
+
+	std::vector<T> z(numOfCols + 1, T(0)), residual(y), s(numOfCols + 1), p(numOfCols + 1), q(numOfRows);
+	transposedProduct(residual, s);
+	p = s;
+
+	// Every non-zero scaled column has unit norm, so this is ||A D||_F
+	const T matrixNorm = std::sqrt(T(std::count_if(scale.begin(), scale.end(), [](T d) { return d > T(0); })));
+	const T targetNorm = std::sqrt(squaredNorm(y));
+
+	T gamma = squaredNorm(s);
+
+	for (m_numOfIterations = 0; ; ++m_numOfIterations)
+	{
+		// Stop once y is fitted, or once the normal equations residual is small
+		// against the least squares residual (the LSQR stopping rules). Both
+		// stay within rounding reach on ill-conditioned data, where convergence
+		// is merely slower and may run into maxIterations
+		const T residualNorm = std::sqrt(squaredNorm(residual));
+		if (residualNorm <= tolerance * targetNorm || std::sqrt(gamma) <= tolerance * matrixNorm * residualNorm)
+		{
+			m_converged = true;
+			break;
+		}
+		else if (m_numOfIterations == maxIterations)
 		{
-			X_with_intercept(i, j + 1) = X(i, j);
+			break;
 		}
+
+		product(p, q);
+		const T curvature = squaredNorm(q);
+		if (!(curvature > T(0)))
+		{
+			// p, and so the gradient, vanished
+			m_converged = true;
+			break;
+		}
+
+		const T alpha = gamma / curvature;
+		for (size_t j = 0; j <= numOfCols; ++j) { z[j] += alpha * p[j]; }
+		for (size_t i = 0; i < numOfRows; ++i) { residual[i] -= alpha * q[i]; }
+
+		transposedProduct(residual, s);
+		const T nextGamma = squaredNorm(s);
+		const T beta = nextGamma / gamma;
+		for (size_t j = 0; j <= numOfCols; ++j) { p[j] = s[j] + beta * p[j]; }
+		gamma = nextGamma;
 	}
 
-	// Normal equations: beta = (X^T X)^(-1) X^T y
-	// X^T * X
-	Matrix XTX = X_with_intercept.transpose() * X_with_intercept;
-	// Inverse of X^T * X
-	Matrix XTX_inv = XTX.inverse();
-	// X^T * y
-	std::vector<double> XTy = X_with_intercept.transpose() * y;
-	// Get coefficients or beta
-	m_beta = XTX_inv * XTy;
+	// Back to the unscaled coefficients
+	m_beta.resize(numOfCols + 1);
+	for (size_t j = 0; j <= numOfCols; ++j) { m_beta[j] = scale[j] * z[j]; }
 }
 
-double LinearRegression::predict(double x) const
+template <typename T>
+T BasicLinearRegression<T>::predict(T x) const
 {
 	// Return the predicted value
 	return m_beta0 + m_beta1 * x;
 }
 
-double LinearRegression::predict(std::vector<double>& X) const
+template <typename T>
+T BasicLinearRegression<T>::predict(std::vector<T>& X) const
 {
 	if (m_isSimple)
 	{
@@ -89,7 +220,7 @@ double LinearRegression::predict(std::vector<double>& X) const
 	}
 
 	// Prediction value equal to intercept
-	double prediction = m_beta[0];
+	T prediction = m_beta[0];
 
 	for (size_t i = 0; i < X.size(); ++i)
 	{
@@ -100,20 +231,87 @@ double LinearRegression::predict(std::vector<double>& X) const
 	return prediction;
 }
 
-double LinearRegression::getIntercept() const
+template <typename T>
+std::vector<T> BasicLinearRegression<T>::predict(const BasicSparseMatrix<T>& X) const
+{
+	if (m_isSimple)
+	{
+		throw std::invalid_argument("Use scalar predict for simple linear regression");
+	}
+	else if (X.getNumOfCols() != m_beta.size() - 1)
+	{
+		throw std::invalid_argument("Feature vector size must match number of coefficients (excluding intercept).");
+	}
+
+	// Predictions equal to the intercept plus X times the remaining coefficients
+	std::vector<T> predictions(X.getNumOfRows(), m_beta[0]);
+	X.multiply(Transpose::No, T(1), m_beta.data() + 1, T(1), predictions.data());
+
+	return predictions;
+}
+
+template <typename T>
+void BasicLinearRegression<T>::predictBatch(const BasicMatrixView<T>& X, std::span<T> out) const
+{
+	const size_t numOfRows = X.getNumOfRows();
+
+	if (X.getNumOfCols() != (m_isSimple ? 1 : m_beta.size() - 1))
+	{
+		throw std::invalid_argument("Feature vector size must match number of coefficients (excluding intercept).");
+	}
+	else if (out.size() != numOfRows)
+	{
+		throw std::invalid_argument("Output size must match the number of rows of X.");
+	}
+
+	if (m_isSimple)
+	{
+		// Sizes are validated, the single column is read through the stride
+		const T* x = X.data();
+		for (size_t i = 0; i < numOfRows; ++i)
+		{
+			out[i] = m_beta0 + m_beta1 * x[i * X.getStride()];
+		}
+		return;
+	}
+
+	// Predictions equal to the intercept plus X times the remaining coefficients
+	std::fill(out.begin(), out.end(), m_beta[0]);
+	gemv<T>(Transpose::No, numOfRows, X.getNumOfCols(), T(1), X.data(), X.getStride(), m_beta.data() + 1, T(1), out.data());
+}
+
+template <typename T>
+T BasicLinearRegression<T>::getIntercept() const
 {
 	// Return the intercept
 	return m_beta0;
 }
 
-double LinearRegression::getSlope() const
+template <typename T>
+T BasicLinearRegression<T>::getSlope() const
 {
 	// Return the slope
 	return m_beta1;
 }
 
-std::vector<double> LinearRegression::getCoefficients() const
+template <typename T>
+std::vector<T> BasicLinearRegression<T>::getCoefficients() const
 {
 	// Return the coefficients
 	return m_beta;
 }
+
+template <typename T>
+size_t BasicLinearRegression<T>::getNumOfIterations() const
+{
+	return m_numOfIterations;
+}
+
+template <typename T>
+bool BasicLinearRegression<T>::hasConverged() const
+{
+	return m_converged;
+}
+
+template class BasicLinearRegression<float>;
+template class BasicLinearRegression<double>;
@@ -1,44 +1,827 @@
 #include "logistic_regression.h"
+#include "factorization.h"
+#include "gemm.h"
+#include "thread_pool.h"
+#include "vector_math.h"
 #include "vector_utils.h"
+#include <algorithm>
+#include <atomic>
 #include <cmath>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <stdexcept>
 
-LogisticRegression::LogisticRegression(double learningRate, size_t iterations)
-	:m_learningRate(learningRate), m_iterations(iterations), m_weights(std::vector<double>(0)), m_data(nullptr)
+namespace
 {
+	// Upper bound on the row blocks of a gradient pass, each with its own partial gradient
+	constexpr size_t MaxGradientBlocks = 64;
+
+	// Smallest number of rows per block of a gradient pass
+	constexpr size_t MinGradientBlockRows = 1024;
+
+	// Number of rows weighted at a time into the Gram matrix of a Newton step
+	constexpr size_t HessianBlockRows = 4096;
+
+	// Number of correction pairs kept by L-BFGS
+	constexpr size_t LBFGSMemory = 10;
+
+	// Fraction of the decrease predicted by the slope that a line search step must achieve
+	constexpr double ArmijoFactor = 1e-4;
+
+	// Largest number of times a line search halves the step
+	constexpr size_t MaxLineSearchSteps = 40;
+
+	// Exponential decay rates of the Adam moment estimates
+	constexpr double AdamBeta1 = 0.9;
+	constexpr double AdamBeta2 = 0.999;
+
+	// Added to the Adam denominator
+	constexpr double AdamEpsilon = 1e-8;
+
+	/// <summary>
+	/// Dot product of a row with the weights, the intercept being an
+	/// implicit leading one
+	/// </summary>
+	template <typename T>
+	inline T margin(const T* x, size_t numOfCols, const T* weights)
+	{
+		// Four independent sums, so the dot product is not one chain of additions
+		T z0 = weights[0], z1 = T(0), z2 = T(0), z3 = T(0);
+		size_t j = 0;
+		for (; j + 4 <= numOfCols; j += 4)
+		{
+			z0 += x[j] * weights[j + 1]; z1 += x[j + 1] * weights[j + 2];
+			z2 += x[j + 2] * weights[j + 3]; z3 += x[j + 3] * weights[j + 4];
+		}
+		for (; j < numOfCols; ++j) { z0 += x[j] * weights[j + 1]; }
+
+		return (z0 + z1) + (z2 + z3);
+	}
+
+	/// <summary>
+	/// Add the logistic loss gradient of one row to a gradient, reading the
+	/// row once for its margin, sigmoid and error
+	/// </summary>
+	/// <returns>Margin of the row</returns>
+	template <typename T>
+	inline T accumulateGradient(const T* x, size_t numOfCols, const T* weights, T y, T* gradient)
+	{
+		const T z = margin(x, numOfCols, weights);
+		const T error = T(1) / (T(1) + std::exp(-z)) - y;
+
+		gradient[0] += error;
+		for (size_t j = 0; j < numOfCols; ++j) { gradient[j + 1] += error * x[j]; }
+
+		return z;
+	}
+
+	/// <summary>
+	/// Logistic loss of a row from its margin, log(1 + exp(z)) - y z written
+	/// so that exp never overflows
+	/// </summary>
+	template <typename T>
+	inline T logisticLoss(T z, T y)
+	{
+		return std::max(z, T(0)) + std::log1p(std::exp(-std::abs(z))) - y * z;
+	}
+
+	/// <summary>
+	/// Fused pass of the logistic loss gradient over blocks of rows
+	/// </summary>
+	template <typename T>
+	struct GradientPass
+	{
+		const BasicMatrixView<T>& X;
+		const T* y;
+		const T* weights;
+		size_t blockRows;
+
+		// Partial gradient of each block, one per column plus the intercept,
+		// followed by the partial loss
+		T* partials;
+
+		// Whether the loss is summed as well
+		bool withLoss;
+
+		void operator()(size_t b0, size_t b1) const
+		{
+			const size_t numOfRows = X.getNumOfRows(), numOfCols = X.getNumOfCols();
+
+			for (size_t block = b0; block < b1; ++block)
+			{
+				T* gradient = partials + block * (numOfCols + 2);
+				std::fill(gradient, gradient + numOfCols + 1, T(0));
+
+				const size_t end = std::min(numOfRows, (block + 1) * blockRows);
+				T loss = T(0);
+
+				for (size_t i = block * blockRows; i < end; ++i)
+				{
+					const T z = accumulateGradient(X.row(i).data(), numOfCols, weights, y[i], gradient);
+
+					if (withLoss)
+					{
+						loss += logisticLoss(z, y[i]);
+					}
+				}
+
+				gradient[numOfCols + 1] = loss;
+			}
+		}
+	};
+
+	/// <summary>
+	/// Sums of the logistic loss and its gradient over all rows, by parallel
+	/// gradient passes. Rows are split in blocks fixed by the shape of X and
+	/// the partial sums added in block order, so the sums do not depend on
+	/// the number of threads. The partials are allocated once, evaluations
+	/// do not allocate.
+	/// </summary>
+	template <typename T>
+	class GradientEvaluator
+	{
+	public:
+		GradientEvaluator(const BasicMatrixView<T>& X, const std::vector<T>& y)
+			:m_X(X), m_y(y.data()),
+			m_numBlocks(std::clamp<size_t>((X.getNumOfRows() + MinGradientBlockRows - 1) / MinGradientBlockRows, 1, MaxGradientBlocks)),
+			m_blockRows((X.getNumOfRows() + m_numBlocks - 1) / m_numBlocks), m_partials(m_numBlocks * (X.getNumOfCols() + 2))
+		{}
+
+		/// <summary>
+		/// Evaluate at some weights
+		/// </summary>
+		/// <param name="weights">Weights, the intercept first</param>
+		/// <param name="gradient">Receives the summed gradient, one per weight</param>
+		/// <param name="withLoss">Whether to sum the loss</param>
+		/// <returns>Summed loss, zero when not requested</returns>
+		T operator()(const T* weights, T* gradient, bool withLoss)
+		{
+			const size_t stride = m_X.getNumOfCols() + 2;
+			const GradientPass<T> pass{ m_X, m_y, weights, m_blockRows, m_partials.data(), withLoss };
+
+			parallelFor(0, m_numBlocks, 1, [&pass](size_t b0, size_t b1) { pass(b0, b1); });
+
+			for (size_t block = 1; block < m_numBlocks; ++block)
+			{
+				const T* partial = m_partials.data() + block * stride;
+				for (size_t j = 0; j < stride; ++j) { m_partials[j] += partial[j]; }
+			}
+
+			std::copy(m_partials.begin(), m_partials.begin() + stride - 1, gradient);
+			return m_partials[stride - 1];
+		}
+
+	private:
+		const BasicMatrixView<T>& m_X;
+		const T* m_y;
+		size_t m_numBlocks;
+		size_t m_blockRows;
+		std::vector<T> m_partials;
+	};
+
+	/// <summary>
+	/// Mean loss and gradient, the gradient written in place of the sums
+	/// </summary>
+	template <typename T>
+	inline T evaluateMean(GradientEvaluator<T>& evaluate, const std::vector<T>& weights, std::vector<T>& gradient, T scale)
+	{
+		const T loss = evaluate(weights.data(), gradient.data(), true) * scale;
+		for (T& g : gradient) { g *= scale; }
+		return loss;
+	}
+
+	/// <summary>
+	/// Backtracking line search along a descent direction, halving the step
+	/// from one until the loss decreases enough
+	/// </summary>
+	/// <returns>Whether a step was found, then the trial point, gradient and loss hold it</returns>
+	template <typename T>
+	bool lineSearch(GradientEvaluator<T>& evaluate, T scale, const std::vector<T>& weights, const std::vector<T>& direction,
+		T loss, T slope, std::vector<T>& trial, std::vector<T>& trialGradient, T& trialLoss)
+	{
+		T t = T(1);
+
+		for (size_t attempt = 0; attempt < MaxLineSearchSteps; ++attempt, t *= T(0.5))
+		{
+			for (size_t j = 0; j < weights.size(); ++j) { trial[j] = weights[j] + t * direction[j]; }
+
+			trialLoss = evaluateMean(evaluate, trial, trialGradient, scale);
+
+			if (trialLoss <= loss + T(ArmijoFactor) * t * slope)
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	template <typename T>
+	inline T relaxedLoad(T& value)
+	{
+		return std::atomic_ref<T>(value).load(std::memory_order_relaxed);
+	}
+
+	template <typename T>
+	inline void relaxedStore(T& value, T newValue)
+	{
+		std::atomic_ref<T>(value).store(newValue, std::memory_order_relaxed);
+	}
+
+	/// <summary>
+	/// Hogwild epochs: one worker per thread, each with its own random
+	/// stream, samples as many rows as its share of an epoch and applies
+	/// their updates to the shared weights without synchronization. Workers
+	/// only meet at the end of an epoch, where the weights can be averaged.
+	/// </summary>
+	/// <param name="update">Callable applying the update of a row, taking the weights and the row index</param>
+	template <typename T, typename Update>
+	void runHogwild(std::vector<T>& weights, size_t numOfRows, size_t epochs, uint32_t seed, bool average, const Update& update)
+	{
+		if (numOfRows == 0)
+		{
+			return;
+		}
+
+		const size_t numWorkers = std::min(getNumThreads(), numOfRows);
+		const size_t rowsPerWorker = (numOfRows + numWorkers - 1) / numWorkers;
+
+		std::vector<std::mt19937> generators;
+		for (size_t w = 0; w < numWorkers; ++w)
+		{
+			std::seed_seq sequence{ seed, static_cast<uint32_t>(w) };
+			generators.emplace_back(sequence);
+		}
+
+		std::vector<T> sum(average ? weights.size() : 0, T(0));
+
+		for (size_t epoch = 0; epoch < epochs; ++epoch)
+		{
+			parallelFor(0, numWorkers, 1, [&](size_t w0, size_t w1)
+			{
+				for (size_t w = w0; w < w1; ++w)
+				{
+					std::uniform_int_distribution<size_t> dist(0, numOfRows - 1);
+					for (size_t u = 0; u < rowsPerWorker; ++u) { update(weights.data(), dist(generators[w])); }
+				}
+			});
+
+			for (size_t j = 0; j < sum.size(); ++j) { sum[j] += weights[j]; }
+		}
+
+		if (average && epochs != 0)
+		{
+			for (size_t j = 0; j < weights.size(); ++j) { weights[j] = sum[j] / T(epochs); }
+		}
+	}
+
+	template <typename T>
+	inline T largestMagnitude(const std::vector<T>& v)
+	{
+		T result = T(0);
+		for (T value : v) { result = std::max(result, std::abs(value)); }
+		return result;
+	}
+
+	template <typename T>
+	inline T dot(const std::vector<T>& a, const std::vector<T>& b)
+	{
+		return std::inner_product(a.begin(), a.end(), b.begin(), T(0));
+	}
+}
+
+template <typename T>
+BasicLogisticRegression<T>::BasicLogisticRegression(T learningRate, size_t iterations, LogisticSolver solver, size_t batchSize, uint32_t seed,
+	T tolerance, bool averageWeights)
+	:m_learningRate(learningRate), m_iterations(iterations), m_weights(std::vector<T>(0)), m_solver(solver), m_batchSize(batchSize),
+	m_seed(seed), m_steps(0), m_tolerance(tolerance), m_averageWeights(averageWeights), m_numOfIterations(0), m_loss(std::numeric_limits<T>::quiet_NaN())
+{
+	if (batchSize == 0)
+	{
+		throw std::invalid_argument("Batch size must be positive.");
+	}
 }
 
-void LogisticRegression::fit(const Matrix& X, const std::vector<double>& y)
+template <typename T>
+void BasicLogisticRegression<T>::fit(const BasicMatrixView<T>& X, const std::vector<T>& y)
 {
 	if (X.getNumOfRows() != y.size())
 	{
 		throw std::invalid_argument("Number of observations in X and y must match.");
 	}
+	else if (y.empty())
+	{
+		throw std::invalid_argument("X cannot be empty.");
+	}
 
 	size_t numOfRows = X.getNumOfRows(), numOfCols = X.getNumOfCols();
-	m_weights = std::vector<double>(numOfCols + 1, 0.0);
 
-	m_data = std::make_unique<Matrix>(numOfRows, numOfCols + 1);
-	
+	if (m_solver == LogisticSolver::SGD || m_solver == LogisticSolver::Adam)
+	{
+		// A single chunk, so every epoch shuffles all rows
+		BasicViewSource<T> features(X);
+		BasicViewSource<T> labels(BasicMatrixView<T>(y.data(), numOfRows, 1));
+		fit(features, labels, std::max<size_t>(numOfRows, 1));
+		return;
+	}
+
+	if (m_solver == LogisticSolver::LBFGS)
+	{
+		fitLBFGS(X, y);
+		return;
+	}
+	else if (m_solver == LogisticSolver::IRLS)
+	{
+		fitIRLS(X, y);
+		return;
+	}
+	else if (m_solver == LogisticSolver::Hogwild)
+	{
+		reset(numOfCols);
+
+		const T rate = m_learningRate;
+		runHogwild(m_weights, numOfRows, m_iterations, m_seed, m_averageWeights, [&X, &y, rate](T* weights, size_t i)
+		{
+			const T* x = X.row(i).data();
+			const size_t numOfCols = X.getNumOfCols();
+
+			T z = relaxedLoad(weights[0]);
+			for (size_t j = 0; j < numOfCols; ++j) { z += x[j] * relaxedLoad(weights[j + 1]); }
+
+			const T step = rate * (T(1) / (T(1) + std::exp(-z)) - y[i]);
+
+			relaxedStore(weights[0], relaxedLoad(weights[0]) - step);
+			for (size_t j = 0; j < numOfCols; ++j) { relaxedStore(weights[j + 1], relaxedLoad(weights[j + 1]) - step * x[j]); }
+		});
+
+		m_numOfIterations = m_iterations;
+		return;
+	}
+
+	reset(numOfCols);
+
+	GradientEvaluator<T> evaluate(X, y);
+	const T stepSize = m_learningRate / T(numOfRows);
+
+	for (size_t k = 0; k < m_iterations; ++k)
+	{
+		evaluate(m_weights.data(), m_gradient.data(), false);
+
+		// Weights are updated in place
+		for (size_t j = 0; j <= numOfCols; ++j) { m_weights[j] -= stepSize * m_gradient[j]; }
+	}
+
+	m_numOfIterations = m_iterations;
+	m_loss = evaluate(m_weights.data(), m_gradient.data(), true) / T(numOfRows);
+}
+
+template <typename T>
+void BasicLogisticRegression<T>::fitLBFGS(const BasicMatrixView<T>& X, const std::vector<T>& y)
+{
+	const size_t numOfRows = X.getNumOfRows(), numOfWeights = X.getNumOfCols() + 1;
+	reset(X.getNumOfCols());
+
+	GradientEvaluator<T> evaluate(X, y);
+	const T scale = T(1) / T(numOfRows);
+	T loss = evaluateMean(evaluate, m_weights, m_gradient, scale);
+
+	// Inverse of the Hessian diagonal at zero weights, 1 / (p (1 - p) E[x^2])
+	// with p = 1/2, which preconditions the Hessian estimate so that badly
+	// scaled columns do not slow convergence down
+	std::vector<T> diagonal(numOfWeights, T(0));
+	diagonal[0] = T(numOfRows);
 	for (size_t i = 0; i < numOfRows; ++i)
 	{
-		(*m_data)(i,0) = 1.0;
+		const auto x = X.row(i);
+		for (size_t j = 0; j < X.getNumOfCols(); ++j) { diagonal[j + 1] += x[j] * x[j]; }
+	}
+	for (T& d : diagonal) { d = d > T(0) ? T(4) * T(numOfRows) / d : T(4); }
+
+	// Last correction pairs, differences of the weights and of the gradients
+	// between iterations, the newest at index (first + count - 1) % LBFGSMemory
+	std::vector<std::vector<T>> weightChanges(LBFGSMemory, std::vector<T>(numOfWeights)), gradientChanges(weightChanges);
+	std::vector<T> rho(LBFGSMemory), alpha(LBFGSMemory);
+	size_t first = 0, count = 0;
+
+	std::vector<T> direction(numOfWeights), trial(numOfWeights), trialGradient(numOfWeights);
+	std::vector<T> weightChange(numOfWeights), gradientChange(numOfWeights);
+
+	m_numOfIterations = 0;
+
+	while (m_numOfIterations < m_iterations && largestMagnitude(m_gradient) > m_tolerance)
+	{
+		// Two-loop recursion, the direction is minus the inverse Hessian
+		// estimate times the gradient
+		for (size_t j = 0; j < numOfWeights; ++j) { direction[j] = -m_gradient[j]; }
+
+		for (size_t c = count; c-- > 0;)
+		{
+			const size_t p = (first + c) % LBFGSMemory;
+			alpha[p] = rho[p] * dot(weightChanges[p], direction);
+			for (size_t j = 0; j < numOfWeights; ++j) { direction[j] -= alpha[p] * gradientChanges[p][j]; }
+		}
+
+		// The initial estimate is the preconditioner, scaled to the curvature of the newest pair
+		T gamma = T(1);
+		if (count != 0)
+		{
+			const size_t newest = (first + count - 1) % LBFGSMemory;
+			T scaledNorm = T(0);
+			for (size_t j = 0; j < numOfWeights; ++j) { scaledNorm += gradientChanges[newest][j] * diagonal[j] * gradientChanges[newest][j]; }
+			gamma = dot(weightChanges[newest], gradientChanges[newest]) / scaledNorm;
+		}
+		for (size_t j = 0; j < numOfWeights; ++j) { direction[j] *= gamma * diagonal[j]; }
+
+		for (size_t c = 0; c < count; ++c)
+		{
+			const size_t p = (first + c) % LBFGSMemory;
+			const T beta = rho[p] * dot(gradientChanges[p], direction);
+			for (size_t j = 0; j < numOfWeights; ++j) { direction[j] += (alpha[p] - beta) * weightChanges[p][j]; }
+		}
+
+		T slope = dot(m_gradient, direction);
 
-		for (size_t j = 0; j < numOfCols; ++j)
+		// Restart from the preconditioned gradient when the estimate stops giving a descent direction
+		if (!(slope < T(0)))
 		{
-			(*m_data)(i, j + 1) = X(i, j);
+			count = 0;
+			for (size_t j = 0; j < numOfWeights; ++j) { direction[j] = -diagonal[j] * m_gradient[j]; }
+			slope = dot(m_gradient, direction);
+		}
+
+		T trialLoss;
+		if (!lineSearch(evaluate, scale, m_weights, direction, loss, slope, trial, trialGradient, trialLoss))
+		{
+			break;
+		}
+
+		++m_numOfIterations;
+
+		for (size_t j = 0; j < numOfWeights; ++j)
+		{
+			weightChange[j] = trial[j] - m_weights[j];
+			gradientChange[j] = trialGradient[j] - m_gradient[j];
+		}
+
+		// Keep the pair only when the curvature is positive, so the estimate
+		// stays positive definite; a full memory drops its oldest pair
+		const T curvature = dot(weightChange, gradientChange);
+		if (curvature > T(0))
+		{
+			const size_t p = (first + count) % LBFGSMemory;
+			std::swap(weightChanges[p], weightChange);
+			std::swap(gradientChanges[p], gradientChange);
+			rho[p] = T(1) / curvature;
+
+			if (count < LBFGSMemory) { ++count; }
+			else { first = (first + 1) % LBFGSMemory; }
+		}
+
+		std::swap(m_weights, trial);
+		std::swap(m_gradient, trialGradient);
+
+		const T decrease = loss - trialLoss;
+		loss = trialLoss;
+
+		if (decrease <= m_tolerance * loss)
+		{
+			break;
 		}
 	}
 
+	m_loss = loss;
+}
+
+template <typename T>
+void BasicLogisticRegression<T>::fitIRLS(const BasicMatrixView<T>& X, const std::vector<T>& y)
+{
+	const size_t numOfRows = X.getNumOfRows(), numOfCols = X.getNumOfCols(), numOfWeights = numOfCols + 1;
+	reset(numOfCols);
+
+	GradientEvaluator<T> evaluate(X, y);
+	const T scale = T(1) / T(numOfRows);
+	T loss = evaluateMean(evaluate, m_weights, m_gradient, scale);
+
+	BasicMatrix<T> hessian(numOfWeights, numOfWeights);
+	std::vector<T> weighted(std::min(HessianBlockRows, numOfRows) * numOfWeights);
+	std::vector<T> direction(numOfWeights), trial(numOfWeights), trialGradient(numOfWeights);
+
+	m_numOfIterations = 0;
+
+	while (m_numOfIterations < m_iterations && largestMagnitude(m_gradient) > m_tolerance)
+	{
+		// Hessian of the mean loss, the Gram matrix of the rows with their
+		// leading one scaled by sqrt(p (1 - p) / n), built a block of rows at
+		// a time so X is never copied whole
+		for (size_t first = 0; first < numOfRows; first += HessianBlockRows)
+		{
+			const size_t count = std::min(HessianBlockRows, numOfRows - first);
+
+			parallelFor(0, count, MinGradientBlockRows, [&](size_t i0, size_t i1)
+			{
+				for (size_t i = i0; i < i1; ++i)
+				{
+					const T* x = X.row(first + i).data();
+					const T p = sigmoid(margin(x, numOfCols, m_weights.data()));
+					const T r = std::sqrt(p * (T(1) - p) * scale);
+
+					T* row = weighted.data() + i * numOfWeights;
+					row[0] = r;
+					for (size_t j = 0; j < numOfCols; ++j) { row[j + 1] = r * x[j]; }
+				}
+			});
+
+			syrk<T>(numOfWeights, count, T(1), weighted.data(), numOfWeights, first == 0 ? T(0) : T(1), hessian.data(), numOfWeights);
+		}
+
+		for (size_t i = 0; i < numOfWeights; ++i)
+		{
+			for (size_t j = 0; j < i; ++j) { hessian(i, j) = hessian(j, i); }
+		}
+
+		// Newton direction; separable data drives p (1 - p) to zero until the
+		// Hessian is no longer numerically positive definite, which ends the fit
+		try
+		{
+			direction = BasicCholeskyFactorization<T>(hessian).solve(m_gradient);
+		}
+		catch (const std::runtime_error&)
+		{
+			break;
+		}
+
+		for (T& d : direction) { d = -d; }
+		const T slope = dot(m_gradient, direction);
+
+		T trialLoss;
+		if (!(slope < T(0)) || !lineSearch(evaluate, scale, m_weights, direction, loss, slope, trial, trialGradient, trialLoss))
+		{
+			break;
+		}
+
+		++m_numOfIterations;
+
+		std::swap(m_weights, trial);
+		std::swap(m_gradient, trialGradient);
+
+		const T decrease = loss - trialLoss;
+		loss = trialLoss;
+
+		if (decrease <= m_tolerance * loss)
+		{
+			break;
+		}
+	}
+
+	m_loss = loss;
+}
+
+template <typename T>
+void BasicLogisticRegression<T>::fit(BasicDataSource<T>& X, BasicDataSource<T>& y, size_t chunkRows, bool shuffle)
+{
+	const size_t numOfRows = X.getNumOfRows();
+
+	if (numOfRows != y.getNumOfRows() || y.getNumOfCols() != 1)
+	{
+		throw std::invalid_argument("Number of observations in X and y must match.");
+	}
+	else if (&X == &y)
+	{
+		// Reading y would overwrite the chunk of X still in use
+		throw std::invalid_argument("X and y must be different sources.");
+	}
+	else if (numOfRows == 0)
+	{
+		throw std::invalid_argument("X cannot be empty.");
+	}
+	else if (chunkRows == 0)
+	{
+		throw std::invalid_argument("Chunk size must be positive.");
+	}
+	else if (m_solver != LogisticSolver::SGD && m_solver != LogisticSolver::Adam)
+	{
+		throw std::invalid_argument("Streaming fits need the SGD or Adam solver.");
+	}
+
+	reset(X.getNumOfCols());
+
+	std::mt19937 gen(m_seed);
+
+	chunkRows = std::min(chunkRows, numOfRows);
+	const size_t numChunks = (numOfRows + chunkRows - 1) / chunkRows;
+
+	// Order of the chunks in the epoch, and of the rows in the chunk
+	std::vector<size_t> chunks(numChunks), rows(chunkRows);
+	std::iota(chunks.begin(), chunks.end(), size_t(0));
+
+	if (shuffle)
+	{
+		std::shuffle(chunks.begin(), chunks.end(), gen);
+	}
+
+	for (size_t epoch = 0; epoch < m_iterations; ++epoch)
+	{
+		for (size_t c = 0; c < numChunks; ++c)
+		{
+			const size_t first = chunks[c] * chunkRows, count = std::min(chunkRows, numOfRows - first);
+			const BasicMatrixView<T> features = X.read(first, count);
+			const BasicMatrixView<T> labels = y.read(first, count);
+
+			// The next chunk is known before working on this one, the first of
+			// the next epoch once its order is drawn
+			if (c + 1 == numChunks && shuffle)
+			{
+				std::shuffle(chunks.begin(), chunks.end(), gen);
+			}
+
+			if (c + 1 < numChunks || epoch + 1 < m_iterations)
+			{
+				const size_t next = chunks[(c + 1) % numChunks] * chunkRows, nextCount = std::min(chunkRows, numOfRows - next);
+				X.prefetch(next, nextCount);
+				y.prefetch(next, nextCount);
+			}
+
+			std::iota(rows.begin(), rows.begin() + count, size_t(0));
+
+			if (shuffle)
+			{
+				std::shuffle(rows.begin(), rows.begin() + count, gen);
+			}
+
+			for (size_t b = 0; b < count; b += m_batchSize)
+			{
+				step(features, labels, rows.data() + b, std::min(m_batchSize, count - b));
+			}
+		}
+	}
+
+	m_numOfIterations = m_iterations;
+}
+
+template <typename T>
+void BasicLogisticRegression<T>::partialFit(const BasicMatrixView<T>& X, const std::vector<T>& y)
+{
+	const size_t numOfRows = X.getNumOfRows(), numOfCols = X.getNumOfCols();
+
+	if (numOfRows != y.size())
+	{
+		throw std::invalid_argument("Number of observations in X and y must match.");
+	}
+	else if (m_solver != LogisticSolver::SGD && m_solver != LogisticSolver::Adam)
+	{
+		throw std::invalid_argument("Partial fits need the SGD or Adam solver.");
+	}
+	else if (m_weights.empty())
+	{
+		reset(numOfCols);
+	}
+	else if (numOfCols != m_weights.size() - 1)
+	{
+		throw std::invalid_argument("Number of columns of X is incorrect.");
+	}
+
+	const BasicMatrixView<T> labels(y.data(), numOfRows, 1);
+	std::vector<size_t> rows(std::min(m_batchSize, numOfRows));
+
+	for (size_t b = 0; b < numOfRows; b += m_batchSize)
+	{
+		const size_t count = std::min(m_batchSize, numOfRows - b);
+		std::iota(rows.begin(), rows.begin() + count, b);
+		step(X, labels, rows.data(), count);
+	}
+
+	++m_numOfIterations;
+}
+
+template <typename T>
+void BasicLogisticRegression<T>::reset(size_t numOfCols)
+{
+	m_weights.assign(numOfCols + 1, T(0));
+	m_gradient.assign(numOfCols + 1, T(0));
+	m_moment1.assign(numOfCols + 1, T(0));
+	m_moment2.assign(numOfCols + 1, T(0));
+	m_steps = 0;
+	m_numOfIterations = 0;
+	m_loss = std::numeric_limits<T>::quiet_NaN();
+}
+
+template <typename T>
+void BasicLogisticRegression<T>::step(const BasicMatrixView<T>& X, const BasicMatrixView<T>& y, const size_t* rows, size_t count)
+{
+	const size_t numOfCols = X.getNumOfCols();
+	std::fill(m_gradient.begin(), m_gradient.end(), T(0));
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		accumulateGradient(X.row(rows[i]).data(), numOfCols, m_weights.data(), y.row(rows[i])[0], m_gradient.data());
+	}
+
+	const T scale = T(1) / T(count);
+
+	if (m_solver != LogisticSolver::Adam)
+	{
+		for (size_t j = 0; j <= numOfCols; ++j) { m_weights[j] -= m_learningRate * scale * m_gradient[j]; }
+		return;
+	}
+
+	// Bias-corrected step size of Adam
+	++m_steps;
+	const T beta1 = T(AdamBeta1), beta2 = T(AdamBeta2);
+	const T correction1 = T(1) - std::pow(beta1, T(m_steps)), correction2 = T(1) - std::pow(beta2, T(m_steps));
+	const T rate = m_learningRate * std::sqrt(correction2) / correction1;
+
+	for (size_t j = 0; j <= numOfCols; ++j)
+	{
+		const T g = scale * m_gradient[j];
+		m_moment1[j] = beta1 * m_moment1[j] + (T(1) - beta1) * g;
+		m_moment2[j] = beta2 * m_moment2[j] + (T(1) - beta2) * g * g;
+		m_weights[j] -= rate * m_moment1[j] / (std::sqrt(m_moment2[j]) + T(AdamEpsilon));
+	}
+}
+
+template <typename T>
+void BasicLogisticRegression<T>::fit(const BasicSparseMatrix<T>& X, const std::vector<T>& y)
+{
+	if (X.getNumOfRows() != y.size())
+	{
+		throw std::invalid_argument("Number of observations in X and y must match.");
+	}
+	else if (y.empty())
+	{
+		throw std::invalid_argument("X cannot be empty.");
+	}
+	else if (m_solver == LogisticSolver::SGD || m_solver == LogisticSolver::Adam)
+	{
+		throw std::invalid_argument("The mini-batch solvers have no sparse implementation.");
+	}
+	else if (m_solver == LogisticSolver::LBFGS || m_solver == LogisticSolver::IRLS)
+	{
+		throw std::invalid_argument("The second-order solvers have no sparse implementation.");
+	}
+
+	size_t numOfRows = X.getNumOfRows(), numOfCols = X.getNumOfCols();
+	reset(numOfCols);
+
+	if (m_solver == LogisticSolver::Hogwild)
+	{
+		const T rate = m_learningRate;
+		runHogwild(m_weights, numOfRows, m_iterations, m_seed, m_averageWeights, [&X, &y, rate](T* weights, size_t i)
+		{
+			const auto columns = X.rowIndices(i);
+			const auto values = X.rowValues(i);
+
+			T z = relaxedLoad(weights[0]);
+			for (size_t k = 0; k < columns.size(); ++k) { z += values[k] * relaxedLoad(weights[columns[k] + 1]); }
+
+			const T step = rate * (T(1) / (T(1) + std::exp(-z)) - y[i]);
+
+			relaxedStore(weights[0], relaxedLoad(weights[0]) - step);
+			for (size_t k = 0; k < columns.size(); ++k)
+			{
+				T& weight = weights[columns[k] + 1];
+				relaxedStore(weight, relaxedLoad(weight) - step * values[k]);
+			}
+		});
+
+		m_numOfIterations = m_iterations;
+		return;
+	}
+
+	// m_weights[0] is the intercept. X^T is formed once, so the gradient is a
+	// row-parallel product however wide X is.
+	const BasicSparseMatrix<T> columns = X.transpose();
+	std::vector<T> errors(numOfRows), gradients(numOfCols + 1);
+
 	for (size_t k = 0; k < m_iterations; ++k)
 	{
-		const std::vector<double> predictions = sigmoid(*(m_data) * m_weights);
-		const std::vector<double> errors = (predictions - y);
-		const std::vector<double> gradients = ((*m_data).transpose() * errors) / numOfRows;
-		m_weights = m_weights - (m_learningRate * gradients);
+		X.multiply(Transpose::No, T(1), m_weights.data() + 1, T(0), errors.data());
+
+		T errorSum = T(0);
+		for (size_t i = 0; i < numOfRows; ++i)
+		{
+			errors[i] = sigmoid(errors[i] + m_weights[0]) - y[i];
+			errorSum += errors[i];
+		}
+
+		gradients[0] = errorSum;
+		columns.multiply(Transpose::No, T(1), errors.data(), T(0), gradients.data() + 1);
+
+		// Fused into a single in-place pass over the weights
+		m_weights -= m_learningRate * (gradients / numOfRows);
 	}
+
+	X.multiply(Transpose::No, T(1), m_weights.data() + 1, T(0), errors.data());
+
+	T loss = T(0);
+	for (size_t i = 0; i < numOfRows; ++i) { loss += logisticLoss(errors[i] + m_weights[0], y[i]); }
+
+	m_numOfIterations = m_iterations;
+	m_loss = loss / T(numOfRows);
 }
 
-int LogisticRegression::predict(const std::vector<double>& x) const
+template <typename T>
+int BasicLogisticRegression<T>::predict(const std::vector<T>& x) const
 {
 	if (x.size() != m_weights.size() - 1)
 	{
@@ -46,26 +829,67 @@ int LogisticRegression::predict(const std::vector<double>& x) const
 	}
 
 	// Initialise with bias value
-	double result = m_weights[0];
+	T result = m_weights[0];
 
 	for (size_t i = 0; i < x.size(); ++i)
 	{
 		result += (x[i] * m_weights[i+1]);
 	}
 	
-	double prob = sigmoid(result);
-	return prob > 0.5 ? 1 : 0;
+	T prob = sigmoid(result);
+	return prob > T(0.5) ? 1 : 0;
+}
+
+template <typename T>
+std::vector<int> BasicLogisticRegression<T>::predict(const BasicSparseMatrix<T>& X) const
+{
+	if (m_weights.empty() || X.getNumOfCols() != m_weights.size() - 1)
+	{
+		throw std::invalid_argument("Number of columns of X is incorrect.");
+	}
+
+	std::vector<T> z(X.getNumOfRows());
+	X.multiply(Transpose::No, T(1), m_weights.data() + 1, T(0), z.data());
+
+	std::vector<int> result(z.size());
+
+	for (size_t i = 0; i < z.size(); ++i)
+	{
+		result[i] = sigmoid(z[i] + m_weights[0]) > T(0.5) ? 1 : 0;
+	}
+
+	return result;
 }
 
-double LogisticRegression::sigmoid(double z) const
+template <typename T>
+void BasicLogisticRegression<T>::predictBatch(const BasicMatrixView<T>& X, std::span<T> out) const
+{
+	if (m_weights.empty() || X.getNumOfCols() != m_weights.size() - 1)
+	{
+		throw std::invalid_argument("Number of columns of X is incorrect.");
+	}
+	else if (out.size() != X.getNumOfRows())
+	{
+		throw std::invalid_argument("Output size must match the number of rows of X.");
+	}
+
+	// Margins in place, then their probabilities
+	std::fill(out.begin(), out.end(), m_weights[0]);
+	gemv<T>(Transpose::No, X.getNumOfRows(), X.getNumOfCols(), T(1), X.data(), X.getStride(), m_weights.data() + 1, T(1), out.data());
+	vectorSigmoid(out.data(), out.data(), out.size());
+}
+
+template <typename T>
+T BasicLogisticRegression<T>::sigmoid(T z) const
 {
 	// Return the sigmoid value of z
-	return 1.0/(1.0 + std::exp(-z));
+	return T(1)/(T(1) + std::exp(-z));
 }
 
-std::vector<double> LogisticRegression::sigmoid(std::vector<double> z) const
+template <typename T>
+std::vector<T> BasicLogisticRegression<T>::sigmoid(std::vector<T> z) const
 {
-	std::vector<double> result(z.size(), 0.0);
+	std::vector<T> result(z.size(), T(0));
 
 	for (size_t i = 0; i < z.size(); ++i)
 	{
@@ -74,3 +898,6 @@ std::vector<double> LogisticRegression::sigmoid(std::vector<double> z) const
 
 	return result;
 }
+
+template class BasicLogisticRegression<float>;
+template class BasicLogisticRegression<double>;
@@ -1,64 +1,133 @@
 #include "matrix.h"
+#include "factorization.h"
+#include "gemm.h"
+#include <algorithm>
 
-std::vector<double> Matrix::operator*(const std::vector<double>& vec) const
+template <typename T>
+BasicMatrix<T>::BasicMatrix(const std::vector<std::vector<T>>& data)
+    :m_numRows(data.size()), m_numCols(data.empty() ? 0 : data[0].size()), m_data(m_numRows * m_numCols)
 {
-    if (vec.size() != m_numCols)
+    T* dst = m_data.data();
+
+    for (const auto& row : data)
     {
-        throw std::invalid_argument("Dimensions for Matrix-vector multiplication do not match.");
-    }
+        if (row.size() != m_numCols)
+        {
+            throw std::invalid_argument("All rows must have the same number of columns.");
+        }
 
-    std::vector<double> result(m_numRows, 0.0);
+        dst = std::copy(row.begin(), row.end(), dst);
+    }
+}
 
+template <typename T>
+BasicMatrix<T>::BasicMatrix(const BasicMatrixView<T>& view)
+    :m_numRows(view.getNumOfRows()), m_numCols(view.getNumOfCols()), m_data(m_numRows * m_numCols)
+{
     for (size_t i = 0; i < m_numRows; ++i)
     {
-        for (size_t j = 0; j < m_numCols; ++j)
-        {
-            result[i] += m_data[i][j] * vec[j];
-        }
+        const auto src = view.row(i);
+        std::copy(src.begin(), src.end(), m_data.begin() + i * m_numCols);
     }
+}
+
+template <typename T>
+std::vector<T> BasicMatrix<T>::operator*(const std::vector<T>& vec) const
+{
+    if (vec.size() != m_numCols)
+    {
+        throw std::invalid_argument("Dimensions for Matrix-vector multiplication do not match.");
+    }
+
+    std::vector<T> result(m_numRows);
+
+    gemv<T>(Transpose::No, m_numRows, m_numCols, T(1), m_data.data(), m_numCols, vec.data(), T(0), result.data());
 
     return result;
 }
 
-Matrix Matrix::operator*(const Matrix& other) const
+template <typename T>
+BasicMatrix<T> BasicMatrix<T>::operator*(const BasicMatrix& other) const
 {
     if (m_numCols != other.m_numRows)
     {
         throw std::invalid_argument("Dimensions for Matrix-matrix multiplication do not match.");
     }
 
-    Matrix result(m_numRows, other.m_numCols);
+    BasicMatrix result(m_numRows, other.m_numCols);
 
-    for (size_t i = 0; i < m_numRows; ++i)
+    gemm<T>(Transpose::No, Transpose::No, m_numRows, other.m_numCols, m_numCols,
+        T(1), m_data.data(), m_numCols, other.m_data.data(), other.m_numCols,
+        T(0), result.m_data.data(), result.m_numCols);
+
+    return result;
+}
+
+template <typename T>
+std::vector<T> BasicMatrix<T>::transposeTimes(const std::vector<T>& vec) const
+{
+    if (vec.size() != m_numRows)
+    {
+        throw std::invalid_argument("Dimensions for transposed Matrix-vector multiplication do not match.");
+    }
+
+    std::vector<T> result(m_numCols);
+
+    gemv<T>(Transpose::Yes, m_numRows, m_numCols, T(1), m_data.data(), m_numCols, vec.data(), T(0), result.data());
+
+    return result;
+}
+
+template <typename T>
+BasicMatrix<T> BasicMatrix<T>::gram() const
+{
+    BasicMatrix result(m_numCols, m_numCols);
+
+    // Compute the upper triangle, then mirror it into the lower one
+    syrk<T>(m_numCols, m_numRows, T(1), m_data.data(), m_numCols, T(0), result.m_data.data(), m_numCols);
+
+    for (size_t i = 0; i < m_numCols; ++i)
     {
-        for (size_t j = 0; j < other.m_numCols; ++j)
+        for (size_t j = 0; j < i; ++j)
         {
-            for (size_t k = 0; k < m_numCols; ++k)
-            {
-                result.m_data[i][j] += m_data[i][k] * other.m_data[k][j];
-            }
+            result.m_data[i * m_numCols + j] = result.m_data[j * m_numCols + i];
         }
     }
 
     return result;
 }
 
-Matrix Matrix::transpose() const
+template <typename T>
+BasicMatrix<T> BasicMatrix<T>::transpose() const
 {
-    Matrix result(m_numCols, m_numRows);
+    BasicMatrix result(m_numCols, m_numRows);
 
-    for (size_t i = 0; i < m_numRows; ++i)
+    // Transpose in square tiles so that both the reads and the writes stay within cache
+    constexpr size_t tile = 32;
+
+    for (size_t ii = 0; ii < m_numRows; ii += tile)
     {
-        for (size_t j = 0; j < m_numCols; ++j)
+        const size_t iEnd = std::min(ii + tile, m_numRows);
+
+        for (size_t jj = 0; jj < m_numCols; jj += tile)
         {
-            result.m_data[j][i] = m_data[i][j];
+            const size_t jEnd = std::min(jj + tile, m_numCols);
+
+            for (size_t i = ii; i < iEnd; ++i)
+            {
+                for (size_t j = jj; j < jEnd; ++j)
+                {
+                    result.m_data[j * m_numRows + i] = m_data[i * m_numCols + j];
+                }
+            }
         }
     }
 
     return result;
 }
 
-Matrix Matrix::inverse() const
+template <typename T>
+BasicMatrix<T> BasicMatrix<T>::inverse() const
 {
     if (m_data.size() == 0)
     {
@@ -69,68 +138,23 @@ Matrix Matrix::inverse() const
         throw std::invalid_argument("Inverse is only defined for square matrix.");
     }
 
-    // Initialise augmented matrix, matrix with data on left and identity matrix on right
-    Matrix aug(m_numRows, 2 * m_numRows);
-    
-    for (size_t i = 0; i < m_numRows; ++i)
-    {
-        // Loop over the first part to get the data
-        for (size_t j = 0; j < m_numCols; ++j)
-        {
-            aug.m_data[i][j] = m_data[i][j];
-        }
-
-        // Loop over the second part to get the identity matrix
-        for (size_t j = m_numRows; j < 2 * m_numRows; ++j)
-        {
-            // Check for diagonal element
-            if ((j - m_numRows) == i)
-            {
-                aug.m_data[i][j] = 1.0;
-            }
-        }
-    }
+    // Factorize with partial pivoting, then solve against the identity
+    const BasicLUFactorization<T> lu(*this);
 
-    // Get the inverse of matrix using Gaussian Jordan elimination
-    for (size_t i = 0; i < m_numRows; ++i)
+    if (lu.isSingular())
     {
-        double pivot = aug.m_data[i][i];
-
-        if (pivot == 0.0)
-        {
-            throw std::invalid_argument("Inverse is not defined for singular matrix.");
-        }
-
-        for (size_t j = 0; j < 2 * m_numRows; ++j)
-        {
-            aug.m_data[i][j] /= pivot;
-        }
-
-        for (size_t k = 0; k < m_numRows; ++k)
-        {
-            // Check if row is same as pivot row
-            if (k == i)
-            {
-                continue;
-            }
-            double factor = aug.m_data[k][i];
-
-            for (size_t j = 0; j < 2 * m_numRows; ++j)
-            {
-                aug.m_data[k][j] -= factor * aug.m_data[i][j];
-            }
-        }
+        throw std::invalid_argument("Inverse is not defined for singular matrix.");
     }
 
-    Matrix inverse(m_numRows, m_numRows);
+    BasicMatrix identity(m_numRows, m_numRows);
 
     for (size_t i = 0; i < m_numRows; ++i)
     {
-        for (size_t j = 0; j < m_numRows; ++j)
-        {
-            inverse.m_data[i][j] = aug.m_data[i][j + m_numRows];
-        }
+        identity.m_data[i * m_numRows + i] = T(1);
     }
 
-    return inverse;
+    return lu.solve(identity);
 }
+
+template class BasicMatrix<float>;
+template class BasicMatrix<double>;
@@ -0,0 +1,185 @@
+#include "softmax_regression.h"
+#include "gemm.h"
+#include "vector_math.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace
+{
+	// Number of rows whose scores are computed by one GEMM, so the block of X
+	// is still in cache when the gradient GEMM reads it again
+	constexpr size_t SoftmaxBlockRows = 1024;
+}
+
+template <typename T>
+BasicSoftmaxRegression<T>::BasicSoftmaxRegression(T learningRate, size_t iterations)
+	:m_weights(0, 0), m_learningRate(learningRate), m_iterations(iterations), m_loss(std::numeric_limits<T>::quiet_NaN())
+{
+}
+
+template <typename T>
+void BasicSoftmaxRegression<T>::fit(const BasicMatrixView<T>& X, const std::vector<size_t>& y)
+{
+	if (X.getNumOfRows() != y.size())
+	{
+		throw std::invalid_argument("Number of observations in X and y must match.");
+	}
+	else if (y.empty())
+	{
+		throw std::invalid_argument("X cannot be empty.");
+	}
+
+	const size_t numOfRows = X.getNumOfRows(), numOfCols = X.getNumOfCols();
+	const size_t numOfClasses = *std::max_element(y.begin(), y.end()) + 1;
+
+	if (numOfClasses < 2)
+	{
+		throw std::invalid_argument("There must be at least two classes.");
+	}
+
+	m_weights = BasicMatrix<T>(numOfCols, numOfClasses);
+	m_intercepts.assign(numOfClasses, T(0));
+
+	// Buffers are allocated once, the iterations do not allocate
+	std::vector<T> errors(std::min(SoftmaxBlockRows, numOfRows) * numOfClasses), interceptGradient(numOfClasses);
+	BasicMatrix<T> gradient(numOfCols, numOfClasses);
+	const T step = m_learningRate / T(numOfRows);
+
+	for (size_t k = 0; k < m_iterations; ++k)
+	{
+		std::fill(interceptGradient.begin(), interceptGradient.end(), T(0));
+
+		for (size_t first = 0; first < numOfRows; first += SoftmaxBlockRows)
+		{
+			const size_t count = std::min(SoftmaxBlockRows, numOfRows - first);
+			const BasicMatrixView<T> block = X.rows(first, count);
+
+			// Gradient of the cross-entropy with respect to the scores, P - Y
+			probabilities(block, errors.data(), nullptr);
+
+			for (size_t i = 0; i < count; ++i)
+			{
+				T* error = errors.data() + i * numOfClasses;
+				error[y[first + i]] -= T(1);
+				for (size_t c = 0; c < numOfClasses; ++c) { interceptGradient[c] += error[c]; }
+			}
+
+			// Blocks add into the gradient in order, so it does not depend on the number of threads
+			gemm<T>(Transpose::Yes, Transpose::No, numOfCols, numOfClasses, count, T(1), block.data(), block.getStride(),
+				errors.data(), numOfClasses, first == 0 ? T(0) : T(1), gradient.data(), numOfClasses);
+		}
+
+		T* weights = m_weights.data();
+		const T* g = gradient.data();
+		for (size_t j = 0; j < numOfCols * numOfClasses; ++j) { weights[j] -= step * g[j]; }
+		for (size_t c = 0; c < numOfClasses; ++c) { m_intercepts[c] -= step * interceptGradient[c]; }
+	}
+
+	T loss = T(0);
+	for (size_t first = 0; first < numOfRows; first += SoftmaxBlockRows)
+	{
+		const size_t count = std::min(SoftmaxBlockRows, numOfRows - first);
+		loss += probabilities(X.rows(first, count), errors.data(), y.data() + first);
+	}
+
+	m_loss = loss / T(numOfRows);
+}
+
+template <typename T>
+T BasicSoftmaxRegression<T>::probabilities(const BasicMatrixView<T>& X, T* result, const size_t* labels) const
+{
+	const size_t numOfRows = X.getNumOfRows(), numOfClasses = m_intercepts.size();
+
+	// Scores X W + b, one GEMM for all classes
+	for (size_t i = 0; i < numOfRows; ++i)
+	{
+		std::copy(m_intercepts.begin(), m_intercepts.end(), result + i * numOfClasses);
+	}
+
+	gemm<T>(Transpose::No, Transpose::No, numOfRows, numOfClasses, X.getNumOfCols(), T(1), X.data(), X.getStride(),
+		m_weights.data(), numOfClasses, T(1), result, numOfClasses);
+
+	// Stable log-sum-exp: scores are shifted by their row maximum so the
+	// exponentials lie in (0, 1], and the cross-entropy of a row is
+	// log(sum of exponentials) minus the shifted score of its class
+	T loss = T(0);
+
+	for (size_t i = 0; i < numOfRows; ++i)
+	{
+		T* row = result + i * numOfClasses;
+		const T largest = *std::max_element(row, row + numOfClasses);
+		for (size_t c = 0; c < numOfClasses; ++c) { row[c] -= largest; }
+
+		if (labels != nullptr)
+		{
+			loss -= row[labels[i]];
+		}
+	}
+
+	vectorExp(result, result, numOfRows * numOfClasses);
+
+	for (size_t i = 0; i < numOfRows; ++i)
+	{
+		T* row = result + i * numOfClasses;
+
+		T sum = T(0);
+		for (size_t c = 0; c < numOfClasses; ++c) { sum += row[c]; }
+
+		const T inverse = T(1) / sum;
+		for (size_t c = 0; c < numOfClasses; ++c) { row[c] *= inverse; }
+
+		if (labels != nullptr)
+		{
+			loss += std::log(sum);
+		}
+	}
+
+	return loss;
+}
+
+template <typename T>
+size_t BasicSoftmaxRegression<T>::predict(const std::vector<T>& x) const
+{
+	return predict(BasicMatrixView<T>(x.data(), 1, x.size()))[0];
+}
+
+template <typename T>
+std::vector<size_t> BasicSoftmaxRegression<T>::predict(const BasicMatrixView<T>& X) const
+{
+	const BasicMatrix<T> proba = predictProba(X);
+
+	std::vector<size_t> result(X.getNumOfRows());
+	for (size_t i = 0; i < result.size(); ++i)
+	{
+		// Largest probability, the first class on ties
+		const auto row = proba.row(i);
+		result[i] = std::max_element(row.begin(), row.end()) - row.begin();
+	}
+
+	return result;
+}
+
+template <typename T>
+BasicMatrix<T> BasicSoftmaxRegression<T>::predictProba(const BasicMatrixView<T>& X) const
+{
+	if (m_intercepts.empty() || X.getNumOfCols() != m_weights.getNumOfRows())
+	{
+		throw std::invalid_argument("Number of columns of X is incorrect.");
+	}
+
+	const size_t numOfRows = X.getNumOfRows();
+	BasicMatrix<T> result(numOfRows, m_intercepts.size());
+
+	for (size_t first = 0; first < numOfRows; first += SoftmaxBlockRows)
+	{
+		const size_t count = std::min(SoftmaxBlockRows, numOfRows - first);
+		probabilities(X.rows(first, count), result.data() + first * m_intercepts.size(), nullptr);
+	}
+
+	return result;
+}
+
+template class BasicSoftmaxRegression<float>;
+template class BasicSoftmaxRegression<double>;
@@ -0,0 +1,249 @@
+#include "sparse_matrix.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+namespace
+{
+	// Number of non-zeros per parallel block of a sparse matrix-vector product
+	constexpr size_t SpmvBlockSize = 1 << 16;
+
+	// Upper bound on the row blocks reduced by the transposed product
+	constexpr size_t MaxReductionBlocks = 64;
+
+	// Upper bound on the elements of the partial results of the transposed product
+	constexpr size_t MaxPartialElements = 1 << 20;
+}
+
+template <typename T>
+BasicSparseMatrix<T>::BasicSparseMatrix(size_t numRows, size_t numCols, std::vector<size_t> rowPointers,
+	std::vector<size_t> columnIndices, std::vector<T> values)
+	:m_numRows(numRows), m_numCols(numCols), m_rowPointers(std::move(rowPointers)),
+	m_columnIndices(std::move(columnIndices)), m_values(std::move(values))
+{
+	if (m_rowPointers.size() != m_numRows + 1 || m_rowPointers.front() != 0)
+	{
+		throw std::invalid_argument("Row pointers must have one element per row plus one, starting at zero.");
+	}
+	else if (m_columnIndices.size() != m_values.size() || m_rowPointers.back() != m_values.size())
+	{
+		throw std::invalid_argument("Number of column indices, values and non-zeros must match.");
+	}
+
+	for (size_t i = 0; i < m_numRows; ++i)
+	{
+		if (m_rowPointers[i] > m_rowPointers[i + 1])
+		{
+			throw std::invalid_argument("Row pointers must not decrease.");
+		}
+	}
+
+	for (size_t j : m_columnIndices)
+	{
+		if (j >= m_numCols)
+		{
+			throw std::invalid_argument("Column index out of range.");
+		}
+	}
+}
+
+template <typename T>
+BasicSparseMatrix<T>::BasicSparseMatrix(const BasicMatrixView<T>& dense)
+	:m_numRows(dense.getNumOfRows()), m_numCols(dense.getNumOfCols()), m_rowPointers(m_numRows + 1, 0)
+{
+	// Count the non-zeros first so the arrays are allocated once
+	for (size_t i = 0; i < m_numRows; ++i)
+	{
+		const auto row = dense.row(i);
+		m_rowPointers[i + 1] = m_rowPointers[i] + (m_numCols - std::count(row.begin(), row.end(), T(0)));
+	}
+
+	m_columnIndices.reserve(m_rowPointers.back());
+	m_values.reserve(m_rowPointers.back());
+
+	for (size_t i = 0; i < m_numRows; ++i)
+	{
+		const auto row = dense.row(i);
+
+		for (size_t j = 0; j < m_numCols; ++j)
+		{
+			if (row[j] != T(0))
+			{
+				m_columnIndices.push_back(j);
+				m_values.push_back(row[j]);
+			}
+		}
+	}
+}
+
+template <typename T>
+void BasicSparseMatrix<T>::multiply(Transpose trans, T alpha, const T* x, T beta, T* y) const
+{
+	const size_t* rowPointers = m_rowPointers.data();
+	const size_t* columnIndices = m_columnIndices.data();
+	const T* values = m_values.data();
+
+	// Rows per parallel block, fixed by shape so results do not depend on the thread count
+	const size_t averageRowSize = std::max<size_t>(1, m_values.size() / std::max<size_t>(1, m_numRows));
+	const size_t grain = std::max<size_t>(1, SpmvBlockSize / averageRowSize);
+
+	if (trans == Transpose::No)
+	{
+		// y = alpha * A x + beta * y, independent sparse dot products per row
+		parallelFor(0, m_numRows, grain, [&](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; ++i)
+			{
+				T sum = T(0);
+
+				for (size_t p = rowPointers[i]; p < rowPointers[i + 1]; ++p) { sum += values[p] * x[columnIndices[p]]; }
+
+				y[i] = alpha * sum + (beta == T(0) ? T(0) : beta * y[i]);
+			}
+		});
+		return;
+	}
+
+	// y = alpha * A^T x + beta * y, scattered row by row. Each block of rows sums
+	// into its own partial vector and the partials are added in block order.
+	const size_t n = m_numCols;
+	const size_t maxBlocks = std::clamp<size_t>(MaxPartialElements / std::max<size_t>(1, n), 1, MaxReductionBlocks);
+	const size_t blockRows = std::max(grain, (m_numRows + maxBlocks - 1) / maxBlocks);
+	const size_t numBlocks = std::max<size_t>(1, (m_numRows + blockRows - 1) / blockRows);
+
+	// Reused across calls on the same thread, so repeated products do not allocate
+	thread_local std::vector<T> partials;
+	if (partials.size() < numBlocks * n)
+	{
+		partials.resize(numBlocks * n);
+	}
+	T* const partial = partials.data();
+	std::fill(partial, partial + numBlocks * n, T(0));
+
+	parallelFor(0, numBlocks, 1, [&](size_t b0, size_t b1)
+	{
+		for (size_t block = b0; block < b1; ++block)
+		{
+			T* acc = partial + block * n;
+			const size_t end = std::min(m_numRows, (block + 1) * blockRows);
+
+			for (size_t i = block * blockRows; i < end; ++i)
+			{
+				const T xi = x[i];
+
+				for (size_t p = rowPointers[i]; p < rowPointers[i + 1]; ++p) { acc[columnIndices[p]] += values[p] * xi; }
+			}
+		}
+	});
+
+	for (size_t j = 0; j < n; ++j)
+	{
+		T sum = T(0);
+		for (size_t block = 0; block < numBlocks; ++block) { sum += partial[block * n + j]; }
+
+		y[j] = alpha * sum + (beta == T(0) ? T(0) : beta * y[j]);
+	}
+}
+
+template <typename T>
+std::vector<T> BasicSparseMatrix<T>::operator*(const std::vector<T>& vec) const
+{
+	if (vec.size() != m_numCols)
+	{
+		throw std::invalid_argument("Dimensions for Matrix-vector multiplication do not match.");
+	}
+
+	std::vector<T> result(m_numRows);
+
+	multiply(Transpose::No, T(1), vec.data(), T(0), result.data());
+
+	return result;
+}
+
+template <typename T>
+std::vector<T> BasicSparseMatrix<T>::transposeTimes(const std::vector<T>& vec) const
+{
+	if (vec.size() != m_numRows)
+	{
+		throw std::invalid_argument("Dimensions for transposed Matrix-vector multiplication do not match.");
+	}
+
+	std::vector<T> result(m_numCols);
+
+	multiply(Transpose::Yes, T(1), vec.data(), T(0), result.data());
+
+	return result;
+}
+
+template <typename T>
+BasicMatrix<T> BasicSparseMatrix<T>::gram() const
+{
+	// Column i of A is row i of the transpose, so row i of A^T A only needs the
+	// rows of A that have a non-zero in column i. Each row of the result is
+	// computed by a single task, in a fixed order.
+	const BasicSparseMatrix columns = transpose();
+	BasicMatrix<T> result(m_numCols, m_numCols);
+
+	parallelFor(0, m_numCols, 16, [&](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; ++i)
+		{
+			const auto out = result.row(i);
+			const auto columnRows = columns.rowIndices(i);
+			const auto columnValues = columns.rowValues(i);
+
+			for (size_t p = 0; p < columnRows.size(); ++p)
+			{
+				const auto indices = rowIndices(columnRows[p]);
+				const auto values = rowValues(columnRows[p]);
+				const T aki = columnValues[p];
+
+				for (size_t q = 0; q < indices.size(); ++q)
+				{
+					// Upper triangle only, mirrored below
+					if (indices[q] >= i) { out[indices[q]] += aki * values[q]; }
+				}
+			}
+		}
+	});
+
+	T* g = result.data();
+	for (size_t i = 0; i < m_numCols; ++i)
+	{
+		for (size_t j = 0; j < i; ++j)
+		{
+			g[i * m_numCols + j] = g[j * m_numCols + i];
+		}
+	}
+
+	return result;
+}
+
+template <typename T>
+BasicSparseMatrix<T> BasicSparseMatrix<T>::transpose() const
+{
+	// Counting sort of the non-zeros by column; rows stay in increasing order
+	std::vector<size_t> rowPointers(m_numCols + 1, 0);
+	for (size_t j : m_columnIndices) { ++rowPointers[j + 1]; }
+	for (size_t j = 0; j < m_numCols; ++j) { rowPointers[j + 1] += rowPointers[j]; }
+
+	std::vector<size_t> columnIndices(m_values.size());
+	std::vector<T> values(m_values.size());
+	std::vector<size_t> next(rowPointers.begin(), rowPointers.end() - 1);
+
+	for (size_t i = 0; i < m_numRows; ++i)
+	{
+		for (size_t p = m_rowPointers[i]; p < m_rowPointers[i + 1]; ++p)
+		{
+			const size_t dst = next[m_columnIndices[p]]++;
+			columnIndices[dst] = i;
+			values[dst] = m_values[p];
+		}
+	}
+
+	return BasicSparseMatrix(m_numCols, m_numRows, std::move(rowPointers), std::move(columnIndices), std::move(values));
+}
+
+template class BasicSparseMatrix<float>;
+template class BasicSparseMatrix<double>;
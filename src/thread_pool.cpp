@@ -0,0 +1,262 @@
+#include "thread_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+
+namespace
+{
+	// Set while a thread is executing pool work, nested parallel loops then run serially
+	thread_local bool t_insidePool = false;
+
+	/// <summary>
+	/// Default thread count, from ML_NUM_THREADS or the hardware
+	/// </summary>
+	size_t defaultNumThreads()
+	{
+		if (const char* env = std::getenv("ML_NUM_THREADS"))
+		{
+			char* end = nullptr;
+			const unsigned long value = std::strtoul(env, &end, 10);
+			if (end != env && value > 0)
+			{
+				return static_cast<size_t>(value);
+			}
+		}
+
+		return std::max<size_t>(1, std::thread::hardware_concurrency());
+	}
+
+	/// <summary>
+	/// Marks the current thread as running pool work for its lifetime
+	/// </summary>
+	struct InsidePoolScope
+	{
+		bool previous;
+		InsidePoolScope() : previous(t_insidePool) { t_insidePool = true; }
+		~InsidePoolScope() { t_insidePool = previous; }
+	};
+}
+
+struct ThreadPool::Job
+{
+	const std::function<void(size_t, size_t)>* body;
+	size_t begin;
+	size_t end;
+	size_t grain;
+	size_t numChunks;
+
+	// Next chunk to hand out
+	std::atomic<size_t> next{ 0 };
+
+	// First exception thrown by the body
+	std::exception_ptr error;
+	std::mutex errorMutex;
+};
+
+ThreadPool& ThreadPool::instance()
+{
+	static ThreadPool pool;
+	return pool;
+}
+
+ThreadPool::ThreadPool()
+	:m_numThreads(1), m_job(nullptr), m_generation(0), m_active(0), m_stop(false)
+{
+	startWorkers(defaultNumThreads() - 1);
+}
+
+ThreadPool::~ThreadPool()
+{
+	stopWorkers();
+}
+
+size_t ThreadPool::getNumThreads() const
+{
+	return m_numThreads.load(std::memory_order_relaxed);
+}
+
+void ThreadPool::setNumThreads(size_t numThreads)
+{
+	if (numThreads == 0)
+	{
+		numThreads = std::max<size_t>(1, std::thread::hardware_concurrency());
+	}
+
+	// Wait for any running job before replacing the workers
+	std::lock_guard<std::mutex> jobLock(m_jobMutex);
+
+	if (numThreads - 1 == m_workers.size())
+	{
+		return;
+	}
+
+	stopWorkers();
+	startWorkers(numThreads - 1);
+}
+
+void ThreadPool::parallelFor(size_t begin, size_t end, size_t grain, const std::function<void(size_t, size_t)>& body)
+{
+	if (begin >= end)
+	{
+		return;
+	}
+
+	grain = std::max<size_t>(1, grain);
+	const size_t numChunks = (end - begin + grain - 1) / grain;
+
+	// Run serially when there is nothing to share, when called from pool work,
+	// or when another caller already owns the pool. The workers are only
+	// looked at with the job lock held, as setNumThreads replaces them under it.
+	std::unique_lock<std::mutex> jobLock(m_jobMutex, std::defer_lock);
+	if (numChunks == 1 || t_insidePool || !jobLock.try_lock() || m_workers.empty())
+	{
+		InsidePoolScope scope;
+		for (size_t b = begin; b < end; b += grain)
+		{
+			body(b, std::min(end, b + grain));
+		}
+		return;
+	}
+
+	Job job;
+	job.body = &body;
+	job.begin = begin;
+	job.end = end;
+	job.grain = grain;
+	job.numChunks = numChunks;
+
+	// Publish the job to the workers
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_job = &job;
+		++m_generation;
+	}
+	m_workAvailable.notify_all();
+
+	// The caller works on the job as well
+	{
+		InsidePoolScope scope;
+		runChunks(job);
+	}
+
+	// Wait until no worker references the job any more
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_job = nullptr;
+		m_workDone.wait(lock, [this] { return m_active == 0; });
+	}
+
+	if (job.error)
+	{
+		std::rethrow_exception(job.error);
+	}
+}
+
+void ThreadPool::startWorkers(size_t numWorkers)
+{
+	m_stop = false;
+	m_workers.reserve(numWorkers);
+
+	for (size_t i = 0; i < numWorkers; ++i)
+	{
+		m_workers.emplace_back([this] { workerLoop(); });
+	}
+
+	m_numThreads.store(numWorkers + 1, std::memory_order_relaxed);
+}
+
+void ThreadPool::stopWorkers()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stop = true;
+	}
+	m_workAvailable.notify_all();
+
+	for (auto& worker : m_workers)
+	{
+		worker.join();
+	}
+	m_workers.clear();
+}
+
+void ThreadPool::workerLoop()
+{
+	t_insidePool = true;
+	size_t seenGeneration = 0;
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	seenGeneration = m_generation;
+
+	while (true)
+	{
+		m_workAvailable.wait(lock, [&] { return m_stop || m_generation != seenGeneration; });
+
+		if (m_stop)
+		{
+			return;
+		}
+
+		seenGeneration = m_generation;
+
+		// The job may already be finished by the time this worker wakes up
+		Job* job = m_job;
+		if (job == nullptr)
+		{
+			continue;
+		}
+
+		++m_active;
+		lock.unlock();
+
+		runChunks(*job);
+
+		lock.lock();
+		if (--m_active == 0)
+		{
+			m_workDone.notify_all();
+		}
+	}
+}
+
+void ThreadPool::runChunks(Job& job)
+{
+	while (true)
+	{
+		const size_t chunk = job.next.fetch_add(1, std::memory_order_relaxed);
+		if (chunk >= job.numChunks)
+		{
+			return;
+		}
+
+		const size_t b = job.begin + chunk * job.grain;
+
+		try
+		{
+			(*job.body)(b, std::min(job.end, b + job.grain));
+		}
+		catch (...)
+		{
+			std::lock_guard<std::mutex> lock(job.errorMutex);
+			if (!job.error)
+			{
+				job.error = std::current_exception();
+			}
+		}
+	}
+}
+
+void setNumThreads(size_t numThreads)
+{
+	ThreadPool::instance().setNumThreads(numThreads);
+}
+
+size_t getNumThreads()
+{
+	return ThreadPool::instance().getNumThreads();
+}
+
+void parallelFor(size_t begin, size_t end, size_t grain, const std::function<void(size_t, size_t)>& body)
+{
+	ThreadPool::instance().parallelFor(begin, end, grain, body);
+}
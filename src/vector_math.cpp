@@ -0,0 +1,345 @@
+#include "vector_math.h"
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define ML_VECTOR_MATH_X86 1
+#include <immintrin.h>
+#endif
+
+namespace
+{
+	/// <summary>
+	/// Element-wise functions with vectorized kernels
+	/// </summary>
+	enum class Function
+	{
+		Exp,
+		Sigmoid
+	};
+
+	template <typename T>
+	using Kernel = void(*)(const T*, T*, size_t);
+
+	/// <summary>
+	/// Portable element-wise function
+	/// </summary>
+	template <Function F, typename T>
+	void applyScalar(const T* x, T* y, size_t n)
+	{
+		for (size_t i = 0; i < n; ++i)
+		{
+			y[i] = F == Function::Exp ? std::exp(x[i]) : T(1) / (T(1) + std::exp(-x[i]));
+		}
+	}
+
+#ifdef ML_VECTOR_MATH_X86
+	// exp(x) = 2^n exp(r) with n = round(x / ln 2) and r = x - n ln 2, where
+	// ln 2 is split in a high part exact in a few bits and a low part, so
+	// that r is exact. exp(r) is a Taylor polynomial on |r| <= ln 2 / 2.
+	constexpr double Log2E = 1.4426950408889634074;
+	constexpr double Ln2HighD = 0.693147180369123816490;
+	constexpr double Ln2LowD = 1.90821492927058770002e-10;
+	constexpr float Ln2HighF = 0.693359375f;
+	constexpr float Ln2LowF = -2.12194440e-4f;
+
+	// Inputs are clamped where the result is already zero or infinite
+	constexpr double MinExpD = -746.0, MaxExpD = 710.0;
+	constexpr float MinExpF = -104.0f, MaxExpF = 89.0f;
+
+	// Taylor coefficients 1/k!, highest degree first
+	constexpr double CoefficientsD[] = { 1.0 / 479001600, 1.0 / 39916800, 1.0 / 3628800, 1.0 / 362880, 1.0 / 40320,
+		1.0 / 5040, 1.0 / 720, 1.0 / 120, 1.0 / 24, 1.0 / 6, 1.0 / 2, 1.0, 1.0 };
+	constexpr float CoefficientsF[] = { 1.0f / 5040, 1.0f / 720, 1.0f / 120, 1.0f / 24, 1.0f / 6, 1.0f / 2, 1.0f, 1.0f };
+
+	/// <summary>
+	/// AVX2/FMA exponential of four doubles. 2^n is applied as two factors
+	/// 2^(n/2), so that neither leaves the normal range near the limits.
+	/// </summary>
+	__attribute__((target("avx2,fma")))
+	inline __m256d expAvx2(__m256d x)
+	{
+		const __m256d clamped = _mm256_min_pd(_mm256_max_pd(x, _mm256_set1_pd(MinExpD)), _mm256_set1_pd(MaxExpD));
+		const __m256d n = _mm256_round_pd(_mm256_mul_pd(clamped, _mm256_set1_pd(Log2E)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+
+		__m256d r = _mm256_fnmadd_pd(n, _mm256_set1_pd(Ln2HighD), clamped);
+		r = _mm256_fnmadd_pd(n, _mm256_set1_pd(Ln2LowD), r);
+
+		__m256d p = _mm256_set1_pd(CoefficientsD[0]);
+		for (size_t k = 1; k < std::size(CoefficientsD); ++k)
+		{
+			p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(CoefficientsD[k]));
+		}
+
+		const __m128i n32 = _mm256_cvtpd_epi32(n);
+		const __m128i half = _mm_srai_epi32(n32, 1);
+		const __m256i bias = _mm256_set1_epi64x(1023);
+		const __m256d scale1 = _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_add_epi64(_mm256_cvtepi32_epi64(half), bias), 52));
+		const __m256d scale2 = _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_add_epi64(_mm256_cvtepi32_epi64(_mm_sub_epi32(n32, half)), bias), 52));
+
+		const __m256d result = _mm256_mul_pd(_mm256_mul_pd(p, scale1), scale2);
+		return _mm256_blendv_pd(result, x, _mm256_cmp_pd(x, x, _CMP_UNORD_Q));
+	}
+
+	/// <summary>
+	/// AVX2/FMA exponential of eight floats
+	/// </summary>
+	__attribute__((target("avx2,fma")))
+	inline __m256 expAvx2(__m256 x)
+	{
+		const __m256 clamped = _mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(MinExpF)), _mm256_set1_ps(MaxExpF));
+		const __m256 n = _mm256_round_ps(_mm256_mul_ps(clamped, _mm256_set1_ps(float(Log2E))), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+
+		__m256 r = _mm256_fnmadd_ps(n, _mm256_set1_ps(Ln2HighF), clamped);
+		r = _mm256_fnmadd_ps(n, _mm256_set1_ps(Ln2LowF), r);
+
+		__m256 p = _mm256_set1_ps(CoefficientsF[0]);
+		for (size_t k = 1; k < std::size(CoefficientsF); ++k)
+		{
+			p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(CoefficientsF[k]));
+		}
+
+		const __m256i n32 = _mm256_cvtps_epi32(n);
+		const __m256i half = _mm256_srai_epi32(n32, 1);
+		const __m256i bias = _mm256_set1_epi32(127);
+		const __m256 scale1 = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(half, bias), 23));
+		const __m256 scale2 = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(_mm256_sub_epi32(n32, half), bias), 23));
+
+		const __m256 result = _mm256_mul_ps(_mm256_mul_ps(p, scale1), scale2);
+		return _mm256_blendv_ps(result, x, _mm256_cmp_ps(x, x, _CMP_UNORD_Q));
+	}
+
+	/// <summary>
+	/// AVX2/FMA logistic sigmoid of four doubles, 1 / (1 + exp(-x)), which
+	/// saturates to 0 and 1 as exp(-x) overflows and underflows
+	/// </summary>
+	__attribute__((target("avx2,fma")))
+	inline __m256d sigmoidAvx2(__m256d x)
+	{
+		const __m256d one = _mm256_set1_pd(1.0);
+		return _mm256_div_pd(one, _mm256_add_pd(one, expAvx2(_mm256_sub_pd(_mm256_setzero_pd(), x))));
+	}
+
+	/// <summary>
+	/// AVX2/FMA logistic sigmoid of eight floats
+	/// </summary>
+	__attribute__((target("avx2,fma")))
+	inline __m256 sigmoidAvx2(__m256 x)
+	{
+		const __m256 one = _mm256_set1_ps(1.0f);
+		return _mm256_div_ps(one, _mm256_add_ps(one, expAvx2(_mm256_sub_ps(_mm256_setzero_ps(), x))));
+	}
+
+	/// <summary>
+	/// AVX2/FMA element-wise function of one vector
+	/// </summary>
+	template <Function F, typename V>
+	__attribute__((target("avx2,fma")))
+	inline V evaluateAvx2(V x)
+	{
+		if constexpr (F == Function::Exp)
+		{
+			return expAvx2(x);
+		}
+		else
+		{
+			return sigmoidAvx2(x);
+		}
+	}
+
+	/// <summary>
+	/// AVX2/FMA element-wise function for double, the tail through a padded vector
+	/// </summary>
+	template <Function F>
+	__attribute__((target("avx2,fma")))
+	void applyAvx2(const double* x, double* y, size_t n)
+	{
+		size_t i = 0;
+		for (; i + 4 <= n; i += 4)
+		{
+			_mm256_storeu_pd(y + i, evaluateAvx2<F>(_mm256_loadu_pd(x + i)));
+		}
+
+		if (i < n)
+		{
+			double tail[4] = {};
+			std::copy(x + i, x + n, tail);
+			_mm256_storeu_pd(tail, evaluateAvx2<F>(_mm256_loadu_pd(tail)));
+			std::copy(tail, tail + (n - i), y + i);
+		}
+	}
+
+	/// <summary>
+	/// AVX2/FMA element-wise function for float
+	/// </summary>
+	template <Function F>
+	__attribute__((target("avx2,fma")))
+	void applyAvx2(const float* x, float* y, size_t n)
+	{
+		size_t i = 0;
+		for (; i + 8 <= n; i += 8)
+		{
+			_mm256_storeu_ps(y + i, evaluateAvx2<F>(_mm256_loadu_ps(x + i)));
+		}
+
+		if (i < n)
+		{
+			float tail[8] = {};
+			std::copy(x + i, x + n, tail);
+			_mm256_storeu_ps(tail, evaluateAvx2<F>(_mm256_loadu_ps(tail)));
+			std::copy(tail, tail + (n - i), y + i);
+		}
+	}
+
+	/// <summary>
+	/// AVX-512 exponential of eight doubles, 2^n applied by scalef, which
+	/// handles overflow and gradual underflow. Full-mask zeroing forms, as the
+	/// unmasked ones of GCC 12 pass an undefined source that -Wall flags.
+	/// </summary>
+	__attribute__((target("avx512f")))
+	inline __m512d expAvx512(__m512d x)
+	{
+		const __m512d clamped = _mm512_maskz_min_pd(0xFF, _mm512_maskz_max_pd(0xFF, x, _mm512_set1_pd(MinExpD)), _mm512_set1_pd(MaxExpD));
+		const __m512d n = _mm512_maskz_roundscale_pd(0xFF, _mm512_mul_pd(clamped, _mm512_set1_pd(Log2E)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+
+		__m512d r = _mm512_fnmadd_pd(n, _mm512_set1_pd(Ln2HighD), clamped);
+		r = _mm512_fnmadd_pd(n, _mm512_set1_pd(Ln2LowD), r);
+
+		__m512d p = _mm512_set1_pd(CoefficientsD[0]);
+		for (size_t k = 1; k < std::size(CoefficientsD); ++k)
+		{
+			p = _mm512_fmadd_pd(p, r, _mm512_set1_pd(CoefficientsD[k]));
+		}
+
+		return _mm512_mask_blend_pd(_mm512_cmp_pd_mask(x, x, _CMP_UNORD_Q), _mm512_maskz_scalef_pd(0xFF, p, n), x);
+	}
+
+	/// <summary>
+	/// AVX-512 exponential of sixteen floats
+	/// </summary>
+	__attribute__((target("avx512f")))
+	inline __m512 expAvx512(__m512 x)
+	{
+		const __m512 clamped = _mm512_maskz_min_ps(0xFFFF, _mm512_maskz_max_ps(0xFFFF, x, _mm512_set1_ps(MinExpF)), _mm512_set1_ps(MaxExpF));
+		const __m512 n = _mm512_maskz_roundscale_ps(0xFFFF, _mm512_mul_ps(clamped, _mm512_set1_ps(float(Log2E))), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+
+		__m512 r = _mm512_fnmadd_ps(n, _mm512_set1_ps(Ln2HighF), clamped);
+		r = _mm512_fnmadd_ps(n, _mm512_set1_ps(Ln2LowF), r);
+
+		__m512 p = _mm512_set1_ps(CoefficientsF[0]);
+		for (size_t k = 1; k < std::size(CoefficientsF); ++k)
+		{
+			p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(CoefficientsF[k]));
+		}
+
+		return _mm512_mask_blend_ps(_mm512_cmp_ps_mask(x, x, _CMP_UNORD_Q), _mm512_maskz_scalef_ps(0xFFFF, p, n), x);
+	}
+
+	/// <summary>
+	/// AVX-512 logistic sigmoid of eight doubles
+	/// </summary>
+	__attribute__((target("avx512f")))
+	inline __m512d sigmoidAvx512(__m512d x)
+	{
+		const __m512d one = _mm512_set1_pd(1.0);
+		return _mm512_div_pd(one, _mm512_add_pd(one, expAvx512(_mm512_sub_pd(_mm512_setzero_pd(), x))));
+	}
+
+	/// <summary>
+	/// AVX-512 logistic sigmoid of sixteen floats
+	/// </summary>
+	__attribute__((target("avx512f")))
+	inline __m512 sigmoidAvx512(__m512 x)
+	{
+		const __m512 one = _mm512_set1_ps(1.0f);
+		return _mm512_div_ps(one, _mm512_add_ps(one, expAvx512(_mm512_sub_ps(_mm512_setzero_ps(), x))));
+	}
+
+	/// <summary>
+	/// AVX-512 element-wise function of one vector
+	/// </summary>
+	template <Function F, typename V>
+	__attribute__((target("avx512f")))
+	inline V evaluateAvx512(V x)
+	{
+		if constexpr (F == Function::Exp)
+		{
+			return expAvx512(x);
+		}
+		else
+		{
+			return sigmoidAvx512(x);
+		}
+	}
+
+	/// <summary>
+	/// AVX-512 element-wise function for double, the tail through masked loads
+	/// and stores. Zeroing loads give the inactive lanes a defined value, zero,
+	/// which the function maps to a finite result without raising exceptions.
+	/// </summary>
+	template <Function F>
+	__attribute__((target("avx512f")))
+	void applyAvx512(const double* x, double* y, size_t n)
+	{
+		for (size_t i = 0; i < n; i += 8)
+		{
+			const __mmask8 mask = n - i >= 8 ? __mmask8(0xFF) : __mmask8((1u << (n - i)) - 1);
+			_mm512_mask_storeu_pd(y + i, mask, evaluateAvx512<F>(_mm512_maskz_loadu_pd(mask, x + i)));
+		}
+	}
+
+	/// <summary>
+	/// AVX-512 element-wise function for float
+	/// </summary>
+	template <Function F>
+	__attribute__((target("avx512f")))
+	void applyAvx512(const float* x, float* y, size_t n)
+	{
+		for (size_t i = 0; i < n; i += 16)
+		{
+			const __mmask16 mask = n - i >= 16 ? __mmask16(0xFFFF) : __mmask16((1u << (n - i)) - 1);
+			_mm512_mask_storeu_ps(y + i, mask, evaluateAvx512<F>(_mm512_maskz_loadu_ps(mask, x + i)));
+		}
+	}
+#endif
+
+	/// <summary>
+	/// Kernel of an element-wise function for the running CPU
+	/// </summary>
+	template <Function F, typename T>
+	Kernel<T> selectKernel()
+	{
+#ifdef ML_VECTOR_MATH_X86
+		if (__builtin_cpu_supports("avx512f"))
+		{
+			return static_cast<Kernel<T>>(applyAvx512<F>);
+		}
+		if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+		{
+			return static_cast<Kernel<T>>(applyAvx2<F>);
+		}
+#endif
+		return applyScalar<F, T>;
+	}
+}
+
+template <typename T>
+void vectorExp(const T* x, T* y, size_t n)
+{
+	static const Kernel<T> kernel = selectKernel<Function::Exp, T>();
+	kernel(x, y, n);
+}
+
+template <typename T>
+void vectorSigmoid(const T* x, T* y, size_t n)
+{
+	static const Kernel<T> kernel = selectKernel<Function::Sigmoid, T>();
+	kernel(x, y, n);
+}
+
+template void vectorExp<float>(const float*, float*, size_t);
+template void vectorExp<double>(const double*, double*, size_t);
+
+template void vectorSigmoid<float>(const float*, float*, size_t);
+template void vectorSigmoid<double>(const double*, double*, size_t);
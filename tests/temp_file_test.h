@@ -0,0 +1,34 @@
+#ifndef TEMP_FILE_TEST_H
+#define TEMP_FILE_TEST_H
+
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// Fixture for tests writing files: paths are named after the running test
+// and the files are removed when it ends
+class TempFileTest : public ::testing::Test
+{
+protected:
+    // Path of a temporary file unique to the running test
+    std::string tempPath(const std::string& suffix)
+    {
+        const auto* info = ::testing::UnitTest::GetInstance()->current_test_info();
+        paths.push_back((std::filesystem::temp_directory_path() /
+            ("ml_" + std::string(info->test_suite_name()) + "_" + info->name() + suffix + ".bin")).string());
+        return paths.back();
+    }
+
+    void TearDown() override
+    {
+        for (const auto& p : paths) std::filesystem::remove(p);
+    }
+
+    std::vector<std::string> paths;
+
+    // Default file of the test
+    std::string path = tempPath("");
+};
+
+#endif // !TEMP_FILE_TEST_H
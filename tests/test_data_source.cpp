@@ -0,0 +1,166 @@
+#include "data_source.h"
+#include "kmeans.h"
+#include "matrix.h"
+#include "temp_file_test.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+class DataSourceTest : public TempFileTest {};
+
+// Test every source returns the same rows, with and without prefetching
+TEST_F(DataSourceTest, ReadChunks)
+{
+    Matrix X(50, 3);
+    for (size_t i = 0; i < 50; ++i)
+        for (size_t j = 0; j < 3; ++j)
+            X(i, j) = double(i * 3 + j);
+    writeDataset<double>(path, X);
+
+    MappedDataset dataset(path);
+    ViewSource view(X);
+    MappedSource mapped(dataset);
+    FileSource file(path);
+
+    for (DataSource* source : { static_cast<DataSource*>(&view), static_cast<DataSource*>(&mapped), static_cast<DataSource*>(&file) })
+    {
+        EXPECT_EQ(source->getNumOfRows(), 50u);
+        EXPECT_EQ(source->getNumOfCols(), 3u);
+
+        for (size_t first = 0; first < 50; first += 16)
+        {
+            const size_t count = std::min<size_t>(16, 50 - first);
+            const MatrixView chunk = source->read(first, count);
+
+            // Announced after the read, as a consumer does before working on the chunk
+            source->prefetch(first + 16, 16);
+            ASSERT_EQ(chunk.getNumOfRows(), count);
+            for (size_t i = 0; i < count; ++i)
+                for (size_t j = 0; j < 3; ++j)
+                    EXPECT_EQ(chunk(i, j), X(first + i, j));
+        }
+
+        // A read other than the prefetched one
+        source->prefetch(10, 5);
+        EXPECT_EQ(source->read(20, 1)(0, 1), X(20, 1));
+
+        // The prefetched rows are still served after the other read
+        const MatrixView kept = source->read(10, 5);
+        for (size_t i = 0; i < 5; ++i) EXPECT_EQ(kept(i, 2), X(10 + i, 2));
+    }
+
+    EXPECT_THROW(file.read(45, 10), std::invalid_argument);
+    EXPECT_THROW(FileSourceF{ path }, std::invalid_argument);
+    EXPECT_THROW(FileSource{ path + ".missing" }, std::runtime_error);
+}
+
+// Test an out-of-core fit in several chunks gives the same clusters as an in-memory fit
+TEST_F(DataSourceTest, KMeansFitFromSource)
+{
+    std::mt19937 gen(6);
+    std::normal_distribution<double> noise(0.0, 1.0);
+
+    Matrix X(5000, 3);
+    for (size_t i = 0; i < 5000; ++i)
+        for (size_t j = 0; j < 3; ++j)
+            X(i, j) = noise(gen) + 6.0 * ((i + j) % 5);
+    writeDataset<double>(path, X);
+
+    for (KMeansAlgorithm algorithm : { KMeansAlgorithm::Lloyd, KMeansAlgorithm::Hamerly, KMeansAlgorithm::Elkan })
+    {
+        KMeans inMemory(5, 50, 1e-9, algorithm, KMeansInit::KMeansPlusPlus);
+        inMemory.fit(X);
+
+        MappedDataset dataset(path);
+        MappedSource mapped(dataset);
+        KMeans fromMapped(5, 50, 1e-9, algorithm, KMeansInit::KMeansPlusPlus);
+        fromMapped.fit(mapped, 1500);
+
+        FileSource file(path);
+        KMeans fromFile(5, 50, 1e-9, algorithm, KMeansInit::KMeansPlusPlus);
+        fromFile.fit(file, 700);
+
+        EXPECT_EQ(fromMapped.getCentroids(), inMemory.getCentroids());
+        EXPECT_EQ(fromMapped.getLabels(), inMemory.getLabels());
+        EXPECT_EQ(fromFile.getCentroids(), inMemory.getCentroids());
+        EXPECT_EQ(fromFile.getLabels(), inMemory.getLabels());
+    }
+}
+
+// Source over a view that records its prefetched and read ranges
+class RecordingSource : public DataSource
+{
+public:
+    explicit RecordingSource(const MatrixView& X) :m_source(X) { }
+
+    size_t getNumOfRows() const override { return m_source.getNumOfRows(); }
+    size_t getNumOfCols() const override { return m_source.getNumOfCols(); }
+
+    MatrixView read(size_t first, size_t count) override
+    {
+        reads.emplace_back(first, count);
+        return m_source.read(first, count);
+    }
+
+    void prefetch(size_t first, size_t count) override { prefetches.emplace_back(reads.size(), std::make_pair(first, count)); }
+
+    // Ranges read, in order
+    std::vector<std::pair<size_t, size_t>> reads;
+
+    // Ranges prefetched, with the number of reads before each
+    std::vector<std::pair<size_t, std::pair<size_t, size_t>>> prefetches;
+
+private:
+    ViewSource m_source;
+};
+
+// Test every chunk the fit prefetches is read afterwards, whether it converges or runs out of iterations
+TEST_F(DataSourceTest, KMeansPrefetchesOnlyReadChunks)
+{
+    std::mt19937 gen(3);
+    std::normal_distribution<double> noise(0.0, 1.0);
+
+    Matrix X(3000, 2);
+    for (size_t i = 0; i < 3000; ++i)
+        for (size_t j = 0; j < 2; ++j)
+            X(i, j) = noise(gen) + 8.0 * (i % 3);
+
+    for (size_t maxIterations : { 3, 100 })
+    {
+        RecordingSource source(X);
+        KMeans km(3, maxIterations, 1e-6, KMeansAlgorithm::Lloyd, KMeansInit::KMeansPlusPlus);
+        km.fit(source, 700);
+
+        ASSERT_FALSE(source.prefetches.empty());
+        for (const auto& [readsBefore, range] : source.prefetches)
+        {
+            const auto next = std::find(source.reads.begin() + readsBefore, source.reads.end(), range);
+            EXPECT_NE(next, source.reads.end()) << "rows " << range.first << " + " << range.second;
+        }
+    }
+}
+
+// Test seeding on a sample of a large source still finds the clusters
+TEST_F(DataSourceTest, KMeansSampledSeeding)
+{
+    MatrixF X(100000, 2);
+    for (size_t i = 0; i < 100000; ++i)
+    {
+        X(i, 0) = float(20 * (i % 4)) + float(i % 7) * 0.1f;
+        X(i, 1) = float(i % 5) * 0.1f;
+    }
+    writeDataset<float>(path, X);
+
+    FileSourceF file(path);
+    KMeansF km(4, 20, 1e-4f, KMeansAlgorithm::Lloyd, KMeansInit::KMeansPlusPlus);
+    km.fit(file, 30000);
+
+    ASSERT_EQ(km.getLabels().size(), 100000u);
+    for (size_t i = 4; i < 100000; i += 997)
+        EXPECT_EQ(km.getLabels()[i], km.getLabels()[i % 4]);
+    EXPECT_EQ(km.predict({ 40.3f, 0.2f }), km.getLabels()[2]);
+}
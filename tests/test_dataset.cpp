@@ -0,0 +1,101 @@
+#include "dataset.h"
+#include "matrix.h"
+#include "temp_file_test.h"
+#include <gtest/gtest.h>
+#include <bit>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+class DatasetTest : public TempFileTest {};
+
+// Test a written matrix is mapped back unchanged and aligned
+TEST_F(DatasetTest, WriteAndMap)
+{
+    Matrix X({ {1, 2, 3}, {4, 5, 6}, {7, 8, 9}, {10, 11, 12} });
+    writeDataset<double>(path, X, 128);
+
+    MappedDataset dataset(path);
+    EXPECT_EQ(dataset.getNumOfRows(), 4);
+    EXPECT_EQ(dataset.getNumOfCols(), 3);
+    EXPECT_EQ(dataset.getDataType(), DataType::Float64);
+
+    const MatrixView view = dataset.view<double>();
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(view.data()) % 128, 0);
+    for (size_t i = 0; i < 4; ++i)
+        for (size_t j = 0; j < 3; ++j)
+            EXPECT_DOUBLE_EQ(view(i, j), X(i, j));
+
+    EXPECT_THROW(dataset.view<float>(), std::invalid_argument);
+
+    // Moving keeps the mapping alive
+    MappedDataset moved(std::move(dataset));
+    EXPECT_DOUBLE_EQ(moved.view<double>()(3, 2), 12.0);
+
+    // Single-pass advice maps the same rows
+    MappedDataset sequential(path, DatasetAccess::Sequential);
+    EXPECT_DOUBLE_EQ(sequential.view<double>()(2, 1), 8.0);
+}
+
+// Test rows appended one at a time and in blocks, including from a strided view
+TEST_F(DatasetTest, StreamingWriter)
+{
+    MatrixF X({ {1, 2, 3, 0}, {4, 5, 6, 0}, {7, 8, 9, 0} });
+    {
+        DatasetWriterF writer(path, 3);
+        writer.append(X.row(0).first(3));
+        writer.append(MatrixViewF(X.data() + 4, 2, 3, 4));
+        EXPECT_EQ(writer.getNumOfRows(), 3);
+        EXPECT_THROW(writer.append(X.row(0)), std::invalid_argument);
+    }
+
+    MappedDataset dataset(path);
+    const MatrixViewF view = dataset.view<float>();
+    ASSERT_EQ(view.getNumOfRows(), 3);
+    EXPECT_FLOAT_EQ(view(0, 0), 1.0f);
+    EXPECT_FLOAT_EQ(view(2, 2), 9.0f);
+}
+
+// Test files that are not valid datasets are rejected
+TEST_F(DatasetTest, InvalidFiles)
+{
+    EXPECT_THROW(MappedDataset("/nonexistent/ml_dataset.bin"), std::runtime_error);
+
+    {
+        std::ofstream file(path, std::ios::binary);
+        file << std::string(128, 'x');
+    }
+    EXPECT_THROW(MappedDataset dataset(path), std::runtime_error);
+
+    // A header promising more rows than the file holds
+    writeDataset<double>(path, Matrix({ {1, 2}, {3, 4} }));
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - sizeof(double));
+    EXPECT_THROW(MappedDataset dataset(path), std::runtime_error);
+
+    // Headers patched in place: a byte order mark written by a machine of the
+    // other byte order, and a version 1 file, which has no mark
+    const auto patchHeader = [this](auto change)
+    {
+        writeDataset<double>(path, Matrix({ {1, 2}, {3, 4} }));
+        DatasetHeader header;
+        std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+        file.read(reinterpret_cast<char*>(&header), sizeof(header));
+        change(header);
+        file.seekp(0);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    };
+
+    patchHeader([](DatasetHeader& header) { header.byteOrder = 0x04030201; });
+    EXPECT_THROW(MappedDataset dataset(path), std::runtime_error);
+
+    patchHeader([](DatasetHeader& header) { header.byteOrder = 0; });
+    EXPECT_THROW(MappedDataset dataset(path), std::runtime_error);
+
+    patchHeader([](DatasetHeader& header) { header.version = 1; header.byteOrder = 0; });
+    if constexpr (std::endian::native == std::endian::little)
+        EXPECT_DOUBLE_EQ(MappedDataset(path).view<double>()(1, 0), 3.0);
+    else
+        EXPECT_THROW(MappedDataset dataset(path), std::runtime_error);
+}
@@ -0,0 +1,104 @@
+#include "distance.h"
+#include "matrix.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+    template <typename T>
+    T referenceSquared(const std::vector<T>& a, const std::vector<T>& b)
+    {
+        long double sum = 0;
+        for (size_t j = 0; j < a.size(); ++j) sum += (long double)(a[j] - b[j]) * (a[j] - b[j]);
+        return static_cast<T>(sum);
+    }
+}
+
+// Test the SIMD kernels against a reference for every tail length
+TEST(DistanceTest, MatchesReference)
+{
+    std::mt19937 gen(3);
+    std::uniform_real_distribution<double> value(-1.0, 1.0);
+
+    for (size_t n = 0; n <= 70; ++n)
+    {
+        std::vector<double> a(n), b(n);
+        for (size_t j = 0; j < n; ++j) { a[j] = value(gen); b[j] = value(gen); }
+        std::vector<float> af(a.begin(), a.end()), bf(b.begin(), b.end());
+
+        EXPECT_NEAR(squaredEuclideanDistance(a.data(), b.data(), n), referenceSquared(a, b), 1e-12);
+        EXPECT_NEAR(squaredEuclideanDistance(af.data(), bf.data(), n), referenceSquared(af, bf), 1e-4f);
+
+        if (n > 0)
+        {
+            double ab = 0, aa = 0, bb = 0;
+            for (size_t j = 0; j < n; ++j) { ab += a[j] * b[j]; aa += a[j] * a[j]; bb += b[j] * b[j]; }
+            EXPECT_NEAR(cosineDistance(a.data(), b.data(), n), 1.0 - ab / std::sqrt(aa * bb), 1e-12);
+            EXPECT_NEAR(cosineDistance(af.data(), bf.data(), n), 1.0 - ab / std::sqrt(aa * bb), 1e-4);
+        }
+    }
+}
+
+// Test the span helpers
+TEST(DistanceTest, Spans)
+{
+    const std::vector<double> a = { 0, 0, 0 }, b = { 1, 2, 2 }, c = { 2, 4, 4 };
+    EXPECT_DOUBLE_EQ(euclideanDistance<double>(a, b), 3.0);
+    EXPECT_DOUBLE_EQ(squaredEuclideanDistance<double>(a, b), 9.0);
+    EXPECT_NEAR(cosineDistance<double>(b, c), 0.0, 1e-12);
+    EXPECT_DOUBLE_EQ(cosineDistance<double>(a, b), 1.0);
+    EXPECT_DOUBLE_EQ(squaredEuclideanDistance<2>(b.data(), c.data()), 5.0);
+    EXPECT_THROW(euclideanDistance<double>(a, std::vector<double>{ 1, 2 }), std::invalid_argument);
+}
+
+// Test the closest row for fixed and generic dimensions
+TEST(DistanceTest, NearestRow)
+{
+    for (size_t d : { 1, 2, 3, 4, 5, 8, 16, 17 })
+    {
+        Matrix rows(5, d);
+        for (size_t i = 0; i < 5; ++i)
+            for (size_t j = 0; j < d; ++j)
+                rows(i, j) = 10.0 * i + j;
+
+        std::vector<double> x(d);
+        for (size_t j = 0; j < d; ++j) x[j] = 31.0 + j;
+
+        double squared = 0;
+        EXPECT_EQ(nearestRow<double>(x, rows, &squared), 3);
+        EXPECT_NEAR(squared, d * 1.0, 1e-12);
+    }
+
+    Matrix rows({ {1, 1}, {1, 1} });
+    EXPECT_EQ(nearestRow<double>(std::vector<double>{ 1, 1 }, rows), 0);
+    EXPECT_THROW(nearestRow<double>(std::vector<double>{ 1, 1, 1 }, rows), std::invalid_argument);
+}
+
+// Test argmin returns the first smallest value at every length and position
+TEST(DistanceTest, Argmin)
+{
+    std::mt19937 gen(4);
+    std::uniform_int_distribution<int> dist(-5, 5);
+
+    for (size_t n = 1; n <= 70; ++n)
+    {
+        // Few distinct values, so ties are common
+        std::vector<double> d(n);
+        std::vector<float> f(n);
+        for (size_t i = 0; i < n; ++i) { d[i] = dist(gen); f[i] = float(d[i]); }
+
+        const size_t expected = std::min_element(d.begin(), d.end()) - d.begin();
+        EXPECT_EQ(argmin(d.data(), n), expected);
+        EXPECT_EQ(argmin(f.data(), n), expected);
+
+        d[n - 1] = -10.0;
+        f[n - 1] = -10.0f;
+        EXPECT_EQ(argmin(d.data(), n), n - 1);
+        EXPECT_EQ(argmin(f.data(), n), n - 1);
+    }
+}
@@ -0,0 +1,128 @@
+#include "factorization.h"
+#include "matrix.h"
+#include <gtest/gtest.h>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+    Matrix randomMatrix(size_t rows, size_t cols, std::mt19937& gen)
+    {
+        std::uniform_real_distribution<double> dist(-1.0, 1.0);
+        Matrix m(rows, cols);
+        for (size_t i = 0; i < rows; ++i)
+            for (size_t j = 0; j < cols; ++j)
+                m(i, j) = dist(gen);
+        return m;
+    }
+}
+
+// Test Cholesky of an SPD matrix larger than one block, L L^T = A and A x = b
+TEST(FactorizationTest, CholeskySolve)
+{
+    std::mt19937 gen(5);
+    const size_t n = 150;
+    Matrix a = randomMatrix(2 * n, n, gen).gram();  // SPD
+    std::vector<double> x(n);
+    for (size_t i = 0; i < n; ++i) x[i] = static_cast<double>(i % 7) - 3.0;
+    const std::vector<double> b = a * x;
+
+    CholeskyFactorization chol(a);
+    const Matrix& l = chol.getL();
+    const Matrix llt = l * l.transpose();
+    for (size_t i = 0; i < n; ++i)
+    {
+        for (size_t j = i + 1; j < n; ++j) ASSERT_EQ(l(i, j), 0.0);  // Upper triangle cleared
+        for (size_t j = 0; j < n; ++j) ASSERT_NEAR(llt(i, j), a(i, j), 1e-9);
+    }
+
+    const std::vector<double> solution = chol.solve(b);
+    for (size_t i = 0; i < n; ++i) EXPECT_NEAR(solution[i], x[i], 1e-8);
+    EXPECT_THROW(chol.solve({ 1.0 }), std::invalid_argument);
+}
+
+// Test Cholesky rejects matrices that are not positive definite
+TEST(FactorizationTest, CholeskyNotPositiveDefinite)
+{
+    Matrix a({ {1.0, 2.0}, {2.0, 1.0} });
+    EXPECT_THROW(CholeskyFactorization c(a), std::runtime_error);
+    EXPECT_THROW(CholeskyFactorization c(Matrix(2, 3)), std::invalid_argument);
+}
+
+// Test QR least squares against the exact solution of a consistent overdetermined system
+TEST(FactorizationTest, QRLeastSquares)
+{
+    std::mt19937 gen(9);
+    Matrix a = randomMatrix(40, 6, gen);
+    const std::vector<double> x = { 1.0, -2.0, 0.5, 3.0, 0.0, -1.0 };
+    const std::vector<double> b = a * x;
+
+    QRFactorization qr(a);
+    const std::vector<double> solution = qr.solve(b);
+    ASSERT_EQ(solution.size(), 6);
+    for (size_t i = 0; i < 6; ++i) EXPECT_NEAR(solution[i], x[i], 1e-10);
+
+    // R^T R = A^T A
+    const Matrix r = qr.getR();
+    const Matrix rtr = r.transpose() * r;
+    const Matrix ata = a.gram();
+    for (size_t i = 0; i < 6; ++i)
+        for (size_t j = 0; j < 6; ++j)
+            EXPECT_NEAR(rtr(i, j), ata(i, j), 1e-10);
+}
+
+// Test QR handles a zero leading element and reports rank deficiency
+TEST(FactorizationTest, QRZeroPivotAndRankDeficient)
+{
+    // Leading element is zero, the matrix is still full rank
+    Matrix a({ {0.0, 1.0}, {1.0, 0.0}, {1.0, 1.0} });
+    const std::vector<double> solution = QRFactorization(a).solve({ 2.0, 1.0, 3.0 });
+    EXPECT_NEAR(solution[0], 1.0, 1e-12);
+    EXPECT_NEAR(solution[1], 2.0, 1e-12);
+
+    // Second column is zero
+    Matrix deficient({ {1.0, 0.0}, {2.0, 0.0}, {3.0, 0.0} });
+    EXPECT_THROW(QRFactorization(deficient).solve({ 1.0, 2.0, 3.0 }), std::runtime_error);
+    EXPECT_THROW(QRFactorization q(Matrix(2, 3)), std::invalid_argument);
+}
+
+// Test LU with pivoting on a matrix larger than one block, for vector and matrix right hand sides
+TEST(FactorizationTest, LUSolve)
+{
+    std::mt19937 gen(21);
+    const size_t n = 150;
+    Matrix a = randomMatrix(n, n, gen);
+    a(0, 0) = 0.0;  // Needs a row swap on the first pivot
+
+    std::vector<double> x(n);
+    for (size_t i = 0; i < n; ++i) x[i] = static_cast<double>(i % 5) - 2.0;
+
+    const LUFactorization lu(a);
+    EXPECT_FALSE(lu.isSingular());
+
+    const std::vector<double> solution = lu.solve(a * x);
+    for (size_t i = 0; i < n; ++i) EXPECT_NEAR(solution[i], x[i], 1e-9);
+
+    const Matrix xs = randomMatrix(n, 70, gen);
+    const Matrix solutions = lu.solve(a * xs);
+    for (size_t i = 0; i < n; ++i)
+        for (size_t j = 0; j < 70; ++j)
+            ASSERT_NEAR(solutions(i, j), xs(i, j), 1e-9);
+
+    EXPECT_THROW(lu.solve(std::vector<double>(3)), std::invalid_argument);
+}
+
+// Test determinants, including the sign of row swaps and singular matrices
+TEST(FactorizationTest, LUDeterminant)
+{
+    EXPECT_NEAR(LUFactorization(Matrix({ {4.0, 7.0}, {2.0, 6.0} })).determinant(), 10.0, 1e-12);
+    EXPECT_NEAR(LUFactorization(Matrix({ {0.0, 1.0}, {1.0, 0.0} })).determinant(), -1.0, 1e-12);
+    EXPECT_NEAR(LUFactorization(Matrix({ {2.0, 0.0, 0.0}, {0.0, 3.0, 0.0}, {1.0, 0.0, 4.0} })).determinant(), 24.0, 1e-12);
+
+    const LUFactorization singular(Matrix({ {1.0, 2.0}, {2.0, 4.0} }));
+    EXPECT_TRUE(singular.isSingular());
+    EXPECT_EQ(singular.determinant(), 0.0);
+    EXPECT_THROW(singular.solve(std::vector<double>{ 1.0, 2.0 }), std::runtime_error);
+    EXPECT_THROW(LUFactorization lu(Matrix(2, 3)), std::invalid_argument);
+}
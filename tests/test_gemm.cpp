@@ -0,0 +1,184 @@
+#include "gemm.h"
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
+namespace
+{
+    // Reference product of op(A) (m x k) and op(B) (k x n) on row-major buffers
+    std::vector<double> referenceProduct(bool transA, bool transB, size_t m, size_t n, size_t k,
+        const std::vector<double>& a, const std::vector<double>& b)
+    {
+        std::vector<double> c(m * n, 0.0);
+        for (size_t i = 0; i < m; ++i)
+        {
+            for (size_t j = 0; j < n; ++j)
+            {
+                for (size_t p = 0; p < k; ++p)
+                {
+                    const double aip = transA ? a[p * m + i] : a[i * k + p];
+                    const double bpj = transB ? b[j * k + p] : b[p * n + j];
+                    c[i * n + j] += aip * bpj;
+                }
+            }
+        }
+        return c;
+    }
+
+    std::vector<double> randomVector(size_t size, std::mt19937& gen)
+    {
+        std::uniform_real_distribution<double> dist(-1.0, 1.0);
+        std::vector<double> v(size);
+        for (auto& x : v) x = dist(gen);
+        return v;
+    }
+}
+
+// Test all transpose combinations on sizes that are not multiples of the register and cache tiles
+TEST(GemmTest, MatchesReference)
+{
+    std::mt19937 gen(7);
+    const size_t shapes[][3] = { {1, 1, 1}, {7, 9, 5}, {13, 17, 300}, {130, 11, 3}, {5, 2100, 7} };
+
+    for (const auto& shape : shapes)
+    {
+        const size_t m = shape[0], n = shape[1], k = shape[2];
+        const std::vector<double> a = randomVector(m * k, gen);
+        const std::vector<double> b = randomVector(k * n, gen);
+
+        for (bool ta : { false, true })
+        {
+            for (bool tb : { false, true })
+            {
+                std::vector<double> c(m * n, 0.0);
+                gemm(ta ? Transpose::Yes : Transpose::No, tb ? Transpose::Yes : Transpose::No, m, n, k,
+                    1.0, a.data(), ta ? m : k, b.data(), tb ? k : n, 0.0, c.data(), n);
+
+                const std::vector<double> expected = referenceProduct(ta, tb, m, n, k, a, b);
+                for (size_t i = 0; i < c.size(); ++i)
+                {
+                    ASSERT_NEAR(c[i], expected[i], 1e-10) << "m=" << m << " n=" << n << " k=" << k;
+                }
+            }
+        }
+    }
+}
+
+// Test alpha and beta scaling, and writing into a sub-block of a wider matrix
+TEST(GemmTest, AlphaBetaAndStride)
+{
+    // A = [1 2; 3 4], B = identity
+    const std::vector<double> a = { 1, 2, 3, 4 };
+    const std::vector<double> b = { 1, 0, 0, 1 };
+    // C is the left 2x2 block of a 2x3 buffer
+    std::vector<double> c = { 1, 1, 9, 1, 1, 9 };
+
+    gemm(Transpose::No, Transpose::No, 2, 2, 2, 2.0, a.data(), 2, b.data(), 2, 3.0, c.data(), 3);
+
+    EXPECT_DOUBLE_EQ(c[0], 5.0);
+    EXPECT_DOUBLE_EQ(c[1], 7.0);
+    EXPECT_DOUBLE_EQ(c[3], 9.0);
+    EXPECT_DOUBLE_EQ(c[4], 11.0);
+    EXPECT_DOUBLE_EQ(c[2], 9.0);  // Outside the block, untouched
+    EXPECT_DOUBLE_EQ(c[5], 9.0);
+}
+
+// Test plain and transposed matrix-vector products, including a long reduction
+TEST(GemmTest, Gemv)
+{
+    std::mt19937 gen(11);
+    const size_t shapes[][2] = { {1, 1}, {5, 3}, {200000, 3}, {37, 500} };
+
+    for (const auto& shape : shapes)
+    {
+        const size_t m = shape[0], n = shape[1];
+        const std::vector<double> a = randomVector(m * n, gen);
+        const std::vector<double> x = randomVector(n, gen);
+        const std::vector<double> xt = randomVector(m, gen);
+
+        std::vector<double> y(m), yt(n);
+        gemv(Transpose::No, m, n, 1.0, a.data(), n, x.data(), 0.0, y.data());
+        gemv(Transpose::Yes, m, n, 1.0, a.data(), n, xt.data(), 0.0, yt.data());
+
+        const std::vector<double> expected = referenceProduct(false, false, m, 1, n, a, x);
+        const std::vector<double> expectedT = referenceProduct(true, false, n, 1, m, a, xt);
+        for (size_t i = 0; i < m; ++i) ASSERT_NEAR(y[i], expected[i], 1e-9);
+        for (size_t j = 0; j < n; ++j) ASSERT_NEAR(yt[j], expectedT[j], 1e-9);
+    }
+}
+
+// Test the plain product on every row and column remainder of the kernels, with a row stride, alpha, beta and float
+TEST(GemmTest, GemvRemainders)
+{
+    std::mt19937 gen(12);
+
+    for (size_t m = 1; m <= 9; ++m)
+    {
+        for (size_t n : { 1u, 3u, 4u, 7u, 8u, 9u, 16u, 17u, 33u })
+        {
+            const size_t lda = n + 3;
+            const std::vector<double> a = randomVector(m * lda, gen);
+            const std::vector<double> x = randomVector(n, gen);
+            const std::vector<double> y0 = randomVector(m, gen);
+            const std::vector<float> aF(a.begin(), a.end()), xF(x.begin(), x.end());
+
+            std::vector<double> y = y0;
+            std::vector<float> yF(y0.begin(), y0.end());
+            gemv(Transpose::No, m, n, 2.0, a.data(), lda, x.data(), 0.5, y.data());
+            gemv(Transpose::No, m, n, 2.0f, aF.data(), lda, xF.data(), 0.5f, yF.data());
+
+            for (size_t i = 0; i < m; ++i)
+            {
+                double expected = 0.0;
+                for (size_t j = 0; j < n; ++j) expected += a[i * lda + j] * x[j];
+                expected = 2.0 * expected + 0.5 * y0[i];
+
+                ASSERT_NEAR(y[i], expected, 1e-12);
+                ASSERT_NEAR(yF[i], expected, 1e-4);
+            }
+        }
+    }
+}
+
+// Test the upper triangle of A^T A over several tiles and row blocks, and that the lower triangle is untouched
+TEST(GemmTest, Syrk)
+{
+    std::mt19937 gen(13);
+    const size_t shapes[][2] = { {1, 1}, {4, 9}, {130, 50}, {20, 10000}, {100, 5000} };
+
+    for (const auto& shape : shapes)
+    {
+        const size_t n = shape[0], k = shape[1];
+        const std::vector<double> a = randomVector(k * n, gen);
+        std::vector<double> c(n * n, -1.0);
+
+        syrk(n, k, 1.0, a.data(), n, 0.0, c.data(), n);
+
+        const std::vector<double> expected = referenceProduct(true, false, n, n, k, a, a);
+        for (size_t i = 0; i < n; ++i)
+        {
+            for (size_t j = 0; j < n; ++j)
+            {
+                if (j >= i) ASSERT_NEAR(c[i * n + j], expected[i * n + j], 1e-8) << "n=" << n << " k=" << k;
+                else ASSERT_EQ(c[i * n + j], -1.0);
+            }
+        }
+    }
+}
+
+// Test the single precision kernel against the double precision one
+TEST(GemmTest, FloatMatchesDouble)
+{
+    std::mt19937 gen(17);
+    const size_t m = 67, n = 45, k = 300;
+    const std::vector<double> a = randomVector(m * k, gen);
+    const std::vector<double> b = randomVector(k * n, gen);
+    const std::vector<float> af(a.begin(), a.end()), bf(b.begin(), b.end());
+
+    std::vector<double> c(m * n);
+    std::vector<float> cf(m * n);
+    gemm(Transpose::No, Transpose::Yes, m, n, k, 1.0, a.data(), k, b.data(), k, 0.0, c.data(), n);
+    gemm(Transpose::No, Transpose::Yes, m, n, k, 1.0f, af.data(), k, bf.data(), k, 0.0f, cf.data(), n);
+
+    for (size_t i = 0; i < c.size(); ++i) ASSERT_NEAR(cf[i], c[i], 1e-3);
+}
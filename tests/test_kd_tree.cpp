@@ -0,0 +1,97 @@
+#include "kd_tree.h"
+#include "matrix.h"
+#include <gtest/gtest.h>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+// Test queries return the same row and distance as a linear scan
+TEST(KDTreeTest, MatchesNearestRow)
+{
+    std::mt19937 gen(2);
+    std::normal_distribution<double> noise(0.0, 1.0);
+
+    for (size_t d : { 1, 2, 3, 5, 16 })
+    {
+        for (size_t n : { 1, 7, 100, 2000 })
+        {
+            Matrix rows(n, d);
+            for (size_t i = 0; i < n; ++i)
+                for (size_t j = 0; j < d; ++j)
+                    rows(i, j) = noise(gen);
+
+            const KDTree tree(rows);
+            ASSERT_EQ(tree.size(), n);
+
+            std::vector<double> x(d);
+            for (int q = 0; q < 200; ++q)
+            {
+                for (auto& v : x) v = 1.5 * noise(gen);
+
+                double expectedDistance, distance;
+                const size_t expected = nearestRow<double>(x, rows, &expectedDistance);
+                EXPECT_EQ(tree.nearest(x, &distance), expected);
+                EXPECT_EQ(distance, expectedDistance);
+            }
+        }
+    }
+}
+
+// Test ties between equally distant rows go to the first row, as in nearestRow
+TEST(KDTreeTest, TiesAndDuplicates)
+{
+    std::mt19937 gen(8);
+    std::uniform_int_distribution<int> grid(0, 3);
+
+    // Few distinct integer points, so most queries have ties
+    MatrixF rows(300, 2);
+    for (size_t i = 0; i < 300; ++i)
+    {
+        rows(i, 0) = float(grid(gen));
+        rows(i, 1) = float(grid(gen));
+    }
+
+    KDTreeF tree;
+    EXPECT_TRUE(tree.empty());
+    tree.build(rows);
+
+    for (int a = -1; a <= 4; ++a)
+    {
+        for (int b = -1; b <= 4; ++b)
+        {
+            const std::vector<float> x = { a + 0.5f, float(b) };
+            EXPECT_EQ(tree.nearest(x), nearestRow<float>(x, rows));
+        }
+    }
+
+    EXPECT_THROW(tree.nearest(std::vector<float>{ 1.0f }), std::invalid_argument);
+    tree.clear();
+    EXPECT_THROW(tree.nearest(std::vector<float>{ 1.0f, 2.0f }), std::invalid_argument);
+}
+
+// Test queries whose distances are all NaN or infinite fall back to row 0, as in nearestRow
+TEST(KDTreeTest, NonFiniteDistances)
+{
+    std::mt19937 gen(5);
+    std::normal_distribution<double> noise(0.0, 1.0);
+
+    Matrix rows(200, 2);
+    for (size_t i = 0; i < 200; ++i)
+        for (size_t j = 0; j < 2; ++j)
+            rows(i, j) = noise(gen);
+
+    const KDTree tree(rows);
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    const double inf = std::numeric_limits<double>::infinity();
+
+    for (const std::vector<double>& x : { std::vector<double>{ nan, 0.0 }, std::vector<double>{ nan, nan },
+                                          std::vector<double>{ inf, 0.0 }, std::vector<double>{ 1e200, -1e200 } })
+    {
+        double expectedDistance, distance;
+        const size_t expected = nearestRow<double>(x, rows, &expectedDistance);
+        EXPECT_EQ(expected, 0u);
+        EXPECT_EQ(tree.nearest(x, &distance), expected);
+        EXPECT_EQ(distance, expectedDistance);
+    }
+}
@@ -1,7 +1,12 @@
 #include <gtest/gtest.h>
 #include "kmeans.h"  // Adjust to your KMeans header file
+#include "thread_pool.h"
+#include <algorithm>
+#include <random>
 #include <vector>
 #include <cmath>
+#include <stdexcept>
+#include <utility>
 
 // Helper function to check if two vectors are approximately equal
 bool vectorsApproxEqual(const std::vector<double>& a, const std::vector<double>& b, double tol)
@@ -87,4 +92,301 @@ TEST_F(KMeansTest, FewerPointsThanClusters)
     size_t label0 = km.predict({ 0,0 });
     size_t label1 = km.predict({ 1,1 });
     EXPECT_NE(label0, label1);  // Points should be in different clusters
-}
\ No newline at end of file
+}
+
+// Test fitting on a view of a contiguous buffer
+TEST_F(KMeansTest, FitOnView)
+{
+    std::vector<double> buffer = { 0,0, 1,0, 0,1, 1,1, 10,10, 11,10, 10,11, 11,11 };
+    MatrixView view(buffer.data(), 8, 2);
+    KMeans km(2, 100, 0.001);
+    km.fit(view);
+    EXPECT_NE(km.predict({ 0,0 }), km.predict({ 11,11 }));
+    EXPECT_EQ(km.predict({ 0,1 }), km.predict({ 1,0 }));
+}
+
+// Test single precision clustering
+TEST_F(KMeansTest, FloatClustering)
+{
+    std::vector<std::vector<float>> data = { {0,0}, {1,0}, {0,1}, {1,1}, {10,10}, {11,10}, {10,11}, {11,11} };
+    KMeansF km(2, 100, 0.001f);
+    km.fit(data);
+    EXPECT_NE(km.predict({ 0,0 }), km.predict({ 11,11 }));
+    EXPECT_EQ(km.predict({ 0,0 }), km.predict({ 1,1 }));
+}
+
+// Test labels of the last fit and refitting on data of another dimension
+TEST_F(KMeansTest, LabelsAndRefit)
+{
+    std::vector<std::vector<double>> data = { {0,0}, {1,0}, {10,10}, {11,10} };
+    KMeans km(2, 100, 0.001);
+    km.fit(data);
+
+    const std::vector<size_t>& labels = km.getLabels();
+    ASSERT_EQ(labels.size(), 4);
+    EXPECT_EQ(labels[0], labels[1]);
+    EXPECT_EQ(labels[2], labels[3]);
+    EXPECT_NE(labels[0], labels[2]);
+    EXPECT_EQ(labels[0], km.predict({ 0,0 }));
+
+    km.fit(std::vector<std::vector<double>>{ {1,2,3}, {1,2,3} });
+    EXPECT_EQ(km.getCentroids()[0].size(), 3);
+    EXPECT_EQ(km.getLabels().size(), 2);
+
+    EXPECT_THROW(km.fit(std::vector<std::vector<double>>{}), std::invalid_argument);
+}
+
+// Test zero clusters are rejected up front, whatever the algorithm
+TEST_F(KMeansTest, RejectsZeroClusters)
+{
+    for (KMeansAlgorithm algorithm : { KMeansAlgorithm::Lloyd, KMeansAlgorithm::Hamerly, KMeansAlgorithm::Elkan,
+                                       KMeansAlgorithm::KDTree, KMeansAlgorithm::Auto })
+        EXPECT_THROW(KMeans(0, 10, 1e-3, algorithm), std::invalid_argument);
+
+    EXPECT_THROW(MiniBatchKMeans(0), std::invalid_argument);
+    EXPECT_THROW(MiniBatchKMeans(2, 0), std::invalid_argument);
+}
+
+// Test clustering uses every dimension
+TEST_F(KMeansTest, HigherDimensions)
+{
+    // The clusters differ only in the third coordinate
+    std::vector<std::vector<double>> data = { {0,0,0}, {1,0,0}, {0,1,0}, {0,0,20}, {1,0,20}, {0,1,20} };
+    KMeans km(2, 100, 0.001);
+    km.fit(data);
+    EXPECT_NE(km.predict({ 0,0,0 }), km.predict({ 0,0,20 }));
+    EXPECT_EQ(km.predict({ 1,0,0 }), km.predict({ 0,1,0 }));
+    EXPECT_THROW(km.predict({ 0,0 }), std::invalid_argument);
+}
+
+// Test the accelerated algorithms give exactly the same clusters as Lloyd
+TEST_F(KMeansTest, AcceleratedMatchesLloyd)
+{
+    std::mt19937 gen(11);
+    std::normal_distribution<double> noise(0.0, 1.0);
+
+    for (size_t d : { 2, 5, 16 })
+    {
+        // Overlapping blobs, so many points change cluster over the iterations
+        Matrix X(2000, d);
+        for (size_t i = 0; i < X.getNumOfRows(); ++i)
+            for (size_t j = 0; j < d; ++j)
+                X(i, j) = noise(gen) + 3.0 * ((i * 7 + j) % 5);
+
+        for (size_t k : { 1, 4, 40 })
+        {
+            KMeans lloyd(k, 50, 1e-9);
+            lloyd.fit(X);
+
+            for (KMeansAlgorithm algorithm : { KMeansAlgorithm::Hamerly, KMeansAlgorithm::Elkan, KMeansAlgorithm::KDTree, KMeansAlgorithm::Auto })
+            {
+                KMeans accelerated(k, 50, 1e-9, algorithm);
+                accelerated.fit(X);
+
+                EXPECT_EQ(accelerated.getLabels(), lloyd.getLabels());
+                EXPECT_EQ(accelerated.getCentroids(), lloyd.getCentroids());
+            }
+        }
+    }
+}
+
+// Test the k-means++ and k-means|| seeds never repeat a point while others are left
+TEST_F(KMeansTest, SeedingAvoidsDuplicates)
+{
+    // Many copies of three points; uniform draws would often repeat one
+    std::vector<std::vector<double>> data;
+    for (int i = 0; i < 100; ++i)
+    {
+        data.push_back({ 0,0 });
+        data.push_back({ 5,5 });
+        data.push_back({ 9,0 });
+    }
+
+    for (KMeansInit init : { KMeansInit::KMeansPlusPlus, KMeansInit::KMeansParallel })
+    {
+        // No iterations, so the centroids are the seeds
+        KMeans km(3, 0, 0.001, KMeansAlgorithm::Lloyd, init);
+        km.fit(data);
+
+        auto seeds = km.getCentroids();
+        std::sort(seeds.begin(), seeds.end());
+        EXPECT_EQ(seeds, (std::vector<std::vector<double>>{ {0,0}, {5,5}, {9,0} }));
+    }
+}
+
+// Test the seeds only depend on the seed value, across several seeding blocks
+TEST_F(KMeansTest, SeedingIsDeterministic)
+{
+    std::mt19937 gen(5);
+    std::normal_distribution<double> noise(0.0, 1.0);
+
+    Matrix X(10000, 3);
+    for (size_t i = 0; i < X.getNumOfRows(); ++i)
+        for (size_t j = 0; j < 3; ++j)
+            X(i, j) = noise(gen) + 10.0 * ((i + j) % 8);
+
+    for (KMeansInit init : { KMeansInit::KMeansPlusPlus, KMeansInit::KMeansParallel })
+    {
+        KMeans a(8, 0, 0.001, KMeansAlgorithm::Lloyd, init, 7), b(8, 0, 0.001, KMeansAlgorithm::Lloyd, init, 7);
+        KMeans other(8, 0, 0.001, KMeansAlgorithm::Lloyd, init, 8);
+        a.fit(X);
+        b.fit(X);
+        other.fit(X);
+
+        EXPECT_EQ(a.getCentroids(), b.getCentroids());
+        EXPECT_NE(a.getCentroids(), other.getCentroids());
+
+        // Well seeded, the clusters are found
+        KMeans km(8, 100, 1e-6, KMeansAlgorithm::Lloyd, init);
+        km.fit(X);
+        for (size_t i = 0; i < 8; ++i)
+            EXPECT_EQ(km.getLabels()[i], km.getLabels()[i + 8]);
+        std::vector<size_t> firstLabels(km.getLabels().begin(), km.getLabels().begin() + 8);
+        std::sort(firstLabels.begin(), firstLabels.end());
+        EXPECT_EQ(std::unique(firstLabels.begin(), firstLabels.end()) - firstLabels.begin(), 8);
+    }
+}
+
+// Test input without columns is rejected before seeding
+TEST_F(KMeansTest, RejectsNoColumns)
+{
+    const Matrix X(10, 0);
+    for (KMeansInit init : { KMeansInit::KMeansPlusPlus, KMeansInit::KMeansParallel })
+    {
+        KMeans km(2, 10, 0.001, KMeansAlgorithm::Lloyd, init);
+        EXPECT_THROW(km.fit(X), std::invalid_argument);
+
+        ViewSource source(X);
+        EXPECT_THROW(km.fit(source, 4), std::invalid_argument);
+    }
+
+    EXPECT_THROW(MiniBatchKMeans(2).fit(X), std::invalid_argument);
+    EXPECT_THROW(MiniBatchKMeans(2).partialFit(X), std::invalid_argument);
+}
+
+// Test streaming batches through partialFit finds the clusters
+TEST_F(KMeansTest, MiniBatchPartialFit)
+{
+    std::mt19937 gen(3);
+    std::normal_distribution<double> noise(0.0, 0.5);
+
+    MiniBatchKMeans km(2, 64);
+    Matrix batch(64, 2);
+
+    for (int b = 0; b < 50; ++b)
+    {
+        // Half the points around (0, 0), half around (10, 10)
+        for (size_t i = 0; i < batch.getNumOfRows(); ++i)
+        {
+            const double center = (i % 2) * 10.0;
+            batch(i, 0) = center + noise(gen);
+            batch(i, 1) = center + noise(gen);
+        }
+        km.partialFit(batch);
+    }
+
+    auto centroids = km.getCentroids();
+    std::sort(centroids.begin(), centroids.end());
+    EXPECT_TRUE(vectorsApproxEqual(centroids[0], { 0, 0 }, tol));
+    EXPECT_TRUE(vectorsApproxEqual(centroids[1], { 10, 10 }, tol));
+    EXPECT_EQ(km.getCounts()[0] + km.getCounts()[1], 50u * 64u);
+    EXPECT_EQ(km.getLabels().size(), 64u);
+    EXPECT_NE(km.predict({ 0.2, -0.1 }), km.predict({ 9.8, 10.3 }));
+
+    EXPECT_THROW(km.partialFit(Matrix(4, 3)), std::invalid_argument);
+    EXPECT_THROW(MiniBatchKMeans(3).partialFit(Matrix(2, 2)), std::invalid_argument);
+}
+
+// Test fit draws batches from the data and labels every point
+TEST_F(KMeansTest, MiniBatchFit)
+{
+    std::vector<std::vector<double>> data = { {0,0}, {1,0}, {0,1}, {1,1}, {10,10}, {11,10}, {10,11}, {11,11} };
+
+    for (KMeansInit init : { KMeansInit::Random, KMeansInit::KMeansPlusPlus, KMeansInit::KMeansParallel })
+    {
+        MiniBatchKMeans km(2, 4, 100, 0.001, init);
+        km.fit(data);
+
+        const auto& labels = km.getLabels();
+        ASSERT_EQ(labels.size(), data.size());
+        EXPECT_EQ(labels[0], labels[3]);
+        EXPECT_EQ(labels[4], labels[7]);
+        EXPECT_NE(labels[0], labels[4]);
+    }
+}
+
+// Test the GEMM based batch prediction picks a nearest centroid, up to the
+// rounding of the distance expansion on near ties, also with more centroids
+// than fit in one block
+TEST_F(KMeansTest, PredictBatch)
+{
+    std::mt19937 gen(21);
+    std::normal_distribution<double> noise(0.0, 1.0);
+
+    for (auto [d, k] : { std::pair<size_t, size_t>{ 2, 12 }, { 7, 12 }, { 33, 12 }, { 7, 300 } })
+    {
+        Matrix X(1000, d);
+        for (size_t i = 0; i < X.getNumOfRows(); ++i)
+            for (size_t j = 0; j < d; ++j)
+                X(i, j) = noise(gen) + 4.0 * ((i + j) % 6);
+
+        KMeans km(k, 20, 0.001, KMeansAlgorithm::Lloyd, KMeansInit::KMeansPlusPlus);
+        km.fit(X);
+
+        const std::vector<size_t> labels = km.predictBatch(X);
+        const std::vector<std::vector<double>> centroids = km.getCentroids();
+        ASSERT_EQ(labels.size(), X.getNumOfRows());
+        for (size_t i = 0; i < X.getNumOfRows(); ++i)
+        {
+            std::vector<double> distances;
+            for (const auto& centroid : centroids)
+            {
+                double distance = 0.0;
+                for (size_t j = 0; j < d; ++j) distance += (X(i, j) - centroid[j]) * (X(i, j) - centroid[j]);
+                distances.push_back(distance);
+            }
+
+            // The expansion rounds relative to the squared norms, not the distance
+            double norm = 0.0;
+            for (size_t j = 0; j < d; ++j) norm += X(i, j) * X(i, j);
+
+            const double nearest = *std::min_element(distances.begin(), distances.end());
+            ASSERT_LT(labels[i], centroids.size());
+            EXPECT_LE(distances[labels[i]], nearest + 1e-12 * (norm + nearest));
+        }
+
+        EXPECT_THROW(km.predictBatch(Matrix(3, d + 1)), std::invalid_argument);
+    }
+
+    EXPECT_THROW(KMeans(2).predictBatch(Matrix(3, 2)), std::invalid_argument);
+}
+
+// Test K Means seeds, labels and centroids are bitwise the same for any thread count
+TEST_F(KMeansTest, IndependentOfThreadCount)
+{
+    std::mt19937 gen(9);
+    std::normal_distribution<double> noise(0.0, 1.0);
+    Matrix X(20000, 4);
+    for (size_t i = 0; i < 20000; ++i) for (size_t j = 0; j < 4; ++j) X(i, j) = noise(gen) + 2.0 * ((i * 3 + j) % 7);
+
+    const size_t previous = getNumThreads();
+    for (KMeansAlgorithm algorithm : { KMeansAlgorithm::Lloyd, KMeansAlgorithm::Hamerly, KMeansAlgorithm::Elkan })
+    {
+        setNumThreads(1);
+        KMeans serial(16, 20, 0.0, algorithm, KMeansInit::KMeansParallel);
+        serial.fit(X);
+
+        setNumThreads(5);
+        KMeans parallel(16, 20, 0.0, algorithm, KMeansInit::KMeansParallel);
+        parallel.fit(X);
+
+        EXPECT_EQ(serial.getLabels(), parallel.getLabels());
+        EXPECT_EQ(serial.getCentroids(), parallel.getCentroids());
+
+        const std::vector<size_t> parallelBatch = parallel.predictBatch(X);
+        setNumThreads(1);
+        EXPECT_EQ(serial.predictBatch(X), parallelBatch);
+    }
+
+    setNumThreads(previous);
+}
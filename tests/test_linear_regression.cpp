@@ -1,5 +1,7 @@
 #include "linear_regression.h"
 #include <gtest/gtest.h>
+#include <cmath>
+#include <random>
 #include <vector>
 
 // Test simple linear regression
@@ -39,4 +41,180 @@ TEST(LinearRegressionTest, InvalidInput)
     std::vector<double> x = { 1, 2, 3 };
     std::vector<double> y = { 4, 5 };  // Size mismatch
     EXPECT_THROW(LinearRegression lr(x, y), std::invalid_argument);
-}
\ No newline at end of file
+}
+
+// Test the QR solver gives the same coefficients as the normal equations
+TEST(LinearRegressionTest, QRSolver)
+{
+    // y = 1 + 2*x1 + 3*x2
+    Matrix X({ {1, 1}, {2, 1}, {3, 2}, {4, 2}, {5, 3} });
+    std::vector<double> y = { 6, 8, 13, 15, 20 };
+    LinearRegression lr(X, y, LeastSquaresSolver::QR);
+    std::vector<double> coeffs = lr.getCoefficients();
+    EXPECT_NEAR(coeffs[0], 1.0, 1e-10);
+    EXPECT_NEAR(coeffs[1], 2.0, 1e-10);
+    EXPECT_NEAR(coeffs[2], 3.0, 1e-10);
+}
+
+// Test badly scaled features are still solved
+TEST(LinearRegressionTest, IllConditioned)
+{
+    // y = 1 + 2e-6*x1 + 3*x2, with x1 of order 1e6
+    Matrix X({ {1e6, 1}, {2e6, 1}, {3e6, 2}, {4e6, 2}, {5e6, 3} });
+    std::vector<double> y = { 6, 8, 13, 15, 20 };
+    for (LeastSquaresSolver solver : { LeastSquaresSolver::Cholesky, LeastSquaresSolver::QR })
+    {
+        LinearRegression lr(X, y, solver);
+        std::vector<double> coeffs = lr.getCoefficients();
+        EXPECT_NEAR(coeffs[0], 1.0, 1e-6);
+        EXPECT_NEAR(coeffs[1], 2e-6, 1e-12);
+        EXPECT_NEAR(coeffs[2], 3.0, 1e-6);
+    }
+}
+
+// Test single precision multiple linear regression
+TEST(LinearRegressionTest, FloatMultipleLinearRegression)
+{
+    MatrixF X({ {1, 1}, {2, 1}, {3, 2}, {4, 2}, {5, 3} });
+    std::vector<float> y = { 6, 8, 13, 15, 20 };
+    LinearRegressionF lr(X, y);
+    std::vector<float> coeffs = lr.getCoefficients();
+    EXPECT_NEAR(coeffs[0], 1.0f, 1e-3f);
+    EXPECT_NEAR(coeffs[1], 2.0f, 1e-3f);
+    EXPECT_NEAR(coeffs[2], 3.0f, 1e-3f);
+}
+
+// Test sparse input gives the same coefficients as dense input
+TEST(LinearRegressionTest, SparseInput)
+{
+    // y = 1 + 2*x1 + 3*x2, with most entries zero
+    Matrix X({ {1, 0}, {0, 1}, {0, 0}, {4, 0}, {0, 2}, {5, 3} });
+    std::vector<double> y = { 3, 4, 1, 9, 7, 20 };
+    LinearRegression lr(SparseMatrix(X), y);
+    std::vector<double> coeffs = lr.getCoefficients();
+    EXPECT_NEAR(coeffs[0], 1.0, 1e-10);
+    EXPECT_NEAR(coeffs[1], 2.0, 1e-10);
+    EXPECT_NEAR(coeffs[2], 3.0, 1e-10);
+
+    std::vector<double> predictions = lr.predict(SparseMatrix(X));
+    for (size_t i = 0; i < y.size(); ++i) EXPECT_NEAR(predictions[i], y[i], 1e-10);
+}
+
+// Test the sparse solver handles all-zero and duplicated columns
+TEST(LinearRegressionTest, SparseSingularColumns)
+{
+    // y = 1 + 2*x1 + 3*x3, x2 is all zero and x4 repeats x1
+    Matrix X({ {1, 0, 0, 1}, {0, 0, 1, 0}, {2, 0, 0, 2}, {4, 0, 2, 4}, {0, 0, 3, 0}, {5, 0, 1, 5} });
+    std::vector<double> y = { 3, 4, 5, 15, 10, 14 };
+    LinearRegression lr(SparseMatrix(X), y);
+    std::vector<double> coeffs = lr.getCoefficients();
+
+    // Minimum-norm solution: the zero column gets nothing, the copies share the slope
+    EXPECT_NEAR(coeffs[0], 1.0, 1e-10);
+    EXPECT_NEAR(coeffs[1], 1.0, 1e-10);
+    EXPECT_EQ(coeffs[2], 0.0);
+    EXPECT_NEAR(coeffs[3], 3.0, 1e-10);
+    EXPECT_NEAR(coeffs[4], 1.0, 1e-10);
+}
+
+// Test the sparse solver agrees with the dense one on a noisy wider problem
+TEST(LinearRegressionTest, SparseMatchesDense)
+{
+    std::mt19937 gen(21);
+    std::uniform_real_distribution<double> u(0.0, 1.0);
+    std::normal_distribution<double> noise(0.0, 0.1);
+
+    Matrix X(500, 40);
+    std::vector<double> y(500);
+    for (size_t i = 0; i < 500; ++i)
+    {
+        y[i] = 0.5 + noise(gen);
+        for (size_t j = 0; j < 40; ++j)
+        {
+            X(i, j) = u(gen) < 0.1 ? 100.0 * u(gen) * (j + 1) : 0.0;
+            y[i] += X(i, j) / (j + 1.0);
+        }
+    }
+
+    const std::vector<double> dense = LinearRegression(X, y).getCoefficients();
+    const std::vector<double> sparse = LinearRegression(SparseMatrix(X), y).getCoefficients();
+    for (size_t j = 0; j < dense.size(); ++j) EXPECT_NEAR(sparse[j], dense[j], 1e-8 * (1.0 + std::abs(dense[j])));
+}
+
+// Test the sparse solver reports whether it met its tolerance
+TEST(LinearRegressionTest, SparseConvergence)
+{
+    std::mt19937 gen(4);
+    std::uniform_real_distribution<double> u(0.0, 1.0);
+    std::normal_distribution<double> noise(0.0, 0.1);
+
+    // Ill-conditioned: wide range of scales and two nearly collinear columns
+    Matrix X(300, 20);
+    std::vector<double> y(300);
+    for (size_t i = 0; i < 300; ++i)
+    {
+        y[i] = 1.0 + noise(gen);
+        for (size_t j = 0; j < 19; ++j)
+        {
+            X(i, j) = u(gen) < 0.2 ? std::pow(10.0, 4.0 * u(gen)) : 0.0;
+            y[i] += X(i, j);
+        }
+        X(i, 19) = X(i, 0) * (1.0 + 1e-6 * u(gen));
+    }
+
+    const LinearRegression lr(SparseMatrix(X), y, 1e-12);
+    EXPECT_TRUE(lr.hasConverged());
+    EXPECT_GT(lr.getNumOfIterations(), 0);
+    EXPECT_LT(lr.getNumOfIterations(), 200);
+
+    // The least squares residual is that of the dense QR solver, although the
+    // ill-determined coefficients themselves may differ
+    const LinearRegression dense(X, y, LeastSquaresSolver::QR);
+    EXPECT_TRUE(dense.hasConverged());
+    EXPECT_EQ(dense.getNumOfIterations(), 0);
+    std::vector<double> fitted(300), expected(300);
+    lr.predictBatch(X, fitted);
+    dense.predictBatch(X, expected);
+    double residual = 0.0, expectedResidual = 0.0;
+    for (size_t i = 0; i < 300; ++i)
+    {
+        residual += (y[i] - fitted[i]) * (y[i] - fitted[i]);
+        expectedResidual += (y[i] - expected[i]) * (y[i] - expected[i]);
+    }
+    EXPECT_NEAR(residual, expectedResidual, 1e-6 * expectedResidual);
+
+    // Stopped by the iteration cap, the last coefficients are kept and flagged
+    const LinearRegression capped(SparseMatrix(X), y, 1e-8, 2);
+    EXPECT_FALSE(capped.hasConverged());
+    EXPECT_EQ(capped.getNumOfIterations(), 2);
+    EXPECT_EQ(capped.getCoefficients().size(), 21);
+}
+
+// Test batched predictions into a caller buffer match the single-row ones
+TEST(LinearRegressionTest, PredictBatch)
+{
+    Matrix X({ {1, 1}, {2, 1}, {3, 2}, {4, 2}, {5, 3} });
+    std::vector<double> y = { 6, 8, 13, 15, 20 };
+    LinearRegression lr(X, y);
+
+    std::vector<double> out(X.getNumOfRows());
+    lr.predictBatch(X, out);
+    for (size_t i = 0; i < out.size(); ++i)
+    {
+        std::vector<double> row(X.row(i).begin(), X.row(i).end());
+        EXPECT_NEAR(out[i], lr.predict(row), 1e-12);
+    }
+
+    // Simple linear regression takes a single column
+    LinearRegression simple({ 1, 2, 3 }, { 3, 5, 7 });
+    Matrix x(2, 1);
+    x(0, 0) = 4;
+    x(1, 0) = 5;
+    std::vector<double> simpleOut(2);
+    simple.predictBatch(x, simpleOut);
+    EXPECT_NEAR(simpleOut[0], 9.0, 1e-12);
+    EXPECT_NEAR(simpleOut[1], 11.0, 1e-12);
+
+    EXPECT_THROW(lr.predictBatch(x, simpleOut), std::invalid_argument);
+    EXPECT_THROW(lr.predictBatch(X, std::span<double>(out.data(), 4)), std::invalid_argument);
+}
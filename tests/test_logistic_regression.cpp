@@ -1,9 +1,44 @@
 #include <gtest/gtest.h>
 #include "logistic_regression.h"
 #include "matrix.h"
+#include "thread_pool.h"
 #include <vector>
 #include <stdexcept>
 #include <cmath>
+#include <filesystem>
+#include <random>
+#include <string>
+
+namespace {
+    // Rows drawn from a logistic model with a few noisy labels
+    Matrix makeLogisticData(size_t n, std::vector<double>& y) {
+        std::mt19937 gen(3);
+        std::normal_distribution<double> feature(0.0, 1.0);
+        std::uniform_real_distribution<double> u(0.0, 1.0);
+        const double w[4] = { 2.0, -1.5, 1.0, 0.5 };
+
+        Matrix X(n, 4);
+        y.resize(n);
+        for (size_t i = 0; i < n; ++i) {
+            double z = 0.3;
+            for (size_t j = 0; j < 4; ++j) {
+                X(i, j) = feature(gen);
+                z += w[j] * X(i, j);
+            }
+            y[i] = u(gen) < 1.0 / (1.0 + std::exp(-z)) ? 1.0 : 0.0;
+        }
+        return X;
+    }
+
+    double accuracy(const LogisticRegression& model, const Matrix& X, const std::vector<double>& y) {
+        size_t correct = 0;
+        for (size_t i = 0; i < X.getNumOfRows(); ++i) {
+            const auto row = X.row(i);
+            correct += model.predict(std::vector<double>(row.begin(), row.end())) == int(y[i]);
+        }
+        return double(correct) / double(X.getNumOfRows());
+    }
+}
 
 // Test fixture for LogisticRegression
 class LogisticRegressionTest : public ::testing::Test {
@@ -54,6 +89,38 @@ TEST_F(LogisticRegressionTest, FitInvalidSize) {
     EXPECT_THROW(lr.fit(X, y), std::invalid_argument);
 }
 
+// Test fit on no rows throws instead of leaving NaN weights, whatever the solver
+TEST_F(LogisticRegressionTest, FitEmpty) {
+    EXPECT_THROW(lr.fit(Matrix(0, 2), std::vector<double>()), std::invalid_argument);
+
+    for (LogisticSolver solver : { LogisticSolver::SGD, LogisticSolver::Adam, LogisticSolver::LBFGS,
+        LogisticSolver::IRLS, LogisticSolver::Hogwild }) {
+        LogisticRegression model(0.1, 10, solver);
+        EXPECT_THROW(model.fit(Matrix(0, 2), std::vector<double>()), std::invalid_argument);
+    }
+}
+
+// Test gradient descent weights are bitwise the same for any thread count
+TEST_F(LogisticRegressionTest, IndependentOfThreadCount) {
+    std::vector<double> y;
+    const Matrix X = makeLogisticData(20000, y);
+
+    const size_t previous = getNumThreads();
+
+    setNumThreads(1);
+    LogisticRegression serial(0.5, 50);
+    serial.fit(X, y);
+
+    setNumThreads(5);
+    LogisticRegression parallel(0.5, 50);
+    parallel.fit(X, y);
+
+    EXPECT_EQ(serial.getWeights(), parallel.getWeights());
+    EXPECT_EQ(serial.getLoss(), parallel.getLoss());
+
+    setNumThreads(previous);
+}
+
 // Test predict with invalid input size
 TEST_F(LogisticRegressionTest, PredictInvalidSize) {
     // Fit with valid 1D data
@@ -80,4 +147,274 @@ TEST_F(LogisticRegressionTest, SigmoidVector) {
     EXPECT_DOUBLE_EQ(result[0], 0.5);
     EXPECT_NEAR(result[1], 1.0, 1e-6);
     EXPECT_NEAR(result[2], 0.0, 1e-6);
-}
\ No newline at end of file
+}
+
+// Test single precision training and inference
+TEST(LogisticRegressionFloatTest, FitAndPredict2D) {
+    LogisticRegressionF lrf(0.01f, 1000);
+    MatrixF X({ {0,1}, {1,0}, {2,3}, {3,2}, {1,1}, {1,2}, {2,1} });
+    std::vector<float> y = { 1, 0, 1, 0, 0, 1, 0 };
+
+    lrf.fit(X, y);
+
+    EXPECT_EQ(lrf.predict({ 0,1 }), 1);
+    EXPECT_EQ(lrf.predict({ 1,0 }), 0);
+    EXPECT_EQ(lrf.predict({ 2,3 }), 1);
+    EXPECT_EQ(lrf.predict({ 3,2 }), 0);
+}
+
+// Test sparse input gives the same model as dense input
+TEST_F(LogisticRegressionTest, FitAndPredictSparse) {
+    Matrix X({ {0,1}, {1,0}, {2,3}, {3,2}, {1,1}, {1,2}, {2,1} });
+    std::vector<double> y = { 1, 0, 1, 0, 0, 1, 0 };
+    SparseMatrix sparse(X);
+
+    lr.fit(sparse, y);
+
+    EXPECT_EQ(lr.predict(sparse), (std::vector<int>{ 1, 0, 1, 0, 0, 1, 0 }));
+    EXPECT_EQ(lr.predict({ 1,2 }), 1);
+    EXPECT_THROW(lr.predict(SparseMatrix(Matrix(1, 3))), std::invalid_argument);
+
+    // Empty input is rejected
+    EXPECT_THROW(lr.fit(SparseMatrix(Matrix(0, 2)), std::vector<double>()), std::invalid_argument);
+}
+
+// Test a few epochs of the mini-batch solvers reach the accuracy of full-batch gradient descent
+TEST(LogisticRegressionSolverTest, MiniBatchMatchesGradientDescent) {
+    std::vector<double> y;
+    const Matrix X = makeLogisticData(4000, y);
+
+    LogisticRegression gd(0.5, 1000);
+    gd.fit(X, y);
+    const double reference = accuracy(gd, X, y);
+
+    LogisticRegression sgd(0.1, 5, LogisticSolver::SGD, 32);
+    sgd.fit(X, y);
+    EXPECT_GT(accuracy(sgd, X, y), reference - 0.02);
+
+    LogisticRegression adam(0.01, 5, LogisticSolver::Adam, 32);
+    adam.fit(X, y);
+    EXPECT_GT(accuracy(adam, X, y), reference - 0.02);
+
+    EXPECT_THROW(LogisticRegression(0.1, 5, LogisticSolver::SGD, 0), std::invalid_argument);
+
+    // Sparse input has no mini-batch path, rather than silently falling back to gradient descent
+    const SparseMatrix sparse(X);
+    EXPECT_THROW(sgd.fit(sparse, y), std::invalid_argument);
+    EXPECT_THROW(adam.fit(sparse, y), std::invalid_argument);
+}
+
+// Test partialFit keeps the optimizer state across calls
+TEST(LogisticRegressionSolverTest, PartialFit) {
+    std::vector<double> y;
+    const Matrix X = makeLogisticData(4000, y);
+
+    LogisticRegression gd(0.5, 1000);
+    gd.fit(X, y);
+
+    LogisticRegression adam(0.01, 1, LogisticSolver::Adam, 32);
+    for (size_t epoch = 0; epoch < 3; ++epoch) {
+        for (size_t first = 0; first < 4000; first += 1000) {
+            const MatrixView batch = MatrixView(X).rows(first, 1000);
+            adam.partialFit(batch, std::vector<double>(y.begin() + first, y.begin() + first + 1000));
+        }
+    }
+    EXPECT_GT(accuracy(adam, X, y), accuracy(gd, X, y) - 0.02);
+
+    EXPECT_THROW(adam.partialFit(Matrix(2, 3), { 0, 1 }), std::invalid_argument);
+    EXPECT_THROW(adam.partialFit(Matrix(2, 4), { 0 }), std::invalid_argument);
+
+    // The full-batch solvers have no mini-batch step, and the solver is not switched
+    EXPECT_THROW(gd.partialFit(Matrix(2, 4), { 0, 1 }), std::invalid_argument);
+}
+
+// Test streaming from files gives the same model as the same chunks read from memory
+TEST(LogisticRegressionSolverTest, FitFromSource) {
+    std::vector<double> y;
+    const Matrix X = makeLogisticData(3000, y);
+
+    const std::string base = (std::filesystem::temp_directory_path() / "ml_logistic_source").string();
+    writeDataset<double>(base + "_X.bin", X);
+    writeDataset<double>(base + "_y.bin", MatrixView(y.data(), y.size(), 1));
+
+    for (LogisticSolver solver : { LogisticSolver::SGD, LogisticSolver::Adam }) {
+        ViewSource viewX(X), viewY(MatrixView(y.data(), y.size(), 1));
+        LogisticRegression inMemory(0.05, 3, solver, 64);
+        inMemory.fit(viewX, viewY, 700);
+
+        FileSource fileX(base + "_X.bin"), fileY(base + "_y.bin");
+        LogisticRegression streamed(0.05, 3, solver, 64);
+        streamed.fit(fileX, fileY, 700);
+
+        for (size_t i = 0; i < 3000; i += 7) {
+            const auto row = X.row(i);
+            const std::vector<double> x(row.begin(), row.end());
+            EXPECT_EQ(streamed.predict(x), inMemory.predict(x));
+        }
+        EXPECT_GT(accuracy(streamed, X, y), 0.75);
+    }
+
+    ViewSource viewX(X), shortY(MatrixView(y.data(), 10, 1));
+    LogisticRegression sgd(0.05, 3, LogisticSolver::SGD);
+    EXPECT_THROW(sgd.fit(viewX, shortY), std::invalid_argument);
+
+    // Streaming needs a mini-batch solver, and rows
+    for (LogisticSolver solver : { LogisticSolver::GradientDescent, LogisticSolver::LBFGS, LogisticSolver::IRLS, LogisticSolver::Hogwild }) {
+        ViewSource features(X), labels(MatrixView(y.data(), y.size(), 1));
+        LogisticRegression model(0.05, 3, solver);
+        EXPECT_THROW(model.fit(features, labels), std::invalid_argument);
+    }
+    ViewSource noRows(MatrixView(X.data(), 0, 4)), noLabels(MatrixView(y.data(), 0, 1));
+    EXPECT_THROW(sgd.fit(noRows, noLabels), std::invalid_argument);
+
+    // One single-column source as both X and y would read labels over the features
+    {
+        FileSource labelsOnly(base + "_y.bin");
+        EXPECT_THROW(sgd.fit(labelsOnly, labelsOnly), std::invalid_argument);
+    }
+
+    std::filesystem::remove(base + "_X.bin");
+    std::filesystem::remove(base + "_y.bin");
+}
+
+// Test the second-order solvers converge in few iterations to the loss gradient descent approaches
+TEST(LogisticRegressionSolverTest, SecondOrderSolvers) {
+    std::vector<double> y;
+    const Matrix X = makeLogisticData(4000, y);
+
+    LogisticRegression gd(0.5, 1000);
+    gd.fit(X, y);
+    EXPECT_EQ(gd.getNumOfIterations(), 1000u);
+
+    LogisticRegression lbfgs(0.01, 1000, LogisticSolver::LBFGS);
+    lbfgs.fit(X, y);
+
+    LogisticRegression irls(0.01, 1000, LogisticSolver::IRLS);
+    irls.fit(X, y);
+
+    EXPECT_LT(lbfgs.getNumOfIterations(), 50u);
+    EXPECT_LT(irls.getNumOfIterations(), 15u);
+    EXPECT_LE(lbfgs.getLoss(), gd.getLoss() + 1e-6);
+    EXPECT_NEAR(irls.getLoss(), lbfgs.getLoss(), 1e-8);
+    EXPECT_NEAR(accuracy(irls, X, y), accuracy(lbfgs, X, y), 1e-3);
+
+    // A badly scaled column slows gradient descent down but not Newton's method
+    Matrix scaled = X;
+    for (size_t i = 0; i < scaled.getNumOfRows(); ++i)
+        scaled(i, 0) *= 1000.0;
+
+    LogisticRegression irlsScaled(0.01, 1000, LogisticSolver::IRLS);
+    irlsScaled.fit(scaled, y);
+    EXPECT_NEAR(irlsScaled.getLoss(), irls.getLoss(), 1e-8);
+
+    LogisticRegression lbfgsScaled(0.01, 1000, LogisticSolver::LBFGS);
+    lbfgsScaled.fit(scaled, y);
+    EXPECT_NEAR(lbfgsScaled.getLoss(), irls.getLoss(), 1e-5);
+
+    // Separable data ends the fit without error
+    LogisticRegression separable(0.01, 100, LogisticSolver::IRLS);
+    separable.fit(Matrix({ {-2}, {-1}, {1}, {2} }), { 0, 0, 1, 1 });
+    EXPECT_EQ(separable.predict({ -1.5 }), 0);
+    EXPECT_EQ(separable.predict({ 1.5 }), 1);
+
+    // Sparse input has no second-order path, rather than silently falling back to gradient descent
+    const SparseMatrix sparse(X);
+    EXPECT_THROW(lbfgs.fit(sparse, y), std::invalid_argument);
+    EXPECT_THROW(irls.fit(sparse, y), std::invalid_argument);
+}
+
+// Test Hogwild on sparse high-dimensional rows reaches the accuracy of gradient descent on all threads
+TEST(LogisticRegressionSolverTest, HogwildSparse) {
+    // Rows of 8 non-zeros out of 2000 columns, labels from a model over all columns
+    std::mt19937 gen(5);
+    std::uniform_int_distribution<size_t> column(0, 1999);
+    std::normal_distribution<double> normal(0.0, 1.0);
+    std::uniform_real_distribution<double> u(0.0, 1.0);
+
+    std::vector<double> w(2000);
+    for (double& v : w) v = 2.0 * normal(gen);
+
+    std::vector<size_t> rowPointers = { 0 }, columns;
+    std::vector<double> values, y;
+    for (size_t i = 0; i < 6000; ++i) {
+        double z = 0.0;
+        for (size_t k = 0; k < 8; ++k) {
+            columns.push_back(column(gen));
+            values.push_back(1.0);
+            z += w[columns.back()];
+        }
+        rowPointers.push_back(columns.size());
+        y.push_back(u(gen) < 1.0 / (1.0 + std::exp(-z)) ? 1.0 : 0.0);
+    }
+    const SparseMatrix X(6000, 2000, rowPointers, columns, values);
+
+    auto sparseAccuracy = [&](const LogisticRegression& model) {
+        const std::vector<int> predicted = model.predict(X);
+        size_t correct = 0;
+        for (size_t i = 0; i < y.size(); ++i) correct += predicted[i] == int(y[i]);
+        return double(correct) / double(y.size());
+    };
+
+    LogisticRegression gd(1.0, 1000);
+    gd.fit(X, y);
+    const double reference = sparseAccuracy(gd);
+
+    const size_t previous = getNumThreads();
+    setNumThreads(4);
+
+    LogisticRegression hogwild(0.2, 20, LogisticSolver::Hogwild);
+    hogwild.fit(X, y);
+    EXPECT_EQ(hogwild.getNumOfIterations(), 20u);
+    EXPECT_GT(sparseAccuracy(hogwild), reference - 0.02);
+
+    LogisticRegression averaged(0.2, 20, LogisticSolver::Hogwild, 256, 42, 1e-6, true);
+    averaged.fit(X, y);
+    EXPECT_GT(sparseAccuracy(averaged), reference - 0.02);
+
+    // A single thread gives the same model on every run
+    setNumThreads(1);
+    LogisticRegression first(0.2, 3, LogisticSolver::Hogwild), second(0.2, 3, LogisticSolver::Hogwild);
+    first.fit(X, y);
+    second.fit(X, y);
+    EXPECT_EQ(first.predict(X), second.predict(X));
+
+    setNumThreads(previous);
+}
+
+// Test Hogwild on dense rows
+TEST(LogisticRegressionSolverTest, HogwildDense) {
+    std::vector<double> y;
+    const Matrix X = makeLogisticData(4000, y);
+
+    LogisticRegression gd(0.5, 1000);
+    gd.fit(X, y);
+
+    LogisticRegression hogwild(0.01, 5, LogisticSolver::Hogwild, 256, 42, 1e-6, true);
+    hogwild.fit(X, y);
+    EXPECT_GT(accuracy(hogwild, X, y), accuracy(gd, X, y) - 0.02);
+}
+
+// Test batched probabilities agree with the scalar sigmoid and predict
+TEST(LogisticRegressionSolverTest, PredictBatch) {
+    std::vector<double> y;
+    const Matrix X = makeLogisticData(1003, y);
+    LogisticRegression model(0.5, 200);
+    model.fit(X, y);
+
+    std::vector<double> out(X.getNumOfRows());
+    model.predictBatch(X, out);
+    double loss = 0.0;
+    for (size_t i = 0; i < out.size(); ++i) {
+        loss -= std::log(y[i] == 1.0 ? out[i] : 1.0 - out[i]);
+
+        const auto row = X.row(i);
+        EXPECT_EQ(out[i] > 0.5 ? 1 : 0, model.predict(std::vector<double>(row.begin(), row.end())));
+    }
+
+    // The probabilities reproduce the cross-entropy of the fit
+    EXPECT_NEAR(loss / double(out.size()), model.getLoss(), 1e-12);
+
+    std::vector<double> small(3);
+    EXPECT_THROW(model.predictBatch(X, small), std::invalid_argument);
+    EXPECT_THROW(model.predictBatch(Matrix(3, 2), small), std::invalid_argument);
+}
@@ -1,4 +1,5 @@
 #include "matrix.h"
+#include <cstdint>
 #include <gtest/gtest.h>
 
 // Test matrix constructor
@@ -71,4 +72,112 @@ TEST(MatrixTest, Inverse)
     EXPECT_NEAR(inv(0, 1), -0.7, 1e-10);
     EXPECT_NEAR(inv(1, 0), -0.2, 1e-10);
     EXPECT_NEAR(inv(1, 1), 0.4, 1e-10);
-}
\ No newline at end of file
+}
+
+// Test rows are stored contiguously and exposed without copying
+TEST(MatrixTest, ContiguousStorage)
+{
+    Matrix m({ {1.0, 2.0, 3.0}, {4.0, 5.0, 6.0} });
+    EXPECT_EQ(m.getStride(), 3);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(m.data()) % 64, 0);  // Buffer is cache line aligned
+    EXPECT_EQ(m.row(1).data(), m.data() + 3);
+    EXPECT_DOUBLE_EQ(m.row(1)[2], 6.0);
+    EXPECT_THROW(Matrix({ {1.0, 2.0}, {3.0} }), std::invalid_argument);  // Ragged rows
+}
+
+// Test read-only views over a matrix
+TEST(MatrixTest, View)
+{
+    Matrix m({ {1.0, 2.0}, {3.0, 4.0}, {5.0, 6.0} });
+    MatrixView v = m;
+    EXPECT_EQ(v.data(), m.data());
+    EXPECT_EQ(v.getNumOfRows(), 3);
+    EXPECT_EQ(v.getNumOfCols(), 2);
+    EXPECT_DOUBLE_EQ(v(2, 1), 6.0);
+
+    ColumnView c = v.col(1);
+    EXPECT_EQ(c.size(), 3);
+    EXPECT_DOUBLE_EQ(c[0], 2.0);
+    EXPECT_DOUBLE_EQ(c[2], 6.0);
+
+    MatrixView tail = v.rows(1, 2);
+    EXPECT_EQ(tail.getNumOfRows(), 2);
+    EXPECT_DOUBLE_EQ(tail(0, 0), 3.0);
+    EXPECT_THROW(v.rows(2, 2), std::invalid_argument);
+
+    Matrix copy(tail);
+    EXPECT_NE(copy.data(), m.data() + 2);
+    EXPECT_DOUBLE_EQ(copy(1, 1), 6.0);
+}
+
+// Test views with a row stride wider than the number of columns
+TEST(MatrixTest, StridedView)
+{
+    // Use the first two columns of a 2x3 buffer
+    std::vector<double> buffer = { 1.0, 2.0, 0.0, 3.0, 4.0, 0.0 };
+    MatrixView v(buffer.data(), 2, 2, 3);
+    EXPECT_DOUBLE_EQ(v(1, 0), 3.0);
+    EXPECT_EQ(v.row(1).size(), 2);
+    EXPECT_THROW(MatrixView(buffer.data(), 2, 3, 2), std::invalid_argument);
+
+    Matrix m(v);
+    EXPECT_DOUBLE_EQ(m(1, 1), 4.0);
+}
+
+// Test transposed matrix-vector product and Gram matrix against an explicit transpose
+TEST(MatrixTest, TransposeTimesAndGram)
+{
+    Matrix m({ {1.0, 2.0}, {3.0, 4.0}, {5.0, 6.0} });
+    std::vector<double> v = { 1.0, -1.0, 2.0 };
+
+    std::vector<double> expected = m.transpose() * v;
+    std::vector<double> result = m.transposeTimes(v);
+    ASSERT_EQ(result.size(), 2);
+    EXPECT_DOUBLE_EQ(result[0], expected[0]);
+    EXPECT_DOUBLE_EQ(result[1], expected[1]);
+    EXPECT_THROW(m.transposeTimes({ 1.0, 2.0 }), std::invalid_argument);
+
+    Matrix g = m.gram();
+    Matrix gExpected = m.transpose() * m;
+    ASSERT_EQ(g.getNumOfRows(), 2);
+    ASSERT_EQ(g.getNumOfCols(), 2);
+    for (size_t i = 0; i < 2; ++i)
+        for (size_t j = 0; j < 2; ++j)
+            EXPECT_DOUBLE_EQ(g(i, j), gExpected(i, j));
+}
+
+// Test inverse needs pivoting when the leading element is zero, and rejects singular matrices
+TEST(MatrixTest, InversePivoting)
+{
+    Matrix m({ {0.0, 1.0}, {2.0, 3.0} });
+    Matrix inv = m.inverse();
+    EXPECT_NEAR(inv(0, 0), -1.5, 1e-12);
+    EXPECT_NEAR(inv(0, 1), 0.5, 1e-12);
+    EXPECT_NEAR(inv(1, 0), 1.0, 1e-12);
+    EXPECT_NEAR(inv(1, 1), 0.0, 1e-12);
+
+    EXPECT_THROW(Matrix({ {1.0, 2.0}, {2.0, 4.0} }).inverse(), std::invalid_argument);
+}
+
+// Test single precision matrices use the same operations
+TEST(MatrixTest, FloatMatrix)
+{
+    MatrixF m({ {1.0f, 2.0f, 3.0f}, {4.0f, 5.0f, 6.0f} });
+    MatrixViewF v = m;
+    EXPECT_FLOAT_EQ(v(1, 2), 6.0f);
+
+    MatrixF p = m * m.transpose();
+    EXPECT_FLOAT_EQ(p(0, 0), 14.0f);
+    EXPECT_FLOAT_EQ(p(0, 1), 32.0f);
+    EXPECT_FLOAT_EQ(p(1, 1), 77.0f);
+
+    MatrixF g = m.gram();
+    EXPECT_FLOAT_EQ(g(0, 2), 27.0f);
+    EXPECT_FLOAT_EQ(g(2, 0), 27.0f);
+
+    std::vector<float> r = m.transposeTimes({ 1.0f, 1.0f });
+    EXPECT_FLOAT_EQ(r[2], 9.0f);
+
+    MatrixF inv = MatrixF({ {4.0f, 7.0f}, {2.0f, 6.0f} }).inverse();
+    EXPECT_NEAR(inv(0, 1), -0.7f, 1e-6f);
+}
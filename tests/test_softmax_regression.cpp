@@ -0,0 +1,126 @@
+#include <gtest/gtest.h>
+#include "logistic_regression.h"
+#include "matrix.h"
+#include "softmax_regression.h"
+#include <cmath>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+    // Three well separated blobs in the plane
+    Matrix makeBlobs(size_t perClass, std::vector<size_t>& y) {
+        std::mt19937 gen(4);
+        std::normal_distribution<double> noise(0.0, 0.5);
+        const double centers[3][2] = { { 0.0, 3.0 }, { 3.0, -2.0 }, { -3.0, -2.0 } };
+
+        Matrix X(3 * perClass, 2);
+        y.clear();
+        for (size_t i = 0; i < 3 * perClass; ++i) {
+            X(i, 0) = centers[i % 3][0] + noise(gen);
+            X(i, 1) = centers[i % 3][1] + noise(gen);
+            y.push_back(i % 3);
+        }
+        return X;
+    }
+}
+
+// Test fit, predict and predictProba on three classes
+TEST(SoftmaxRegressionTest, FitAndPredictThreeClasses) {
+    std::vector<size_t> y;
+    const Matrix X = makeBlobs(500, y);
+
+    SoftmaxRegression model(0.1, 300);
+    model.fit(X, y);
+    EXPECT_EQ(model.getNumOfClasses(), 3u);
+    EXPECT_LT(model.getLoss(), 0.1);
+
+    const std::vector<size_t> predicted = model.predict(X);
+    size_t correct = 0;
+    for (size_t i = 0; i < y.size(); ++i) correct += predicted[i] == y[i];
+    EXPECT_GT(double(correct) / double(y.size()), 0.98);
+
+    const Matrix proba = model.predictProba(X);
+    ASSERT_EQ(proba.getNumOfRows(), X.getNumOfRows());
+    ASSERT_EQ(proba.getNumOfCols(), 3u);
+    for (size_t i = 0; i < proba.getNumOfRows(); ++i) {
+        EXPECT_NEAR(proba(i, 0) + proba(i, 1) + proba(i, 2), 1.0, 1e-12);
+        EXPECT_EQ(predicted[i], size_t(std::max_element(proba.row(i).begin(), proba.row(i).end()) - proba.row(i).begin()));
+    }
+
+    EXPECT_EQ(model.predict({ 0.0, 3.0 }), 0u);
+    EXPECT_EQ(model.predict({ 3.0, -2.0 }), 1u);
+    EXPECT_EQ(model.predict({ -3.0, -2.0 }), 2u);
+}
+
+// Test two classes follow the same descent as logistic regression at twice the learning rate
+TEST(SoftmaxRegressionTest, TwoClassesMatchLogisticRegression) {
+    std::mt19937 gen(2);
+    std::normal_distribution<double> noise(0.0, 1.0);
+
+    Matrix X(3000, 3);
+    std::vector<size_t> y(3000);
+    std::vector<double> yLogistic(3000);
+    for (size_t i = 0; i < 3000; ++i) {
+        for (size_t j = 0; j < 3; ++j) X(i, j) = noise(gen);
+        y[i] = X(i, 0) - X(i, 1) + noise(gen) > 0 ? 1 : 0;
+        yLogistic[i] = double(y[i]);
+    }
+
+    SoftmaxRegression softmax(0.05, 200);
+    softmax.fit(X, y);
+
+    LogisticRegression logistic(0.1, 200);
+    logistic.fit(X, yLogistic);
+
+    EXPECT_NEAR(softmax.getLoss(), logistic.getLoss(), 1e-10);
+    const Matrix proba = softmax.predictProba(X);
+    for (size_t i = 0; i < 3000; i += 11) {
+        const auto row = X.row(i);
+        EXPECT_EQ(int(proba(i, 1) > 0.5), logistic.predict(std::vector<double>(row.begin(), row.end())));
+    }
+}
+
+// Test very large scores give finite probabilities
+TEST(SoftmaxRegressionTest, StableForLargeScores) {
+    std::vector<size_t> y;
+    const Matrix X = makeBlobs(50, y);
+
+    SoftmaxRegression model(0.1, 100);
+    model.fit(X, y);
+
+    const Matrix proba = model.predictProba(Matrix({ { 1e6, -1e6 }, { -1e8, 1e8 } }));
+    for (size_t i = 0; i < 2; ++i) {
+        double sum = 0.0;
+        for (size_t c = 0; c < 3; ++c) {
+            EXPECT_TRUE(std::isfinite(proba(i, c)));
+            sum += proba(i, c);
+        }
+        EXPECT_NEAR(sum, 1.0, 1e-12);
+    }
+}
+
+// Test single precision and invalid input
+TEST(SoftmaxRegressionTest, FloatAndInvalidInput) {
+    std::vector<size_t> y;
+    const Matrix X = makeBlobs(100, y);
+
+    MatrixF XF(X.getNumOfRows(), 2);
+    for (size_t i = 0; i < X.getNumOfRows(); ++i) {
+        XF(i, 0) = float(X(i, 0));
+        XF(i, 1) = float(X(i, 1));
+    }
+
+    SoftmaxRegressionF modelF(0.1f, 200);
+    modelF.fit(XF, y);
+    EXPECT_EQ(modelF.predict({ 0.0f, 3.0f }), 0u);
+    EXPECT_EQ(modelF.predict({ -3.0f, -2.0f }), 2u);
+
+    SoftmaxRegression model;
+    EXPECT_THROW(model.predictProba(X), std::invalid_argument);
+    EXPECT_THROW(model.fit(X, std::vector<size_t>(10, 1)), std::invalid_argument);
+    EXPECT_THROW(model.fit(X, std::vector<size_t>(X.getNumOfRows(), 0)), std::invalid_argument);
+
+    model.fit(X, y);
+    EXPECT_THROW(model.predictProba(Matrix(2, 3)), std::invalid_argument);
+}
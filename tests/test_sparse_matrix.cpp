@@ -0,0 +1,95 @@
+#include "sparse_matrix.h"
+#include "matrix.h"
+#include <gtest/gtest.h>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+    // Random dense matrix with roughly the given fraction of non-zeros
+    Matrix randomSparse(size_t rows, size_t cols, double density, unsigned seed)
+    {
+        std::mt19937 gen(seed);
+        std::uniform_real_distribution<double> value(-1.0, 1.0);
+        std::bernoulli_distribution keep(density);
+
+        Matrix m(rows, cols);
+        for (size_t i = 0; i < rows; ++i)
+            for (size_t j = 0; j < cols; ++j)
+                if (keep(gen)) m(i, j) = value(gen);
+        return m;
+    }
+}
+
+// Test CSR arrays are built from a dense matrix and validated
+TEST(SparseMatrixTest, Construction)
+{
+    Matrix dense({ {1, 0, 2}, {0, 0, 0}, {0, 3, 0} });
+    SparseMatrix sparse(dense);
+
+    EXPECT_EQ(sparse.getNumOfRows(), 3);
+    EXPECT_EQ(sparse.getNumOfCols(), 3);
+    EXPECT_EQ(sparse.getNumOfNonZeros(), 3);
+    EXPECT_EQ(sparse.rowIndices(0).size(), 2);
+    EXPECT_EQ(sparse.rowIndices(1).size(), 0);
+    EXPECT_EQ(sparse.rowIndices(2)[0], 1);
+    EXPECT_DOUBLE_EQ(sparse.rowValues(2)[0], 3.0);
+
+    EXPECT_THROW(SparseMatrix(2, 2, { 0, 1 }, { 0 }, { 1.0 }), std::invalid_argument);
+    EXPECT_THROW(SparseMatrix(2, 2, { 0, 1, 1 }, { 2 }, { 1.0 }), std::invalid_argument);
+    EXPECT_THROW(SparseMatrix(2, 2, { 0, 2, 1 }, { 0 }, { 1.0 }), std::invalid_argument);
+}
+
+// Test the sparse products match the dense ones
+TEST(SparseMatrixTest, ProductsMatchDense)
+{
+    const Matrix dense = randomSparse(3000, 70, 0.05, 7);
+    const SparseMatrix sparse(dense);
+
+    std::vector<double> x(70), v(3000);
+    for (size_t j = 0; j < x.size(); ++j) x[j] = 0.1 * j - 2.0;
+    for (size_t i = 0; i < v.size(); ++i) v[i] = std::sin(0.01 * i);
+
+    const std::vector<double> ax = sparse * x, axDense = dense * x;
+    for (size_t i = 0; i < ax.size(); ++i) EXPECT_NEAR(ax[i], axDense[i], 1e-12);
+
+    const std::vector<double> atv = sparse.transposeTimes(v), atvDense = dense.transposeTimes(v);
+    for (size_t j = 0; j < atv.size(); ++j) EXPECT_NEAR(atv[j], atvDense[j], 1e-10);
+
+    const Matrix gram = sparse.gram(), gramDense = dense.gram();
+    for (size_t i = 0; i < 70; ++i)
+        for (size_t j = 0; j < 70; ++j)
+            EXPECT_NEAR(gram(i, j), gramDense(i, j), 1e-10);
+
+    const SparseMatrix t = sparse.transpose();
+    EXPECT_EQ(t.getNumOfRows(), 70);
+    EXPECT_EQ(t.getNumOfNonZeros(), sparse.getNumOfNonZeros());
+    const std::vector<double> tv = t * v;
+    for (size_t j = 0; j < tv.size(); ++j) EXPECT_NEAR(tv[j], atvDense[j], 1e-10);
+
+    EXPECT_THROW(sparse * v, std::invalid_argument);
+    EXPECT_THROW(sparse.transposeTimes(x), std::invalid_argument);
+}
+
+// Test transposed products stay correct as the reused partial sums change size
+TEST(SparseMatrixTest, RepeatedTransposedProducts)
+{
+    // Wide enough for a single block, then narrow enough for many
+    for (size_t cols : { 5000, 40, 300 })
+    {
+        const Matrix dense = randomSparse(2000, cols, 0.01, unsigned(cols));
+        const SparseMatrix sparse(dense), columns = sparse.transpose();
+
+        std::vector<double> v(2000);
+        for (size_t i = 0; i < v.size(); ++i) v[i] = std::cos(0.02 * i);
+
+        std::vector<double> y(cols, 1.0), expected(cols);
+        columns.multiply(Transpose::No, 2.0, v.data(), 0.0, expected.data());
+        for (double& e : expected) e += 0.5;
+
+        sparse.multiply(Transpose::Yes, 2.0, v.data(), 0.5, y.data());
+        for (size_t j = 0; j < cols; ++j) EXPECT_NEAR(y[j], expected[j], 1e-12);
+    }
+}
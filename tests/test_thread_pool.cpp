@@ -0,0 +1,112 @@
+#include "gemm.h"
+#include "matrix.h"
+#include "thread_pool.h"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+// Restores the library thread count when a test ends
+class ThreadPoolTest : public ::testing::Test
+{
+protected:
+    size_t previous = getNumThreads();
+    void TearDown() override { setNumThreads(previous); }
+};
+
+// Test every index is visited exactly once, in chunks of the given grain
+TEST_F(ThreadPoolTest, ParallelForCoversRange)
+{
+    setNumThreads(4);
+    EXPECT_EQ(getNumThreads(), 4);
+
+    std::vector<std::atomic<int>> visits(1003);
+    std::atomic<size_t> chunks{ 0 };
+    parallelFor(0, visits.size(), 10, [&](size_t begin, size_t end)
+    {
+        EXPECT_LE(end - begin, 10);
+        for (size_t i = begin; i < end; ++i) visits[i]++;
+        chunks++;
+    });
+
+    for (const auto& v : visits) EXPECT_EQ(v.load(), 1);
+    EXPECT_EQ(chunks.load(), 101);
+}
+
+// Test exceptions thrown by the body reach the caller
+TEST_F(ThreadPoolTest, PropagatesExceptions)
+{
+    setNumThreads(3);
+    EXPECT_THROW(parallelFor(0, 100, 1, [](size_t begin, size_t) {
+        if (begin == 42) throw std::runtime_error("failure");
+    }), std::runtime_error);
+
+    // The pool is still usable afterwards
+    std::atomic<size_t> sum{ 0 };
+    parallelFor(0, 100, 7, [&](size_t begin, size_t end) { sum += end - begin; });
+    EXPECT_EQ(sum.load(), 100);
+}
+
+// Test nested parallel loops run serially instead of deadlocking
+TEST_F(ThreadPoolTest, NestedParallelFor)
+{
+    setNumThreads(4);
+    std::atomic<size_t> count{ 0 };
+    parallelFor(0, 8, 1, [&](size_t, size_t)
+    {
+        parallelFor(0, 16, 2, [&](size_t begin, size_t end) { count += end - begin; });
+    });
+    EXPECT_EQ(count.load(), 8 * 16);
+}
+
+// Test resizing the pool while another thread submits work and reads the thread count
+TEST_F(ThreadPoolTest, SetNumThreadsWhileRunning)
+{
+    setNumThreads(2);
+    std::atomic<bool> done{ false };
+    std::thread resizer([&]
+    {
+        for (size_t i = 0; i < 50; ++i) setNumThreads(1 + i % 4);
+        done = true;
+    });
+
+    while (!done)
+    {
+        std::atomic<size_t> sum{ 0 };
+        parallelFor(0, 64, 1, [&](size_t begin, size_t end) { sum += end - begin; });
+        EXPECT_EQ(sum.load(), 64);
+
+        const size_t numThreads = getNumThreads();
+        EXPECT_GE(numThreads, 1);
+        EXPECT_LE(numThreads, 4);
+    }
+    resizer.join();
+}
+
+// Test parallel products give the same result as serial ones
+TEST_F(ThreadPoolTest, ProductsIndependentOfThreadCount)
+{
+    std::mt19937 gen(3);
+    std::uniform_real_distribution<double> dist(-1.0, 1.0);
+    Matrix a(300, 70), b(70, 90);
+    for (size_t i = 0; i < 300; ++i) for (size_t j = 0; j < 70; ++j) a(i, j) = dist(gen);
+    for (size_t i = 0; i < 70; ++i) for (size_t j = 0; j < 90; ++j) b(i, j) = dist(gen);
+    std::vector<double> v(70);
+    for (auto& x : v) x = dist(gen);
+
+    setNumThreads(1);
+    const Matrix serial = a * b;
+    const std::vector<double> serialVec = a * v;
+
+    setNumThreads(5);
+    const Matrix parallel = a * b;
+    const std::vector<double> parallelVec = a * v;
+
+    for (size_t i = 0; i < 300; ++i)
+    {
+        for (size_t j = 0; j < 90; ++j) ASSERT_EQ(serial(i, j), parallel(i, j));
+        ASSERT_EQ(serialVec[i], parallelVec[i]);
+    }
+}
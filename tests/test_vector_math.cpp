@@ -0,0 +1,105 @@
+#include <gtest/gtest.h>
+#include "vector_math.h"
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+// Test the exponential matches std::exp to a few ulp, for every tail length
+TEST(VectorMathTest, ExpMatchesStd)
+{
+    std::mt19937 gen(8);
+    std::uniform_real_distribution<double> dist(-700.0, 700.0);
+    std::uniform_real_distribution<float> distF(-85.0f, 85.0f);
+
+    for (size_t n : { 1u, 3u, 7u, 8u, 17u, 1000u })
+    {
+        std::vector<double> x(n), y(n);
+        std::vector<float> xF(n), yF(n);
+        for (size_t i = 0; i < n; ++i)
+        {
+            x[i] = dist(gen);
+            xF[i] = distF(gen);
+        }
+
+        vectorExp(x.data(), y.data(), n);
+        vectorExp(xF.data(), yF.data(), n);
+
+        for (size_t i = 0; i < n; ++i)
+        {
+            EXPECT_NEAR(y[i], std::exp(x[i]), 8e-16 * std::exp(x[i]));
+            EXPECT_NEAR(yF[i], std::exp(xF[i]), 3e-7f * std::exp(xF[i]));
+        }
+    }
+}
+
+// Test overflow, underflow, infinities and NaN, in place
+TEST(VectorMathTest, ExpLimits)
+{
+    const double inf = std::numeric_limits<double>::infinity();
+    std::vector<double> x = { 0.0, 1.0, -inf, inf, 710.0, 1e10, -746.0, -1e10, std::numeric_limits<double>::quiet_NaN() };
+    vectorExp(x.data(), x.data(), x.size());
+
+    EXPECT_EQ(x[0], 1.0);
+    EXPECT_DOUBLE_EQ(x[1], std::exp(1.0));
+    EXPECT_EQ(x[2], 0.0);
+    EXPECT_EQ(x[3], inf);
+    EXPECT_EQ(x[4], inf);
+    EXPECT_EQ(x[5], inf);
+    EXPECT_EQ(x[6], 0.0);
+    EXPECT_EQ(x[7], 0.0);
+    EXPECT_TRUE(std::isnan(x[8]));
+
+    // Gradual underflow to subnormals
+    double subnormal = -740.0, result;
+    vectorExp(&subnormal, &result, 1);
+    EXPECT_NEAR(result, std::exp(-740.0), 1e-3 * std::exp(-740.0));
+
+    const float infF = std::numeric_limits<float>::infinity();
+    std::vector<float> xF = { 0.0f, -infF, infF, 89.0f, -104.0f };
+    vectorExp(xF.data(), xF.data(), xF.size());
+
+    EXPECT_EQ(xF[0], 1.0f);
+    EXPECT_EQ(xF[1], 0.0f);
+    EXPECT_EQ(xF[2], infF);
+    EXPECT_EQ(xF[3], infF);
+    EXPECT_EQ(xF[4], 0.0f);
+}
+
+// Test the sigmoid against its scalar definition and at the limits
+TEST(VectorMathTest, Sigmoid)
+{
+    std::mt19937 gen(9);
+    std::uniform_real_distribution<double> dist(-40.0, 40.0);
+
+    std::vector<double> x(1001), y(1001);
+    std::vector<float> xF(1001), yF(1001);
+    for (size_t i = 0; i < x.size(); ++i)
+    {
+        x[i] = dist(gen);
+        xF[i] = float(x[i]);
+    }
+
+    vectorSigmoid(x.data(), y.data(), x.size());
+    vectorSigmoid(xF.data(), yF.data(), xF.size());
+
+    for (size_t i = 0; i < x.size(); ++i)
+    {
+        const double expected = 1.0 / (1.0 + std::exp(-x[i]));
+        EXPECT_NEAR(y[i], expected, 1e-15 * expected);
+
+        const float expectedF = 1.0f / (1.0f + std::exp(-xF[i]));
+        EXPECT_NEAR(yF[i], expectedF, 5e-7f * expectedF);
+    }
+
+    const double inf = std::numeric_limits<double>::infinity();
+    std::vector<double> limits = { 0.0, 800.0, -800.0, inf, -inf, std::numeric_limits<double>::quiet_NaN() };
+    vectorSigmoid(limits.data(), limits.data(), limits.size());
+
+    EXPECT_EQ(limits[0], 0.5);
+    EXPECT_EQ(limits[1], 1.0);
+    EXPECT_EQ(limits[2], 0.0);
+    EXPECT_EQ(limits[3], 1.0);
+    EXPECT_EQ(limits[4], 0.0);
+    EXPECT_TRUE(std::isnan(limits[5]));
+}
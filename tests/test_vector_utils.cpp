@@ -0,0 +1,51 @@
+#include "vector_utils.h"
+#include <gtest/gtest.h>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+// Test a chained expression evaluates to the same values as step by step
+TEST(VectorUtilsTest, ChainedExpression)
+{
+    const std::vector<double> a = { 1.0, 2.0, 3.0 };
+    const std::vector<double> b = { 4.0, 5.0, 6.0 };
+
+    const std::vector<double> result = (a + b) * 2.0 - b / 2;
+
+    ASSERT_EQ(result.size(), 3);
+    EXPECT_DOUBLE_EQ(result[0], 8.0);
+    EXPECT_DOUBLE_EQ(result[1], 11.5);
+    EXPECT_DOUBLE_EQ(result[2], 15.0);
+}
+
+// Test in-place updates where the destination is also an operand
+TEST(VectorUtilsTest, InPlaceAliasing)
+{
+    std::vector<double> w = { 1.0, 2.0, 4.0 };
+    const std::vector<double> g = { 1.0, 1.0, 1.0 };
+
+    w -= 0.5 * (w + g);
+    EXPECT_EQ(w, (std::vector<double>{ 0.0, 0.5, 1.5 }));
+
+    evaluateInto(w, w * 2.0 + g);
+    EXPECT_EQ(w, (std::vector<double>{ 1.0, 2.0, 4.0 }));
+
+    const double row[] = { 1.0, 1.0, 1.0 };
+    w += std::span<const double>(row);
+    EXPECT_EQ(w, (std::vector<double>{ 2.0, 3.0, 5.0 }));
+}
+
+// Test the checks are made when the expression is built
+TEST(VectorUtilsTest, InvalidOperands)
+{
+    std::vector<double> a = { 1.0, 2.0 };
+    const std::vector<double> b = { 1.0, 2.0, 3.0 };
+    const std::vector<double> empty;
+
+    EXPECT_THROW(a + b, std::invalid_argument);
+    EXPECT_THROW(a - b, std::invalid_argument);
+    EXPECT_THROW(a -= b, std::invalid_argument);
+    EXPECT_THROW(a / 0, std::invalid_argument);
+    EXPECT_THROW(empty / 2, std::invalid_argument);
+    EXPECT_THROW(empty * 2.0, std::invalid_argument);
+}